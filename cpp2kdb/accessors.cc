@@ -8,10 +8,15 @@
 
 namespace cpp2kdb::accessors {
 namespace {
-/// Copy Symbol List to std::string.
+/// Size of the header of a K object: m, a, t, u, r and then n for vectors,
+/// which is where the value of an atom is kept.
+constexpr std::size_t object_header_size = 16;
+
+/// Copy Symbol List to std::string or std::string_view.
 ///
+template <typename OutputString>
 DataRetrievalResult CopySymbolListToString(void* input_vector,
-                                           std::string* output_vector) {
+                                           OutputString* output_vector) {
   // Data is just an array of pointers to \0 terminated strings.
   char** symbols = GetVector<char*>(input_vector);
 
@@ -19,14 +24,15 @@ DataRetrievalResult CopySymbolListToString(void* input_vector,
       kdb_wrapper::GetNumberOfVectorElements(input_vector);
   // Copy them over.
   for (std::size_t i = 0; i < number_of_elements; i++) {
-    *(output_vector + i) = std::string(symbols[i]);
+    *(output_vector + i) = OutputString(symbols[i]);
   }
 
   return DataRetrievalResult::Ok;
 }
 
+template <typename OutputString>
 DataRetrievalResult CopyMixedVectorAsString(void* input_vector,
-                                            std::string* output_vector) {
+                                            OutputString* output_vector) {
   // Get thet list of Ks
   void** charlistlist = GetVector<void*>(input_vector);
 
@@ -45,10 +51,39 @@ DataRetrievalResult CopyMixedVectorAsString(void* input_vector,
       break;
     }
     // Construct the string. Note the string is **NOT** \0 terminated.
-    *(output_vector + i) = GetStringFromCharVector(this_k);
+    *(output_vector + i) =
+        OutputString(GetVector<char>(this_k),
+                     kdb_wrapper::GetNumberOfVectorElements(this_k));
   }
   return result;
 }
+
+/// Retrieve symbols or char vectors into std::string or std::string_view.
+template <typename OutputString>
+DataRetrievalResult RetrieveStringVectorData(void* input_vector,
+                                             OutputString* output_vector) {
+  kdb_wrapper::CallHooksGuard hooks_guard(kdb_wrapper::CallKind::Conversion,
+                                          "RetrieveVectorData", 0, nullptr,
+                                          input_vector);
+  DataRetrievalResult check_result =
+      CheckVectorForVectorDataRetrieval(input_vector);
+  if (check_result != DataRetrievalResult::Ok) {
+    return check_result;
+  }
+  // Get the q type id
+  int q_type_id = kdb_wrapper::GetQTypeId(input_vector);
+  // If this is a mixed vector, go through each element to make sure it's char
+  // vector.
+  if (q_types::IsQTypeIdMixedVector(q_type_id)) {
+    return CopyMixedVectorAsString(input_vector, output_vector);
+  } else if (q_type_id == q_types::q_symbol_type_id) {
+    // Symbol vector.
+    return CopySymbolListToString(input_vector, output_vector);
+  } else {
+    // Not a string...
+    return DataRetrievalResult::NotStringVector;
+  }
+}
 }  // namespace
 bool IsError(void* x) {
   return kdb_wrapper::GetQTypeId(x) == q_types::q_error_type_id;
@@ -114,28 +149,19 @@ std::string GetStringFromCharVector(void* input_char_vector) {
 
 DataRetrievalResult RetrieveVectorData(void* input_vector,
                                        std::string* output_vector) {
-  DataRetrievalResult check_result =
-      CheckVectorForVectorDataRetrieval(input_vector);
-  if (check_result != DataRetrievalResult::Ok) {
-    return check_result;
-  }
-  // Get the q type id
-  int q_type_id = kdb_wrapper::GetQTypeId(input_vector);
-  // If this is a mixed vector, go through each element to make sure it's char
-  // vector.
-  if (q_types::IsQTypeIdMixedVector(q_type_id)) {
-    return CopyMixedVectorAsString(input_vector, output_vector);
-  } else if (q_type_id == q_types::q_symbol_type_id) {
-    // Symbol vector.
-    return CopySymbolListToString(input_vector, output_vector);
-  } else {
-    // Not a string...
-    return DataRetrievalResult::NotStringVector;
-  }
+  return RetrieveStringVectorData(input_vector, output_vector);
+}
+
+DataRetrievalResult RetrieveVectorData(void* input_vector,
+                                       std::string_view* output_vector) {
+  return RetrieveStringVectorData(input_vector, output_vector);
 }
 
 DataRetrievalResult RetrieveVectorData(void* input_vector,
                                        void** output_vector) {
+  kdb_wrapper::CallHooksGuard hooks_guard(kdb_wrapper::CallKind::Conversion,
+                                          "RetrieveVectorData", 0, nullptr,
+                                          input_vector);
   DataRetrievalResult check_result =
       CheckVectorForVectorDataRetrieval(input_vector);
   if (check_result != DataRetrievalResult::Ok) {
@@ -156,6 +182,9 @@ DataRetrievalResult RetrieveVectorData(void* input_vector,
 
 DataRetrievalResult RetrieveVectorData(void* input_vector,
                                        q_types::QGuid* output_vector) {
+  kdb_wrapper::CallHooksGuard hooks_guard(kdb_wrapper::CallKind::Conversion,
+                                          "RetrieveVectorData", 0, nullptr,
+                                          input_vector);
   DataRetrievalResult check_result =
       CheckVectorForVectorDataRetrieval(input_vector);
   if (check_result != DataRetrievalResult::Ok) {
@@ -177,6 +206,9 @@ DataRetrievalResult GetSimpleTable(void* simple_table, void** column_heading,
                                    void*** values,
                                    std::size_t* number_of_columns,
                                    std::size_t* number_of_rows) {
+  kdb_wrapper::CallHooksGuard hooks_guard(kdb_wrapper::CallKind::Conversion,
+                                          "GetSimpleTable", 0, nullptr,
+                                          simple_table);
   // Underlying dictionary.
   void* underlying_dict = GetValue<void*>(simple_table);
 
@@ -200,4 +232,32 @@ DataRetrievalResult GetSimpleTable(void* simple_table, void** column_heading,
 
   return DataRetrievalResult::Ok;
 }
+
+std::size_t EstimateObjectSize(void* x) {
+  if (x == nullptr) {
+    return 0;
+  }
+  int q_type_id = kdb_wrapper::GetQTypeId(x);
+  if (q_type_id == q_types::q_table_type_id) {
+    // Table is an atom holding the dictionary.
+    return object_header_size + EstimateObjectSize(GetValue<void*>(x));
+  }
+  if (q_type_id == q_types::q_dict_type_id ||
+      q_types::IsQTypeIdMixedVector(q_type_id)) {
+    // Both are lists of K, a dictionary has the keys and the values.
+    std::size_t number_of_elements = kdb_wrapper::GetNumberOfVectorElements(x);
+    void** elements = GetVector<void*>(x);
+    std::size_t size = object_header_size + number_of_elements * sizeof(void*);
+    for (std::size_t i = 0; i < number_of_elements; i++) {
+      size += EstimateObjectSize(elements[i]);
+    }
+    return size;
+  }
+  if (q_types::IsQTypeIdVector(q_type_id)) {
+    return object_header_size + kdb_wrapper::GetNumberOfVectorElements(x) *
+                                    q_types::GetElementSizeOfQTypeId(q_type_id);
+  }
+  // Atoms, errors and functions.
+  return object_header_size;
+}
 }  // namespace cpp2kdb::accessors
@@ -9,6 +9,7 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // Including the wrapper
@@ -114,7 +115,9 @@ enum class DataRetrievalResult {
   /// Not simple type (type is not 98)
   NotSimpleTable,
   /// Not a guid vector (type is 1)
-  NotGuidVector
+  NotGuidVector,
+  /// No column of that name in the table.
+  ColumnNotFound
 };
 
 /// Names for the enums....
@@ -133,7 +136,8 @@ constexpr const char* DataRetrievalResultNames[] = {
     "NotStringVector",
     "NotCharVectorInMixedVector",
     "NotSimpleTable",
-    "NotGuidVector"};
+    "NotGuidVector",
+    "ColumnNotFound"};
 
 /// Number of data retrieval result names
 constexpr const int number_of_data_retrieval_result_names =
@@ -169,6 +173,17 @@ DataRetrievalResult RetrieveVectorData(
     /// [out] output location.
     std::string* output_vector);
 
+/// Specialization for type std::string_view of Retrieving Data into Vector.
+/// Same as std::string, but nothing is copied. Symbols are interned by kdb and
+/// never freed, so the views of a symbol vector stay valid after the input is
+/// released. The views of a mixed list point into its char vectors, and are
+/// only valid as long as the input is.
+DataRetrievalResult RetrieveVectorData(
+    /// [in] input vector.
+    void* input_vector,
+    /// [out] output location.
+    std::string_view* output_vector);
+
 /// Specialization for type void** of Retrieving Data into Vector.
 /// This is for mixed type vector (so the q type id should be 0).
 DataRetrievalResult RetrieveVectorData(
@@ -195,6 +210,10 @@ DataRetrievalResult RetrieveVectorData(
     void* input_vector,
     /// [out] output location.
     T* output_vector) {
+  // Report to the call hooks, if any.
+  kdb_wrapper::CallHooksGuard hooks_guard(kdb_wrapper::CallKind::Conversion,
+                                          "RetrieveVectorData", 0, nullptr,
+                                          input_vector);
   // Check the vector first.
   DataRetrievalResult check_vector_result =
       CheckVectorForVectorDataRetrieval(input_vector);
@@ -236,6 +255,16 @@ DataRetrievalResult GetSimpleTable(
     std::size_t* number_of_columns,
     /// [out] Will be set to number of rows.
     std::size_t* number_of_rows);
+
+/// Estimate the memory held by a K object in bytes.
+///
+/// This adds up the header and the data of x and all the objects nested in it:
+/// the elements of a mixed list, the keys and values of a dictionary and the
+/// dictionary of a table. A symbol counts as a pointer only, since the string
+/// is interned and shared. The rounding up done by kdb's allocator is not
+/// counted, and an object referenced twice is counted twice.
+/// \returns 0 for nullptr.
+std::size_t EstimateObjectSize(void* x);
 }  // namespace accessors
 }  // namespace cpp2kdb
 #endif  // CPP2KDB_ACCESSORS_H__
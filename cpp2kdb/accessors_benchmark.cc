@@ -0,0 +1,460 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+#include "cpp2kdb/string_column.h"
+#include "cpp2kdb/struct_mapping.h"
+#include "cpp2kdb/symbol_table.h"
+#include "cpp2kdb/table.h"
+#include "cpp2kdb/vector_view.h"
+
+// Objects are built in process with ktn, kp and xT, no connection is needed.
+namespace {
+/// Largest vector, 100M elements.
+constexpr std::int64_t max_number_of_elements = 100000000;
+
+/// Largest vector of strings or atoms, which take much more memory per
+/// element.
+constexpr std::int64_t max_number_of_objects = 10000000;
+
+/// Create a vector of T with n elements, set to i mod 100.
+template <typename T>
+void* MakeVector(std::int64_t n) {
+  void* vector = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_type_id<T>, n);
+  T* data = cpp2kdb::accessors::GetVector<T>(vector);
+  for (std::int64_t i = 0; i < n; i++) {
+    data[i] = static_cast<T>(i % 100);
+  }
+  return vector;
+}
+
+/// Create a symbol vector of n elements, cycling through 100 symbols.
+void* MakeSymbolVector(std::int64_t n) {
+  std::vector<char*> symbols;
+  for (int i = 0; i < 100; i++) {
+    std::string name = "sym" + std::to_string(i);
+    symbols.push_back(cpp2kdb::kdb_wrapper::InternSymbol(name.c_str()));
+  }
+  void* vector = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_symbol_type_id, n);
+  char** data = cpp2kdb::accessors::GetVector<char*>(vector);
+  for (std::int64_t i = 0; i < n; i++) {
+    data[i] = symbols[i % 100];
+  }
+  return vector;
+}
+
+/// Create a mixed list of n char vectors of 1 to 16 chars.
+void* MakeCharVectorList(std::int64_t n) {
+  void* list =
+      cpp2kdb::kdb_wrapper::CreateVector(cpp2kdb::q_types::q_mixed_type_id, n);
+  void** data = cpp2kdb::accessors::GetVector<void*>(list);
+  for (std::int64_t i = 0; i < n; i++) {
+    std::string text(1 + i % 16, static_cast<char>('a' + i % 26));
+    data[i] = cpp2kdb::kdb_wrapper::CreateCharVector(text.c_str());
+  }
+  return list;
+}
+
+/// Create a mixed list of n long atoms.
+void* MakeAtomList(std::int64_t n) {
+  void* list =
+      cpp2kdb::kdb_wrapper::CreateVector(cpp2kdb::q_types::q_mixed_type_id, n);
+  void** data = cpp2kdb::accessors::GetVector<void*>(list);
+  for (std::int64_t i = 0; i < n; i++) {
+    data[i] = cpp2kdb::kdb_wrapper::CreateLong(i);
+  }
+  return list;
+}
+
+/// Create a table of n rows with a long, a float and a symbol column.
+void* MakeTable(std::int64_t n) {
+  const char* names[] = {"J", "F", "S"};
+  void* heading = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_symbol_type_id, 3);
+  for (int i = 0; i < 3; i++) {
+    cpp2kdb::accessors::GetVector<char*>(heading)[i] =
+        cpp2kdb::kdb_wrapper::InternSymbol(names[i]);
+  }
+  void* columns =
+      cpp2kdb::kdb_wrapper::CreateVector(cpp2kdb::q_types::q_mixed_type_id, 3);
+  void** column_list = cpp2kdb::accessors::GetVector<void*>(columns);
+  column_list[0] = MakeVector<std::int64_t>(n);
+  column_list[1] = MakeVector<double>(n);
+  column_list[2] = MakeSymbolVector(n);
+  return cpp2kdb::kdb_wrapper::CreateTable(
+      cpp2kdb::kdb_wrapper::CreateDict(heading, columns));
+}
+
+/// Create a table of 10 rows with n long columns, named c0, c1 and so on.
+void* MakeWideTable(std::int64_t n, std::vector<std::string>* names) {
+  void* heading = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_symbol_type_id, n);
+  void* columns =
+      cpp2kdb::kdb_wrapper::CreateVector(cpp2kdb::q_types::q_mixed_type_id, n);
+  names->clear();
+  for (std::int64_t i = 0; i < n; i++) {
+    names->push_back("c" + std::to_string(i));
+    cpp2kdb::accessors::GetVector<char*>(heading)[i] =
+        cpp2kdb::kdb_wrapper::InternSymbol(names->back().c_str());
+    cpp2kdb::accessors::GetVector<void*>(columns)[i] =
+        MakeVector<std::int64_t>(10);
+  }
+  return cpp2kdb::kdb_wrapper::CreateTable(
+      cpp2kdb::kdb_wrapper::CreateDict(heading, columns));
+}
+
+/// Retrieve a vector of T into a preallocated std::vector<T>.
+template <typename T>
+void BM_RetrieveVectorData(benchmark::State& state) {
+  void* vector = MakeVector<T>(state.range(0));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(vector);
+  // Not std::vector, which has no data() for bool.
+  std::unique_ptr<T[]> output(new T[state.range(0)]);
+  for (auto _ : state) {
+    cpp2kdb::accessors::RetrieveVectorData(vector, output.get());
+    benchmark::DoNotOptimize(output.get());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(T));
+}
+BENCHMARK_TEMPLATE(BM_RetrieveVectorData, bool)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_elements);
+BENCHMARK_TEMPLATE(BM_RetrieveVectorData, std::int8_t)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_elements);
+BENCHMARK_TEMPLATE(BM_RetrieveVectorData, short)  // NOLINT
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_elements);
+BENCHMARK_TEMPLATE(BM_RetrieveVectorData, int)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_elements);
+BENCHMARK_TEMPLATE(BM_RetrieveVectorData, std::int64_t)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_elements);
+BENCHMARK_TEMPLATE(BM_RetrieveVectorData, float)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_elements);
+BENCHMARK_TEMPLATE(BM_RetrieveVectorData, double)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_elements);
+BENCHMARK_TEMPLATE(BM_RetrieveVectorData, char)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_elements);
+
+/// Retrieve a long vector converted to double.
+void BM_RetrieveVectorDataConverted(benchmark::State& state) {
+  void* vector = MakeVector<std::int64_t>(state.range(0));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(vector);
+  std::vector<double> output(state.range(0));
+  for (auto _ : state) {
+    cpp2kdb::accessors::RetrieveVectorData(vector, output.data());
+    benchmark::DoNotOptimize(output.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * state.range(0) *
+                          sizeof(std::int64_t));
+}
+BENCHMARK(BM_RetrieveVectorDataConverted)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_elements);
+
+/// Sum a long vector after copying it out with RetrieveVectorData.
+void BM_SumAfterRetrieveVectorData(benchmark::State& state) {
+  void* vector = MakeVector<std::int64_t>(state.range(0));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(vector);
+  for (auto _ : state) {
+    std::vector<std::int64_t> output(state.range(0));
+    cpp2kdb::accessors::RetrieveVectorData(vector, output.data());
+    benchmark::DoNotOptimize(
+        std::accumulate(output.begin(), output.end(), std::int64_t{0}));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SumAfterRetrieveVectorData)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_elements);
+
+/// Sum a long vector in place through a KVectorView.
+void BM_SumWithKVectorView(benchmark::State& state) {
+  void* vector = MakeVector<std::int64_t>(state.range(0));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(vector);
+  for (auto _ : state) {
+    cpp2kdb::vector_view::KVectorView<std::int64_t> view;
+    cpp2kdb::vector_view::MakeKVectorView(vector, &view);
+    benchmark::DoNotOptimize(
+        std::accumulate(view.begin(), view.end(), std::int64_t{0}));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SumWithKVectorView)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_elements);
+
+/// Retrieve a symbol vector into std::string.
+void BM_RetrieveSymbolVector(benchmark::State& state) {
+  void* vector = MakeSymbolVector(state.range(0));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(vector);
+  std::vector<std::string> output(state.range(0));
+  for (auto _ : state) {
+    cpp2kdb::accessors::RetrieveVectorData(vector, output.data());
+    benchmark::DoNotOptimize(output.data());
+    benchmark::ClobberMemory();
+  }
+  std::int64_t number_of_chars = 0;
+  for (const std::string& text : output) {
+    number_of_chars += text.size();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * number_of_chars);
+}
+BENCHMARK(BM_RetrieveSymbolVector)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_objects);
+
+/// Retrieve a symbol vector into std::string_view.
+void BM_RetrieveSymbolVectorAsStringView(benchmark::State& state) {
+  void* vector = MakeSymbolVector(state.range(0));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(vector);
+  std::vector<std::string_view> output(state.range(0));
+  for (auto _ : state) {
+    cpp2kdb::accessors::RetrieveVectorData(vector, output.data());
+    benchmark::DoNotOptimize(output.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RetrieveSymbolVectorAsStringView)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_objects);
+
+/// Encode a symbol vector into codes with a SymbolTable.
+void BM_EncodeSymbolVector(benchmark::State& state) {
+  void* vector = MakeSymbolVector(state.range(0));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(vector);
+  std::vector<std::int32_t> output(state.range(0));
+  cpp2kdb::symbol_table::SymbolTable table;
+  for (auto _ : state) {
+    table.Encode(vector, output.data());
+    benchmark::DoNotOptimize(output.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EncodeSymbolVector)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_objects);
+
+/// Retrieve a mixed list of char vectors into std::string.
+void BM_RetrieveCharVectorList(benchmark::State& state) {
+  void* list = MakeCharVectorList(state.range(0));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(list);
+  std::vector<std::string> output(state.range(0));
+  for (auto _ : state) {
+    cpp2kdb::accessors::RetrieveVectorData(list, output.data());
+    benchmark::DoNotOptimize(output.data());
+    benchmark::ClobberMemory();
+  }
+  std::int64_t number_of_chars = 0;
+  for (const std::string& text : output) {
+    number_of_chars += text.size();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * number_of_chars);
+}
+BENCHMARK(BM_RetrieveCharVectorList)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_objects);
+
+/// Retrieve a mixed list of char vectors into one StringColumn, reused
+/// between iterations.
+void BM_RetrieveCharVectorListAsStringColumn(benchmark::State& state) {
+  void* list = MakeCharVectorList(state.range(0));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(list);
+  cpp2kdb::string_column::StringColumn output;
+  for (auto _ : state) {
+    cpp2kdb::string_column::RetrieveStringColumn(list, &output);
+    benchmark::DoNotOptimize(output.data.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * output.data.size());
+}
+BENCHMARK(BM_RetrieveCharVectorListAsStringColumn)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_objects);
+
+/// Get every atom of a mixed list of long atoms as T.
+template <typename T>
+void BM_GetValue(benchmark::State& state) {
+  void* list = MakeAtomList(state.range(0));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(list);
+  void** atoms = cpp2kdb::accessors::GetVector<void*>(list);
+  for (auto _ : state) {
+    T sum = 0;
+    for (std::int64_t i = 0; i < state.range(0); i++) {
+      sum += cpp2kdb::accessors::GetValue<T>(atoms[i]);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(T));
+}
+BENCHMARK_TEMPLATE(BM_GetValue, std::int64_t)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_objects);
+BENCHMARK_TEMPLATE(BM_GetValue, double)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_objects);
+
+/// Get the columns of a table, which doesn't depend on the number of rows.
+void BM_GetSimpleTable(benchmark::State& state) {
+  void* table = MakeTable(state.range(0));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(table);
+  for (auto _ : state) {
+    void* column_heading;
+    void** values;
+    std::size_t number_of_columns, number_of_rows;
+    cpp2kdb::accessors::GetSimpleTable(table, &column_heading, &values,
+                                       &number_of_columns, &number_of_rows);
+    benchmark::DoNotOptimize(values);
+    benchmark::DoNotOptimize(number_of_rows);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetSimpleTable)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_elements);
+
+/// Get the columns of a table and retrieve the numerical ones.
+void BM_GetSimpleTableAndRetrieve(benchmark::State& state) {
+  void* table = MakeTable(state.range(0));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(table);
+  std::vector<std::int64_t> j_column(state.range(0));
+  std::vector<double> f_column(state.range(0));
+  for (auto _ : state) {
+    void* column_heading;
+    void** values;
+    std::size_t number_of_columns, number_of_rows;
+    cpp2kdb::accessors::GetSimpleTable(table, &column_heading, &values,
+                                       &number_of_columns, &number_of_rows);
+    cpp2kdb::accessors::RetrieveVectorData(values[0], j_column.data());
+    cpp2kdb::accessors::RetrieveVectorData(values[1], f_column.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * state.range(0) *
+                          (sizeof(std::int64_t) + sizeof(double)));
+}
+BENCHMARK(BM_GetSimpleTableAndRetrieve)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_elements);
+
+/// Row of the table built by MakeTable.
+struct Row {
+  std::int64_t j;
+  double f;
+  std::string_view s;
+};
+
+/// Decoder of the table built by MakeTable.
+constexpr auto row_decoder = cpp2kdb::struct_mapping::MakeStructDecoder(
+    cpp2kdb::struct_mapping::MakeField("J", &Row::j),
+    cpp2kdb::struct_mapping::MakeField("F", &Row::f),
+    cpp2kdb::struct_mapping::MakeField("S", &Row::s));
+
+/// Decode a table into a std::vector of structs.
+void BM_DecodeRows(benchmark::State& state) {
+  void* table_object = MakeTable(state.range(0));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(table_object);
+  cpp2kdb::table::Table table;
+  cpp2kdb::table::MakeTable(table_object, &table);
+  std::vector<Row> rows;
+  for (auto _ : state) {
+    row_decoder.Decode(table, &rows);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(Row));
+}
+BENCHMARK(BM_DecodeRows)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_objects);
+
+/// Decode a table into a std::vector per field.
+void BM_DecodeColumns(benchmark::State& state) {
+  void* table_object = MakeTable(state.range(0));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(table_object);
+  cpp2kdb::table::Table table;
+  cpp2kdb::table::MakeTable(table_object, &table);
+  decltype(row_decoder)::Columns columns;
+  for (auto _ : state) {
+    row_decoder.Decode(table, &columns);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(Row));
+}
+BENCHMARK(BM_DecodeColumns)
+    ->RangeMultiplier(10)
+    ->Range(1, max_number_of_objects);
+
+/// Look up every column of a table by name, scanning the heading.
+void BM_FindColumnByScanning(benchmark::State& state) {
+  std::vector<std::string> names;
+  void* table = MakeWideTable(state.range(0), &names);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(table);
+  void* column_heading;
+  void** values;
+  std::size_t number_of_columns, number_of_rows;
+  cpp2kdb::accessors::GetSimpleTable(table, &column_heading, &values,
+                                     &number_of_columns, &number_of_rows);
+  char** heading = cpp2kdb::accessors::GetVector<char*>(column_heading);
+  for (auto _ : state) {
+    for (const std::string& name : names) {
+      std::size_t i = 0;
+      while (i < number_of_columns && name != heading[i]) {
+        i++;
+      }
+      benchmark::DoNotOptimize(values[i]);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FindColumnByScanning)->RangeMultiplier(4)->Range(4, 1024);
+
+/// Look up every column of a table by name with Table.
+void BM_FindColumnWithTable(benchmark::State& state) {
+  std::vector<std::string> names;
+  void* table_object = MakeWideTable(state.range(0), &names);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(table_object);
+  cpp2kdb::table::Table table;
+  cpp2kdb::table::MakeTable(table_object, &table);
+  for (auto _ : state) {
+    for (const std::string& name : names) {
+      std::size_t i;
+      table.GetColumnIndex(name, &i);
+      benchmark::DoNotOptimize(table.GetColumnObject(i));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FindColumnWithTable)->RangeMultiplier(4)->Range(4, 1024);
+}  // namespace
+
+BENCHMARK_MAIN();
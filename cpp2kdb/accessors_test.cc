@@ -304,6 +304,23 @@ void TestKeyedTable(int connection) {
 
   return;
 }
+
+void TestEstimateObjectSize(int connection) {
+  const char* queries[] = {"42", "til 10", "`a`b`c", "(1;\"ab\";`c)",
+                           "`a`b!1 2", "([]a:til 3;b:`x`y`z)"};
+  for (const char* query : queries) {
+    void* result =
+        cpp2kdb::kdb_wrapper::RunQueryOnConnection(connection, query);
+    if (result == nullptr) {
+      std::cout << "Result is nullptr" << std::endl;
+      return;
+    }
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(result);
+    std::cout << "Estimated size of " << query << " is "
+              << cpp2kdb::accessors::EstimateObjectSize(result) << " bytes"
+              << std::endl;
+  }
+}
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -326,6 +343,8 @@ int main(int argc, char** argv) {
   TestTable(connection);
   std::cout << "----------------------" << std::endl;
   TestKeyedTable(connection);
+  std::cout << "----------------------" << std::endl;
+  TestEstimateObjectSize(connection);
   cpp2kdb::kdb_wrapper::CloseConnection(connection);
   return 0;
 }
@@ -0,0 +1,397 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/arrow_export.h"
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "cpp2kdb/kdb_wrapper.h"
+#include "cpp2kdb/q_types.h"
+#include "cpp2kdb/string_column.h"
+#include "cpp2kdb/symbol_table.h"
+
+namespace cpp2kdb::arrow_export {
+namespace {
+/// Days from 1970.01.01 to 2000.01.01, where q counts dates from.
+constexpr std::int64_t q_epoch_days = 10957;
+/// Nanoseconds from 1970.01.01 to 2000.01.01.
+constexpr std::int64_t q_epoch_nanoseconds = q_epoch_days * 86400000000000;
+
+/// Data of an exported array, kept in private_data until released.
+struct ExportedArray {
+  /// Reference to the K vector exported in place, nullptr if the buffers
+  /// are all converted.
+  void* vector = nullptr;
+  /// Validity bitmap, empty if there is no null.
+  std::vector<std::uint8_t> validity;
+  /// Converted buffers, depending on the type.
+  std::vector<std::uint8_t> bitmap;
+  std::vector<std::int32_t> int32_data;
+  std::vector<std::int64_t> int64_data;
+  string_column::StringColumn strings;
+  /// Pointers passed in ArrowArray::buffers, starting with the validity
+  /// bitmap, nullptr if there is no null.
+  std::vector<const void*> buffers = {nullptr};
+  /// Children, which don't move once the pointers are taken.
+  std::vector<ArrowArray> children;
+  std::vector<ArrowArray*> child_pointers;
+  /// Dictionary of symbol columns.
+  std::unique_ptr<ArrowArray> dictionary;
+};
+
+/// Data of an exported schema, kept in private_data until released.
+struct ExportedSchema {
+  std::vector<ArrowSchema> children;
+  std::vector<ArrowSchema*> child_pointers;
+  std::unique_ptr<ArrowSchema> dictionary;
+};
+
+void ReleaseArray(ArrowArray* array) {
+  ExportedArray* exported = static_cast<ExportedArray*>(array->private_data);
+  // Children moved by the consumer are marked released.
+  for (ArrowArray& child : exported->children) {
+    if (child.release != nullptr) {
+      child.release(&child);
+    }
+  }
+  if (exported->dictionary != nullptr &&
+      exported->dictionary->release != nullptr) {
+    exported->dictionary->release(exported->dictionary.get());
+  }
+  if (exported->vector != nullptr) {
+    kdb_wrapper::DecreaseReferenceCount(exported->vector);
+  }
+  delete exported;
+  array->release = nullptr;
+}
+
+void ReleaseSchema(ArrowSchema* schema) {
+  ExportedSchema* exported = static_cast<ExportedSchema*>(schema->private_data);
+  for (ArrowSchema& child : exported->children) {
+    if (child.release != nullptr) {
+      child.release(&child);
+    }
+  }
+  if (exported->dictionary != nullptr &&
+      exported->dictionary->release != nullptr) {
+    exported->dictionary->release(exported->dictionary.get());
+  }
+  delete exported;
+  schema->release = nullptr;
+}
+
+/// Fill array from exported, which it takes.
+void FillArray(std::int64_t length, std::int64_t null_count,
+               std::unique_ptr<ExportedArray> exported, ArrowArray* array) {
+  array->length = length;
+  array->null_count = null_count;
+  array->offset = 0;
+  array->n_buffers = exported->buffers.size();
+  array->n_children = exported->children.size();
+  array->buffers = exported->buffers.data();
+  array->children =
+      exported->child_pointers.empty() ? nullptr
+                                       : exported->child_pointers.data();
+  array->dictionary = exported->dictionary.get();
+  array->release = ReleaseArray;
+  array->private_data = exported.release();
+}
+
+/// Fill schema from exported, which it takes.
+void FillSchema(const char* format, const char* name,
+                std::unique_ptr<ExportedSchema> exported,
+                ArrowSchema* schema) {
+  schema->format = format;
+  schema->name = name;
+  schema->metadata = nullptr;
+  schema->flags = 0;
+  schema->n_children = exported->children.size();
+  schema->children =
+      exported->child_pointers.empty() ? nullptr
+                                       : exported->child_pointers.data();
+  schema->dictionary = exported->dictionary.get();
+  schema->release = ReleaseSchema;
+  schema->private_data = exported.release();
+}
+
+/// Get the format of the columns exported in place, nullptr for the others.
+const char* GetInPlaceFormat(int q_type_id) {
+  switch (q_type_id) {
+    case q_types::q_guid_type_id:
+      return "w:16";
+    case q_types::q_byte_type_id:
+      return "C";
+    case q_types::q_short_type_id:
+      return "s";
+    case q_types::q_int_type_id:
+      return "i";
+    case q_types::q_long_type_id:
+      return "l";
+    case q_types::q_real_type_id:
+      return "f";
+    case q_types::q_float_type_id:
+      return "g";
+    case q_types::q_char_type_id:
+      return "w:1";
+    case q_types::q_timespan_type_id:
+      return "tDn";
+    case q_types::q_second_type_id:
+      return "tts";
+    case q_types::q_time_type_id:
+      return "ttm";
+    default:
+      return nullptr;
+  }
+}
+
+/// Build the validity bitmap of values, clearing the bits of the values
+/// is_null is true for. The bitmap is left empty if there is no null.
+/// \returns the number of nulls.
+template <typename T, typename IsNull>
+std::int64_t MakeValidityBitmap(const T* values,
+                                std::size_t number_of_elements,
+                                IsNull is_null,
+                                std::vector<std::uint8_t>* validity) {
+  std::int64_t null_count = 0;
+  for (std::size_t i = 0; i < number_of_elements; i++) {
+    if (is_null(values[i])) {
+      if (validity->empty()) {
+        validity->assign((number_of_elements + 7) / 8, 0xFF);
+      }
+      (*validity)[i / 8] &= static_cast<std::uint8_t>(~(1 << (i % 8)));
+      null_count++;
+    }
+  }
+  return null_count;
+}
+
+/// Build the validity bitmap of a column from the q nulls: the smallest
+/// value of the integral types, NaN, the guid of zeros and the empty symbol.
+/// \returns false for the types without null, such as boolean and char,
+///          whose null is a blank.
+bool MarkNulls(void* column, int q_type_id, std::size_t number_of_elements,
+               std::int64_t* null_count, std::vector<std::uint8_t>* validity) {
+  auto is_min = [](auto value) {
+    return value == std::numeric_limits<decltype(value)>::min();
+  };
+  auto is_nan = [](auto value) { return std::isnan(value); };
+  switch (q_type_id) {
+    case q_types::q_guid_type_id:
+      *null_count = MakeValidityBitmap(
+          accessors::GetVector<q_types::QGuid>(column), number_of_elements,
+          [](const q_types::QGuid& value) {
+            return (value.value[0] | value.value[1] | value.value[2] |
+                    value.value[3]) == 0;
+          },
+          validity);
+      return true;
+    case q_types::q_short_type_id:
+      *null_count =
+          MakeValidityBitmap(accessors::GetVector<std::int16_t>(column),
+                             number_of_elements, is_min, validity);
+      return true;
+    case q_types::q_int_type_id:
+    case q_types::q_date_type_id:
+    case q_types::q_second_type_id:
+    case q_types::q_time_type_id:
+      *null_count =
+          MakeValidityBitmap(accessors::GetVector<std::int32_t>(column),
+                             number_of_elements, is_min, validity);
+      return true;
+    case q_types::q_long_type_id:
+    case q_types::q_timestamp_type_id:
+    case q_types::q_timespan_type_id:
+      *null_count =
+          MakeValidityBitmap(accessors::GetVector<std::int64_t>(column),
+                             number_of_elements, is_min, validity);
+      return true;
+    case q_types::q_real_type_id:
+      *null_count = MakeValidityBitmap(accessors::GetVector<float>(column),
+                                       number_of_elements, is_nan, validity);
+      return true;
+    case q_types::q_float_type_id:
+      *null_count = MakeValidityBitmap(accessors::GetVector<double>(column),
+                                       number_of_elements, is_nan, validity);
+      return true;
+    case q_types::q_symbol_type_id:
+      *null_count = MakeValidityBitmap(
+          accessors::GetVector<char*>(column), number_of_elements,
+          [](const char* value) { return value[0] == '\0'; }, validity);
+      return true;
+    default:
+      return false;
+  }
+}
+
+/// Add offset, which is positive, to the values of input, except the null
+/// and the infinities. Values too late to be shifted are saturated to the
+/// largest value, which is the infinity.
+template <typename T>
+void ShiftEpoch(const T* input, std::size_t number_of_elements, T offset,
+                std::vector<T>* output) {
+  output->resize(number_of_elements);
+  for (std::size_t i = 0; i < number_of_elements; i++) {
+    T value = input[i];
+    if (value == std::numeric_limits<T>::min() ||
+        value == -std::numeric_limits<T>::max()) {
+      (*output)[i] = value;
+    } else if (value > std::numeric_limits<T>::max() - offset) {
+      (*output)[i] = std::numeric_limits<T>::max();
+    } else {
+      (*output)[i] = value + offset;
+    }
+  }
+}
+
+/// Export the symbols of table as a "U" dictionary.
+void ExportDictionary(const symbol_table::SymbolTable& table,
+                      ArrowSchema* schema, ArrowArray* array) {
+  auto exported = std::make_unique<ExportedArray>();
+  string_column::StringColumn& strings = exported->strings;
+  std::size_t number_of_symbols = table.GetNumberOfSymbols();
+  strings.offsets.reserve(number_of_symbols + 1);
+  for (std::size_t i = 0; i < number_of_symbols; i++) {
+    std::string_view symbol = table.GetSymbol(static_cast<std::int32_t>(i));
+    strings.data.insert(strings.data.end(), symbol.begin(), symbol.end());
+    strings.offsets.push_back(strings.data.size());
+  }
+  exported->buffers.push_back(strings.offsets.data());
+  exported->buffers.push_back(strings.data.data());
+  FillArray(number_of_symbols, 0, std::move(exported), array);
+  FillSchema("U", nullptr, std::make_unique<ExportedSchema>(), schema);
+}
+
+/// Export a column.
+accessors::DataRetrievalResult ExportColumn(void* column, const char* name,
+                                            ArrowSchema* schema,
+                                            ArrowArray* array) {
+  int q_type_id = kdb_wrapper::GetQTypeId(column);
+  std::size_t number_of_elements =
+      kdb_wrapper::GetNumberOfVectorElements(column);
+  auto exported_array = std::make_unique<ExportedArray>();
+  auto exported_schema = std::make_unique<ExportedSchema>();
+  std::int64_t null_count = 0;
+  bool is_nullable = MarkNulls(column, q_type_id, number_of_elements,
+                               &null_count, &exported_array->validity);
+  if (null_count > 0) {
+    exported_array->buffers[0] = exported_array->validity.data();
+  }
+  const char* format = GetInPlaceFormat(q_type_id);
+  if (format != nullptr) {
+    exported_array->vector = kdb_wrapper::IncreaseReferenceCount(column);
+    exported_array->buffers.push_back(kdb_wrapper::GetVector(column));
+  } else if (q_type_id == q_types::q_boolean_type_id) {
+    format = "b";
+    const bool* values = accessors::GetVector<bool>(column);
+    std::vector<std::uint8_t>& bitmap = exported_array->bitmap;
+    bitmap.assign((number_of_elements + 7) / 8, 0);
+    for (std::size_t i = 0; i < number_of_elements; i++) {
+      bitmap[i / 8] |= static_cast<std::uint8_t>(values[i]) << (i % 8);
+    }
+    exported_array->buffers.push_back(bitmap.data());
+  } else if (q_type_id == q_types::q_timestamp_type_id) {
+    format = "tsn:";
+    ShiftEpoch(accessors::GetVector<std::int64_t>(column), number_of_elements,
+               q_epoch_nanoseconds, &exported_array->int64_data);
+    exported_array->buffers.push_back(exported_array->int64_data.data());
+  } else if (q_type_id == q_types::q_date_type_id) {
+    format = "tdD";
+    ShiftEpoch(accessors::GetVector<std::int32_t>(column), number_of_elements,
+               static_cast<std::int32_t>(q_epoch_days),
+               &exported_array->int32_data);
+    exported_array->buffers.push_back(exported_array->int32_data.data());
+  } else if (q_type_id == q_types::q_symbol_type_id) {
+    format = "i";
+    symbol_table::SymbolTable table;
+    exported_array->int32_data.resize(number_of_elements);
+    table.Encode(column, exported_array->int32_data.data());
+    exported_array->buffers.push_back(exported_array->int32_data.data());
+    exported_array->dictionary = std::make_unique<ArrowArray>();
+    exported_schema->dictionary = std::make_unique<ArrowSchema>();
+    ExportDictionary(table, exported_schema->dictionary.get(),
+                     exported_array->dictionary.get());
+  } else if (q_types::IsQTypeIdMixedVector(q_type_id)) {
+    format = "U";
+    string_column::StringColumn& strings = exported_array->strings;
+    accessors::DataRetrievalResult result =
+        string_column::RetrieveStringColumn(column, &strings);
+    if (result != accessors::DataRetrievalResult::Ok) {
+      return result;
+    }
+    exported_array->buffers.push_back(strings.offsets.data());
+    exported_array->buffers.push_back(strings.data.data());
+  } else {
+    return accessors::DataRetrievalResult::InvalidQTypeId;
+  }
+  FillArray(number_of_elements, null_count, std::move(exported_array), array);
+  FillSchema(format, name, std::move(exported_schema), schema);
+  if (is_nullable) {
+    schema->flags = ARROW_FLAG_NULLABLE;
+  }
+  return accessors::DataRetrievalResult::Ok;
+}
+}  // namespace
+
+accessors::DataRetrievalResult ExportSimpleTable(void* simple_table,
+                                                 ArrowSchema* schema,
+                                                 ArrowArray* array) {
+  kdb_wrapper::CallHooksGuard hooks_guard(kdb_wrapper::CallKind::Conversion,
+                                          "ExportSimpleTable", 0, nullptr,
+                                          simple_table);
+  // GetSimpleTable doesn't check its input.
+  if (simple_table == nullptr) {
+    return accessors::DataRetrievalResult::NullInput;
+  }
+  if (accessors::IsError(simple_table)) {
+    return accessors::DataRetrievalResult::ValueError;
+  }
+  if (!accessors::IsTable(simple_table)) {
+    return accessors::DataRetrievalResult::NotSimpleTable;
+  }
+  void* column_heading;
+  void** columns = nullptr;
+  std::size_t number_of_columns, number_of_rows = 0;
+  accessors::DataRetrievalResult result =
+      accessors::GetSimpleTable(simple_table, &column_heading, &columns,
+                                &number_of_columns, &number_of_rows);
+  if (result != accessors::DataRetrievalResult::Ok) {
+    return result;
+  }
+  char** column_names = accessors::GetVector<char*>(column_heading);
+
+  // Children are zeroed, so the ones not exported yet are marked released.
+  auto exported_array = std::make_unique<ExportedArray>();
+  auto exported_schema = std::make_unique<ExportedSchema>();
+  exported_array->children.resize(number_of_columns, ArrowArray{});
+  exported_schema->children.resize(number_of_columns, ArrowSchema{});
+  for (std::size_t i = 0; i < number_of_columns; i++) {
+    exported_array->child_pointers.push_back(&exported_array->children[i]);
+    exported_schema->child_pointers.push_back(&exported_schema->children[i]);
+  }
+  ArrowArray table_array;
+  ArrowSchema table_schema;
+  FillArray(number_of_rows, 0, std::move(exported_array), &table_array);
+  FillSchema("+s", "", std::move(exported_schema), &table_schema);
+
+  // Column names are interned symbols, which are never freed.
+  for (std::size_t i = 0; i < number_of_columns; i++) {
+    result = ExportColumn(columns[i], column_names[i],
+                          table_schema.children[i], table_array.children[i]);
+    if (result != accessors::DataRetrievalResult::Ok) {
+      table_array.release(&table_array);
+      table_schema.release(&table_schema);
+      return result;
+    }
+  }
+  *schema = table_schema;
+  *array = table_array;
+  return accessors::DataRetrievalResult::Ok;
+}
+}  // namespace cpp2kdb::arrow_export
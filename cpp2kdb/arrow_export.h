@@ -0,0 +1,107 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_ARROW_EXPORT_H__
+#define CPP2KDB_ARROW_EXPORT_H__
+/// \file cpp2kdb/arrow_export.h
+/// Export of simple tables through the Arrow C data interface.
+///
+/// The C data interface is a pair of C structs, ArrowSchema and ArrowArray,
+/// that any Arrow implementation can import without depending on the others.
+/// Columns whose layout is the same in q and Arrow are exported in place: the
+/// buffers point into the K vectors, which are kept alive by a reference
+/// released by the release callback. The other columns are converted.
+
+#include <cstdint>
+
+#include "cpp2kdb/accessors.h"
+
+// The C data interface, as defined by the Arrow specification. The guard is
+// the one used by Arrow, so the structs can be defined by either.
+extern "C" {
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_NULLABLE 4
+
+struct ArrowSchema {
+  // Array type description
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowSchema*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+struct ArrowArray {
+  // Array data description
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowArray*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+#endif  // ARROW_C_DATA_INTERFACE
+}
+
+/// Export to Arrow.
+namespace cpp2kdb::arrow_export {
+/// Export a simple table as an Arrow struct array, with one child per column.
+///
+/// Columns are exported as follows, in place unless noted:
+/// - boolean as "b", converted to a bitmap.
+/// - guid as "w:16", char as "w:1" and byte as "C".
+/// - short, int, long, real and float as "s", "i", "l", "f" and "g".
+/// - timestamp as "tsn:" and date as "tdD", converted to the Unix epoch.
+/// - timespan as "tDn", second as "tts" and time as "ttm".
+/// - symbol as "i" indices into a "U" dictionary of the symbols of the
+///   column, encoded with symbol_table::SymbolTable.
+/// - mixed list of char vectors as "U", retrieved with
+///   string_column::RetrieveStringColumn.
+///
+/// Q nulls are marked in validity bitmaps, and the columns of types with a
+/// null are flagged nullable: the smallest value of short, int, long and the
+/// temporal types, NaN for real and float, the guid of zeros and the empty
+/// symbol. The bitmap is only built when the column has a null. Booleans,
+/// bytes and chars have no null in Arrow, and neither do the char vectors of
+/// mixed lists, so blanks and empty strings are exported as values. The
+/// values under the nulls keep their q values, as do the infinities of
+/// timestamps and dates. Timestamps and dates after the last one the Unix
+/// epoch can hold, near 2262.04.11 for timestamps, are exported as the
+/// infinity.
+///
+/// The release callbacks call r0 on the columns exported in place, so they
+/// must be called where the kdb_wrapper functions can be, like any r0.
+/// \returns NullInput, ValueError, NotSimpleTable if the input is not a table
+///          (keyed tables included), InvalidQTypeId for the column types
+///          Arrow can't take (month, datetime and minute) and
+///          NotCharVectorInMixedVector for mixed lists of other objects.
+///          schema and array are left unchanged when the result is not Ok.
+accessors::DataRetrievalResult ExportSimpleTable(
+    /// [in] Input simple table.
+    void* simple_table,
+    /// [out] Schema, which the caller must release.
+    ArrowSchema* schema,
+    /// [out] Array, which the caller must release.
+    ArrowArray* array);
+}  // namespace cpp2kdb::arrow_export
+#endif  // CPP2KDB_ARROW_EXPORT_H__
@@ -0,0 +1,252 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/arrow_export.h"
+
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+#include "cpp2kdb/synthetic_data.h"
+
+// Tables are built in process, no connection is needed.
+namespace {
+/// Build a table with one column per vector, taking the vectors.
+void* MakeTable(const std::vector<const char*>& names,
+                const std::vector<void*>& vectors) {
+  void* heading = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_symbol_type_id, names.size());
+  void* values = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_mixed_type_id, vectors.size());
+  for (std::size_t i = 0; i < names.size(); i++) {
+    cpp2kdb::accessors::GetVector<char*>(heading)[i] =
+        cpp2kdb::kdb_wrapper::InternSymbol(names[i]);
+    cpp2kdb::accessors::GetVector<void*>(values)[i] = vectors[i];
+  }
+  return cpp2kdb::kdb_wrapper::CreateTable(
+      cpp2kdb::kdb_wrapper::CreateDict(heading, values));
+}
+
+std::string_view GetString(const ArrowArray& array, std::int64_t i) {
+  const std::int64_t* offsets =
+      static_cast<const std::int64_t*>(array.buffers[1]);
+  const char* data = static_cast<const char*>(array.buffers[2]);
+  return std::string_view(data + offsets[i], offsets[i + 1] - offsets[i]);
+}
+
+void TestTradeTable() {
+  cpp2kdb::synthetic_data::TableOptions options;
+  options.number_of_rows = 1000;
+  options.seed = 5;
+  options.with_char_vector_column = true;
+  void* trade = cpp2kdb::synthetic_data::MakeTradeTable(options);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(trade);
+  void* column_heading;
+  void** columns;
+  std::size_t number_of_columns, number_of_rows;
+  cpp2kdb::accessors::GetSimpleTable(trade, &column_heading, &columns,
+                                     &number_of_columns, &number_of_rows);
+
+  ArrowSchema schema;
+  ArrowArray array;
+  std::cout << "Export: "
+            << cpp2kdb::arrow_export::ExportSimpleTable(trade, &schema, &array)
+            << ", format " << schema.format << ", " << array.length
+            << " rows" << std::endl;
+  for (std::int64_t i = 0; i < schema.n_children; i++) {
+    std::cout << schema.children[i]->name << ": "
+              << schema.children[i]->format;
+    if (schema.children[i]->dictionary != nullptr) {
+      std::cout << " of " << schema.children[i]->dictionary->format;
+    }
+    std::cout << std::endl;
+  }
+
+  // price is exported in place.
+  std::cout << "price in place? "
+            << (array.children[2]->buffers[1] ==
+                        cpp2kdb::kdb_wrapper::GetVector(columns[2])
+                    ? "Yes"
+                    : "No")
+            << std::endl;
+  // time is moved to the Unix epoch.
+  std::int64_t q_time = cpp2kdb::accessors::GetVector<std::int64_t>(
+      columns[0])[0];
+  std::int64_t arrow_time =
+      static_cast<const std::int64_t*>(array.children[0]->buffers[1])[0];
+  std::cout << "time shifted by 2000.01.01? "
+            << (arrow_time - q_time == 946684800000000000 ? "Yes" : "No")
+            << std::endl;
+
+  std::vector<std::string> syms(number_of_rows), conds(number_of_rows);
+  cpp2kdb::accessors::RetrieveVectorData(columns[1], syms.data());
+  cpp2kdb::accessors::RetrieveVectorData(columns[5], conds.data());
+  const std::int32_t* indices =
+      static_cast<const std::int32_t*>(array.children[1]->buffers[1]);
+  bool is_same = true;
+  for (std::size_t i = 0; i < number_of_rows; i++) {
+    is_same = is_same &&
+              GetString(*array.children[1]->dictionary, indices[i]) ==
+                  syms[i] &&
+              GetString(*array.children[5], i) == conds[i];
+  }
+  std::cout << "sym and cond same as std::string? "
+            << (is_same ? "Yes" : "No") << std::endl;
+
+  array.release(&array);
+  schema.release(&schema);
+  std::cout << "Released? "
+            << (array.release == nullptr && schema.release == nullptr ? "Yes"
+                                                                      : "No")
+            << std::endl;
+}
+
+void TestConvertedColumns() {
+  void* flags = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_boolean_type_id, 10);
+  void* dates = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_date_type_id, 10);
+  for (int i = 0; i < 10; i++) {
+    cpp2kdb::accessors::GetVector<bool>(flags)[i] = i % 3 == 0;
+    cpp2kdb::accessors::GetVector<std::int32_t>(dates)[i] = i;
+  }
+  // 0Nd stays null.
+  cpp2kdb::accessors::GetVector<std::int32_t>(dates)[9] =
+      std::numeric_limits<std::int32_t>::min();
+  void* table = MakeTable({"flag", "date"}, {flags, dates});
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(table);
+
+  ArrowSchema schema;
+  ArrowArray array;
+  std::cout << "Export: "
+            << cpp2kdb::arrow_export::ExportSimpleTable(table, &schema, &array)
+            << std::endl;
+  const std::uint8_t* bitmap =
+      static_cast<const std::uint8_t*>(array.children[0]->buffers[1]);
+  std::cout << "flag bitmap: " << static_cast<int>(bitmap[0]) << " "
+            << static_cast<int>(bitmap[1]) << std::endl;
+  const std::int32_t* days =
+      static_cast<const std::int32_t*>(array.children[1]->buffers[1]);
+  std::cout << "date: " << days[0] << " " << days[8] << " " << days[9]
+            << std::endl;
+  const std::uint8_t* date_validity =
+      static_cast<const std::uint8_t*>(array.children[1]->buffers[0]);
+  std::cout << "date nulls: " << array.children[1]->null_count
+            << ", validity " << static_cast<int>(date_validity[0]) << " "
+            << static_cast<int>(date_validity[1] & 3) << std::endl;
+  array.release(&array);
+  schema.release(&schema);
+}
+
+void TestNulls() {
+  void* longs = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_long_type_id, 3);
+  void* floats = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_float_type_id, 3);
+  void* syms = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_symbol_type_id, 3);
+  void* times = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_timestamp_type_id, 3);
+  for (int i = 0; i < 3; i++) {
+    cpp2kdb::accessors::GetVector<std::int64_t>(longs)[i] = i;
+    cpp2kdb::accessors::GetVector<double>(floats)[i] = i;
+    cpp2kdb::accessors::GetVector<char*>(syms)[i] =
+        cpp2kdb::kdb_wrapper::InternSymbol("a");
+    cpp2kdb::accessors::GetVector<std::int64_t>(times)[i] = i;
+  }
+  // 0N, 0n, ` and a timestamp after 2262.04.11.
+  cpp2kdb::accessors::GetVector<std::int64_t>(longs)[1] =
+      std::numeric_limits<std::int64_t>::min();
+  cpp2kdb::accessors::GetVector<double>(floats)[0] =
+      std::numeric_limits<double>::quiet_NaN();
+  cpp2kdb::accessors::GetVector<char*>(syms)[2] =
+      cpp2kdb::kdb_wrapper::InternSymbol("");
+  cpp2kdb::accessors::GetVector<std::int64_t>(times)[2] =
+      std::numeric_limits<std::int64_t>::max() - 1;
+  void* table =
+      MakeTable({"long", "float", "sym", "time"}, {longs, floats, syms, times});
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(table);
+
+  ArrowSchema schema;
+  ArrowArray array;
+  std::cout << "Export: "
+            << cpp2kdb::arrow_export::ExportSimpleTable(table, &schema, &array)
+            << std::endl;
+  for (std::int64_t i = 0; i < 3; i++) {
+    const ArrowArray& child = *array.children[i];
+    const std::uint8_t* validity =
+        static_cast<const std::uint8_t*>(child.buffers[0]);
+    std::cout << schema.children[i]->name << " nulls: " << child.null_count
+              << ", validity " << static_cast<int>(validity[0] & 7)
+              << ", nullable? "
+              << (schema.children[i]->flags & ARROW_FLAG_NULLABLE ? "Yes"
+                                                                  : "No")
+              << std::endl;
+  }
+  const std::int64_t* time =
+      static_cast<const std::int64_t*>(array.children[3]->buffers[1]);
+  std::cout << "time nulls: " << array.children[3]->null_count
+            << ", late time saturated? "
+            << (time[2] == std::numeric_limits<std::int64_t>::max() ? "Yes"
+                                                                    : "No")
+            << std::endl;
+  array.release(&array);
+  schema.release(&schema);
+}
+
+void TestErrors() {
+  ArrowSchema schema{};
+  ArrowArray array{};
+  void* months = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_month_type_id, 2);
+  void* longs = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_long_type_id, 2);
+  void* month_table = MakeTable({"a", "month"}, {longs, months});
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard month_guard(month_table);
+  std::cout << "Month column: "
+            << cpp2kdb::arrow_export::ExportSimpleTable(month_table, &schema,
+                                                        &array)
+            << ", unchanged? "
+            << (array.release == nullptr && schema.release == nullptr ? "Yes"
+                                                                      : "No")
+            << std::endl;
+
+  void* list = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_mixed_type_id, 2);
+  cpp2kdb::accessors::GetVector<void*>(list)[0] =
+      cpp2kdb::kdb_wrapper::CreateCharVector("one");
+  cpp2kdb::accessors::GetVector<void*>(list)[1] =
+      cpp2kdb::kdb_wrapper::CreateLong(2);
+  void* list_table = MakeTable({"list"}, {list});
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard list_guard(list_table);
+  std::cout << "Mixed list with a long: "
+            << cpp2kdb::arrow_export::ExportSimpleTable(list_table, &schema,
+                                                        &array)
+            << std::endl;
+
+  void* vector = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_long_type_id, 2);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard vector_guard(vector);
+  std::cout << "Long vector: "
+            << cpp2kdb::arrow_export::ExportSimpleTable(vector, &schema,
+                                                        &array)
+            << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  TestTradeTable();
+  std::cout << "----------------------" << std::endl;
+  TestConvertedColumns();
+  std::cout << "----------------------" << std::endl;
+  TestNulls();
+  std::cout << "----------------------" << std::endl;
+  TestErrors();
+  return 0;
+}
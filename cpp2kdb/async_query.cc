@@ -0,0 +1,279 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/async_query.h"
+
+#include <poll.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace cpp2kdb::async_query {
+namespace {
+/// Function evaluating the query on the server, and sending back (request id;
+/// success flag; result). Errors are trapped and sent back as the error
+/// message.
+constexpr const char* reply_function =
+    "{[id;query] neg[.z.w] @[{(x;1b;value y)}[id];query;{(x;0b;y)}[id]]}";
+
+/// Request id reserved to stop the reader thread.
+constexpr std::int64_t stop_request_id = -1;
+
+/// Number of elements in a reply.
+constexpr long long number_of_reply_elements = 3;  // NOLINT
+
+/// Request id of the queries run by RunQueryWithDeadline. The connection is
+/// not used again after a timeout, so there is no earlier reply to tell from.
+constexpr std::int64_t deadline_request_id = 0;
+}  // namespace
+
+bool SendQueryWithReply(int connection, std::int64_t request_id,
+                        const char* query) {
+  // k releases the arguments.
+  return kdb_wrapper::SendAsyncQueryOnConnection(
+      connection, reply_function, kdb_wrapper::CreateLong(request_id),
+      kdb_wrapper::CreateCharVector(query));
+}
+
+int WaitForMessage(const int* connections, std::size_t number_of_connections,
+                   int timeout) {
+  // Connections waited on together are only a few.
+  constexpr std::size_t max_number_of_connections = 64;
+  if (number_of_connections > max_number_of_connections) {
+    return -2;
+  }
+  pollfd poll_fds[max_number_of_connections];
+  for (std::size_t i = 0; i < number_of_connections; i++) {
+    poll_fds[i].fd = connections[i];
+    poll_fds[i].events = POLLIN;
+    poll_fds[i].revents = 0;
+  }
+  int number_of_ready;
+  do {
+    number_of_ready = poll(poll_fds, number_of_connections, timeout);
+  } while (number_of_ready < 0 && errno == EINTR);
+  if (number_of_ready < 0) {
+    return -2;
+  }
+  for (std::size_t i = 0; i < number_of_connections; i++) {
+    // Closed or failed connections are returned too, reading them fails.
+    if (poll_fds[i].revents != 0) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+const char* GetDeadlineResultName(DeadlineResult result) {
+  // Cast result to an int.
+  int temp_result = static_cast<int>(result);
+  // Make sure it's valid.
+  if (temp_result >= 0 && temp_result < number_of_deadline_result_names) {
+    return DeadlineResultNames[temp_result];
+  } else {
+    return "Invalid";
+  }
+}
+
+std::ostream& operator<<(std::ostream& output, DeadlineResult result) {
+  return output << GetDeadlineResultName(result);
+}
+
+DeadlineResult RunQueryWithDeadline(
+    int connection, const char* query,
+    std::chrono::steady_clock::time_point deadline, void** result) {
+  *result = nullptr;
+  if (!SendQueryWithReply(connection, deadline_request_id, query)) {
+    return DeadlineResult::ConnectionLost;
+  }
+  while (true) {
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    // Round up, so the deadline is not missed by the truncation.
+    int timeout = static_cast<int>(std::clamp<std::int64_t>(
+        remaining.count() + 1, 0, std::numeric_limits<int>::max()));
+    int ready_index = WaitForMessage(&connection, 1, timeout);
+    if (ready_index == -1) {
+      return DeadlineResult::TimedOut;
+    }
+    if (ready_index < 0) {
+      return DeadlineResult::ConnectionLost;
+    }
+    void* message = kdb_wrapper::ReadMessageFromConnection(connection);
+    if (message == nullptr) {
+      return DeadlineResult::ConnectionLost;
+    }
+    std::int64_t request_id;
+    if (UnpackReply(message, &request_id, result)) {
+      return DeadlineResult::Ok;
+    }
+    // Not sent for us, ignore it.
+  }
+}
+
+bool UnpackReply(void* message, std::int64_t* request_id, void** result) {
+  if (message == nullptr) {
+    return false;
+  }
+  kdb_wrapper::DecreaseReferenceCountGuard guard(message);
+  // Make sure this is (long; boolean; result)
+  if (!accessors::IsMixedVector(message) ||
+      kdb_wrapper::GetNumberOfVectorElements(message) !=
+          number_of_reply_elements) {
+    return false;
+  }
+  void** elements = accessors::GetVector<void*>(message);
+  if (kdb_wrapper::GetQTypeId(elements[0]) != -q_types::q_long_type_id ||
+      kdb_wrapper::GetQTypeId(elements[1]) != -q_types::q_boolean_type_id) {
+    return false;
+  }
+
+  *request_id = accessors::GetValue<std::int64_t>(elements[0]);
+  if (accessors::GetValue<bool>(elements[1])) {
+    // Keep the result alive after the message is released.
+    *result = kdb_wrapper::IncreaseReferenceCount(elements[2]);
+  } else {
+    // The error message is a char vector.
+    *result = kdb_wrapper::CreateError(
+        accessors::GetStringFromCharVector(elements[2]).c_str());
+  }
+  return true;
+}
+
+AsyncConnection::AsyncConnection(int connection)
+    : connection(connection), next_request_id(0), is_broken(false) {
+  // do nothing here
+}
+
+AsyncConnection::~AsyncConnection() { this->Stop(); }
+
+bool AsyncConnection::Start() {
+  if (this->reader_thread.joinable()) {
+    return false;
+  }
+  // Replies are deserialized on the reader thread.
+  kdb_wrapper::SetSymbolInterningMutex(1);
+  this->reader_thread = std::thread(&AsyncConnection::ReadReplies, this);
+  return true;
+}
+
+void AsyncConnection::Stop() {
+  if (!this->reader_thread.joinable()) {
+    return;
+  }
+  bool is_sent;
+  {
+    // The stop request is replied after all the queries sent before it.
+    std::lock_guard<std::mutex> send_lock(this->send_mutex);
+    is_sent = SendQueryWithReply(this->connection, stop_request_id, "::");
+  }
+  if (!is_sent) {
+    // Reader will get nullptr since the connection is lost.
+    std::lock_guard<std::mutex> pending_lock(this->pending_mutex);
+    this->is_broken = true;
+  }
+  this->reader_thread.join();
+}
+
+bool AsyncConnection::Submit(const char* query, QueryCallback callback) {
+  std::int64_t request_id;
+  {
+    std::lock_guard<std::mutex> pending_lock(this->pending_mutex);
+    if (this->is_broken) {
+      return false;
+    }
+    // Register before sending, the reply may arrive before send returns.
+    request_id = this->next_request_id++;
+    this->pending_queries.emplace(request_id, std::move(callback));
+  }
+
+  bool is_sent;
+  {
+    std::lock_guard<std::mutex> send_lock(this->send_mutex);
+    is_sent = SendQueryWithReply(this->connection, request_id, query);
+  }
+  if (!is_sent) {
+    std::lock_guard<std::mutex> pending_lock(this->pending_mutex);
+    // The reader may have already failed it with nullptr when it found the
+    // connection lost, and then the callback is already called.
+    return this->pending_queries.erase(request_id) == 0;
+  }
+  return true;
+}
+
+std::future<void*> AsyncConnection::Submit(const char* query) {
+  // std::function requires copyable callable, so share the promise.
+  auto promise = std::make_shared<std::promise<void*>>();
+  std::future<void*> future = promise->get_future();
+  bool is_sent = this->Submit(
+      query, [promise](void* result) { promise->set_value(result); });
+  if (!is_sent) {
+    promise->set_value(nullptr);
+  }
+  return future;
+}
+
+std::size_t AsyncConnection::GetNumberOfPendingQueries() {
+  std::lock_guard<std::mutex> pending_lock(this->pending_mutex);
+  return this->pending_queries.size();
+}
+
+void AsyncConnection::ReadReplies() {
+  while (true) {
+    void* message = kdb_wrapper::ReadMessageFromConnection(this->connection);
+    if (message == nullptr) {
+      // Connection is lost.
+      this->FailPendingQueries();
+      return;
+    }
+    std::int64_t request_id;
+    void* result;
+    if (!UnpackReply(message, &request_id, &result)) {
+      // Not sent for us, ignore it.
+      continue;
+    }
+    if (request_id == stop_request_id) {
+      kdb_wrapper::DecreaseReferenceCount(result);
+      // Anything still pending was never sent.
+      this->FailPendingQueries();
+      return;
+    }
+
+    QueryCallback callback;
+    {
+      std::lock_guard<std::mutex> pending_lock(this->pending_mutex);
+      auto iterator = this->pending_queries.find(request_id);
+      if (iterator != this->pending_queries.end()) {
+        callback = std::move(iterator->second);
+        this->pending_queries.erase(iterator);
+      }
+    }
+    // Call without holding the lock, so the callback can submit more.
+    if (callback) {
+      callback(result);
+    } else {
+      kdb_wrapper::DecreaseReferenceCount(result);
+    }
+  }
+}
+
+void AsyncConnection::FailPendingQueries() {
+  std::unordered_map<std::int64_t, QueryCallback> failed_queries;
+  {
+    std::lock_guard<std::mutex> pending_lock(this->pending_mutex);
+    this->is_broken = true;
+    failed_queries.swap(this->pending_queries);
+  }
+  for (auto& failed_query : failed_queries) {
+    failed_query.second(nullptr);
+  }
+}
+}  // namespace cpp2kdb::async_query
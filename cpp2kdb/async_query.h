@@ -0,0 +1,188 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_ASYNC_QUERY_H__
+#define CPP2KDB_ASYNC_QUERY_H__
+/// \file cpp2kdb/async_query.h
+/// Asynchronous queries with many requests in flight on one connection.
+///
+/// The query is sent on the negative handle together with a request id, and
+/// the server is asked to send the result back with neg[.z.w] as a 3 element
+/// mixed list (request id; success flag; result). The reply is matched to the
+/// caller by the request id.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+/// Asynchronous queries on connections opened by kdb_wrapper::OpenConnection.
+namespace cpp2kdb::async_query {
+/// Send query asynchronously, asking the server to send the result back tagged
+/// with request_id.
+///
+/// Errors on the server are trapped and sent back, so every query sent
+/// successfully gets exactly one reply. Replies on the same connection arrive
+/// in the same order as the queries are sent.
+/// \returns false if the message cannot be sent.
+bool SendQueryWithReply(
+    /// Handle
+    int connection,
+    /// Id to tag the reply with.
+    std::int64_t request_id,
+    /// Query
+    const char* query);
+
+/// Unpack a reply sent back for a query sent by SendQueryWithReply.
+///
+/// The reference to message is always released. On success, result is set to
+/// a new reference to the result of the query, which is an error object
+/// (type -128) if the query failed on the server.
+/// \returns false if message is nullptr or not a reply.
+bool UnpackReply(
+    /// [in] Message read from the connection.
+    void* message,
+    /// [out] Id the reply is tagged with.
+    std::int64_t* request_id,
+    /// [out] Result of the query.
+    void** result);
+
+/// Wait until one of the connections has a message to read, or is closed.
+///
+/// The handles are socket file descriptors, so they are waited on with poll.
+/// \returns index of a connection ready to read, -1 on timeout, or -2 if poll
+/// fails.
+int WaitForMessage(
+    /// [in] Handles.
+    const int* connections,
+    /// Number of handles.
+    std::size_t number_of_connections,
+    /// Timeout in milliseconds, negative to wait forever.
+    int timeout);
+
+/// Deadline Result
+enum class DeadlineResult {
+  /// Ok.
+  Ok = 0,
+  /// No reply before the deadline.
+  TimedOut,
+  /// Connection is lost.
+  ConnectionLost
+};
+
+/// Names for the enums.
+constexpr const char* DeadlineResultNames[] = {"Ok", "TimedOut",
+                                               "ConnectionLost"};
+
+/// Number of deadline result names
+constexpr const int number_of_deadline_result_names =
+    sizeof(DeadlineResultNames) / sizeof(DeadlineResultNames[0]);
+
+/// Get the name from a result
+const char* GetDeadlineResultName(DeadlineResult result);
+
+/// Overload << for result type `DeadlineResult`.
+std::ostream& operator<<(std::ostream& output_stream, DeadlineResult result);
+
+/// Run a query, giving up if no reply arrives before the deadline.
+///
+/// The query is sent by SendQueryWithReply, and the handle is polled until
+/// the deadline. A reply starting to arrive before the deadline is read to
+/// the end. The query keeps running on the server after TimedOut, and its
+/// reply will still arrive, so the connection must not be used again and
+/// should be closed (see connection_pool::ConnectionLease::RunQuery).
+DeadlineResult RunQueryWithDeadline(
+    /// Handle
+    int connection,
+    /// Query
+    const char* query,
+    /// Deadline
+    std::chrono::steady_clock::time_point deadline,
+    /// [out] Result owned by the caller when Ok, which is an error object
+    /// (type -128) if the query failed on the server. nullptr otherwise.
+    void** result);
+
+/// Function called with the result of an asynchronous query.
+///
+/// The callback owns the result and must release it with
+/// kdb_wrapper::DecreaseReferenceCount. The result is an error object if the
+/// query failed on the server, and nullptr if the connection is lost before
+/// the reply arrives.
+using QueryCallback = std::function<void(void* result)>;
+
+/// Many queries in flight on one connection.
+///
+/// A reader thread drains the replies and completes the callbacks or futures,
+/// so the callbacks are called on the reader thread and should return quickly.
+/// Since K objects are created on the reader thread, symbol interning is
+/// protected by mutex (kdb_wrapper::SetSymbolInterningMutex) when the reader
+/// is started.
+///
+/// The connection is not owned, and must be left alone by other code while
+/// AsyncConnection is started.
+class AsyncConnection {
+ public:
+  /// Create on a handle returned by kdb_wrapper::OpenConnection.
+  explicit AsyncConnection(int connection);
+  /// Default constructor is deleted.
+  AsyncConnection() = delete;
+  /// Copy constructor is deleted.
+  AsyncConnection(const AsyncConnection&) = delete;
+  /// assignment operator is deleted.
+  AsyncConnection& operator=(const AsyncConnection&) = delete;
+
+  /// Destructor, calling Stop.
+  ~AsyncConnection();
+
+  /// Start the reader thread.
+  /// \returns false if it is already started.
+  bool Start();
+
+  /// Stop the reader thread after the replies of all the queries submitted so
+  /// far have arrived. AsyncConnection cannot be started again after Stop.
+  void Stop();
+
+  /// Submit a query, and call callback with its result.
+  /// \returns false if the query cannot be sent, and callback is not called.
+  bool Submit(
+      /// Query
+      const char* query,
+      /// Called on the reader thread with the result.
+      QueryCallback callback);
+
+  /// Submit a query, and get its result through a future.
+  ///
+  /// The value of the future follows the same rules as QueryCallback. If the
+  /// query cannot be sent, the future is ready with nullptr.
+  std::future<void*> Submit(
+      /// Query
+      const char* query);
+
+  /// Get the number of queries submitted but without reply yet.
+  std::size_t GetNumberOfPendingQueries();
+
+ private:
+  /// Loop of the reader thread.
+  void ReadReplies();
+  /// Complete all pending queries with nullptr.
+  void FailPendingQueries();
+
+  int connection;
+  std::thread reader_thread;
+  /// Protects writing to the connection.
+  std::mutex send_mutex;
+  /// Protects pending_queries and next_request_id.
+  std::mutex pending_mutex;
+  std::unordered_map<std::int64_t, QueryCallback> pending_queries;
+  std::int64_t next_request_id;
+  /// Set when the connection is lost.
+  bool is_broken;
+};
+}  // namespace cpp2kdb::async_query
+#endif  // CPP2KDB_ASYNC_QUERY_H__
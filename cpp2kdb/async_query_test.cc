@@ -0,0 +1,91 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/async_query.h"
+
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+
+namespace {
+void TestFutures(cpp2kdb::async_query::AsyncConnection* async_connection) {
+  constexpr int number_of_queries = 100;
+  std::vector<std::future<void*>> futures;
+  for (int i = 0; i < number_of_queries; i++) {
+    std::string query = std::to_string(i) + " * 2";
+    futures.push_back(async_connection->Submit(query.c_str()));
+  }
+  std::cout << "Pending queries after submission: "
+            << async_connection->GetNumberOfPendingQueries() << std::endl;
+  int number_of_correct = 0;
+  for (int i = 0; i < number_of_queries; i++) {
+    void* result = futures[i].get();
+    if (result == nullptr) {
+      continue;
+    }
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(result);
+    if (cpp2kdb::accessors::GetValue<std::int64_t>(result) == i * 2) {
+      number_of_correct++;
+    }
+  }
+  std::cout << "Correct results: " << number_of_correct << " out of "
+            << number_of_queries << std::endl;
+}
+
+void TestError(cpp2kdb::async_query::AsyncConnection* async_connection) {
+  void* result = async_connection->Submit("1 + `a").get();
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(result);
+  std::cout << "Is result of 1 + `a error? "
+            << (cpp2kdb::accessors::IsError(result) ? "Yes" : "No")
+            << std::endl;
+}
+
+void TestCallbacks(cpp2kdb::async_query::AsyncConnection* async_connection) {
+  constexpr int number_of_queries = 100;
+  std::atomic<int> number_of_replies{0};
+  for (int i = 0; i < number_of_queries; i++) {
+    async_connection->Submit("til 10", [&number_of_replies](void* result) {
+      if (result != nullptr) {
+        cpp2kdb::kdb_wrapper::DecreaseReferenceCount(result);
+        number_of_replies++;
+      }
+    });
+  }
+  // Results of queries are sent back in order, so waiting on the last one is
+  // enough.
+  void* last = async_connection->Submit("::").get();
+  if (last != nullptr) {
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCount(last);
+  }
+  std::cout << "Callbacks called: " << number_of_replies << " out of "
+            << number_of_queries << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  // Open connection
+  int connection = cpp2kdb::kdb_wrapper::OpenConnection("127.0.0.1", 5000, "");
+
+  if (connection <= 0) {
+    std::cerr << "Connection error: " << connection << std::endl;
+    return 1;
+  }
+
+  {
+    cpp2kdb::async_query::AsyncConnection async_connection(connection);
+    async_connection.Start();
+    TestFutures(&async_connection);
+    std::cout << "----------------------" << std::endl;
+    TestError(&async_connection);
+    std::cout << "----------------------" << std::endl;
+    TestCallbacks(&async_connection);
+    async_connection.Stop();
+  }
+
+  cpp2kdb::kdb_wrapper::CloseConnection(connection);
+  return 0;
+}
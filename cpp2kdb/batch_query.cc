@@ -0,0 +1,166 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/batch_query.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/async_query.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace cpp2kdb::batch_query {
+namespace {
+/// Function evaluating each query on the server, trapping errors.
+///
+/// Each result is sent back as (success flag; result or error message; ::).
+/// The trailing generic null keeps the triple a mixed list even when the
+/// result is a boolean atom, and keeps the outer list a mixed list even when
+/// all results are atoms of the same type.
+constexpr const char* coalesce_function =
+    "{{@[{(1b;value x;::)};x;{(0b;x;::)}]} each x}";
+
+/// Number of elements in the reply of each query.
+constexpr long long number_of_reply_elements = 3;  // NOLINT
+
+/// Close a connection the batch stopped reading, since the replies left on it
+/// would be read by the next query. Always returns false.
+bool CloseBrokenConnection(int connection) {
+  kdb_wrapper::CloseConnection(connection);
+  return false;
+}
+
+/// Run the mixed list of queries, and split the reply into results.
+bool RunQueryList(int connection, void* query_list,
+                  std::size_t number_of_queries, void** results) {
+  std::fill_n(results, number_of_queries, nullptr);
+
+  // k releases the argument.
+  void* reply = kdb_wrapper::RunQueryOnConnection(connection, coalesce_function,
+                                                  query_list);
+  if (reply == nullptr) {
+    return false;
+  }
+  kdb_wrapper::DecreaseReferenceCountGuard guard(reply);
+  if (!accessors::IsMixedVector(reply) ||
+      static_cast<std::size_t>(kdb_wrapper::GetNumberOfVectorElements(
+          reply)) != number_of_queries) {
+    return false;
+  }
+
+  void** query_replies = accessors::GetVector<void*>(reply);
+  // Check the whole reply first, so nothing is handed out if it's malformed.
+  for (std::size_t i = 0; i < number_of_queries; i++) {
+    void* query_reply = query_replies[i];
+    if (!accessors::IsMixedVector(query_reply) ||
+        kdb_wrapper::GetNumberOfVectorElements(query_reply) !=
+            number_of_reply_elements ||
+        kdb_wrapper::GetQTypeId(accessors::GetVector<void*>(query_reply)[0]) !=
+            -q_types::q_boolean_type_id) {
+      return false;
+    }
+  }
+
+  for (std::size_t i = 0; i < number_of_queries; i++) {
+    void** elements = accessors::GetVector<void*>(query_replies[i]);
+    if (accessors::GetValue<bool>(elements[0])) {
+      // Keep the result alive after the reply is released.
+      results[i] = kdb_wrapper::IncreaseReferenceCount(elements[1]);
+    } else {
+      // The error message is a char vector.
+      results[i] = kdb_wrapper::CreateError(
+          accessors::GetStringFromCharVector(elements[1]).c_str());
+    }
+  }
+  return true;
+}
+}  // namespace
+
+bool RunQueryBatch(int connection, const char* const* queries,
+                   std::size_t number_of_queries, void** results) {
+  std::fill_n(results, number_of_queries, nullptr);
+
+  // Write all the queries first. The request id is the index in the batch.
+  std::size_t number_of_sent = 0;
+  for (; number_of_sent < number_of_queries; number_of_sent++) {
+    if (!async_query::SendQueryWithReply(connection, number_of_sent,
+                                         queries[number_of_sent])) {
+      break;
+    }
+  }
+
+  // Now read the replies, which are sent back in order.
+  for (std::size_t i = 0; i < number_of_sent; i++) {
+    void* message = kdb_wrapper::ReadMessageFromConnection(connection);
+    std::int64_t request_id;
+    void* result;
+    if (!async_query::UnpackReply(message, &request_id, &result)) {
+      // Connection is lost, or something else is sent on this connection.
+      return CloseBrokenConnection(connection);
+    }
+    // Each query gets exactly one reply, so a reply for a slot already
+    // filled is not ours, and would leave another slot unfilled.
+    if (request_id < 0 ||
+        static_cast<std::size_t>(request_id) >= number_of_sent ||
+        results[request_id] != nullptr) {
+      kdb_wrapper::DecreaseReferenceCount(result);
+      return CloseBrokenConnection(connection);
+    }
+    results[request_id] = result;
+  }
+
+  if (number_of_sent != number_of_queries) {
+    return CloseBrokenConnection(connection);
+  }
+  return true;
+}
+
+std::vector<void*> RunQueryBatch(int connection,
+                                 const std::vector<std::string>& queries) {
+  std::vector<const char*> query_pointers(queries.size());
+  for (std::size_t i = 0; i < queries.size(); i++) {
+    query_pointers[i] = queries[i].c_str();
+  }
+  std::vector<void*> results(queries.size(), nullptr);
+  RunQueryBatch(connection, query_pointers.data(), query_pointers.size(),
+                results.data());
+  return results;
+}
+
+bool RunQueryCoalesced(int connection, const char* const* queries,
+                       std::size_t number_of_queries, void** results) {
+  void* query_list = kdb_wrapper::CreateVector(q_types::q_mixed_type_id,
+                                               number_of_queries);
+  void** query_list_elements = accessors::GetVector<void*>(query_list);
+  for (std::size_t i = 0; i < number_of_queries; i++) {
+    query_list_elements[i] = kdb_wrapper::CreateCharVector(queries[i]);
+  }
+  return RunQueryList(connection, query_list, number_of_queries, results);
+}
+
+bool RunQueryCoalesced(int connection, void* const* queries,
+                       std::size_t number_of_queries, void** results) {
+  void* query_list = kdb_wrapper::CreateVector(q_types::q_mixed_type_id,
+                                               number_of_queries);
+  void** query_list_elements = accessors::GetVector<void*>(query_list);
+  for (std::size_t i = 0; i < number_of_queries; i++) {
+    // The list releases its elements, so take a reference on each.
+    query_list_elements[i] = kdb_wrapper::IncreaseReferenceCount(queries[i]);
+  }
+  return RunQueryList(connection, query_list, number_of_queries, results);
+}
+
+std::vector<void*> RunQueryCoalesced(int connection,
+                                     const std::vector<std::string>& queries) {
+  std::vector<const char*> query_pointers(queries.size());
+  for (std::size_t i = 0; i < queries.size(); i++) {
+    query_pointers[i] = queries[i].c_str();
+  }
+  std::vector<void*> results(queries.size(), nullptr);
+  RunQueryCoalesced(connection, query_pointers.data(), query_pointers.size(),
+                    results.data());
+  return results;
+}
+}  // namespace cpp2kdb::batch_query
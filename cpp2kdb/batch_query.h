@@ -0,0 +1,103 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_BATCH_QUERY_H__
+#define CPP2KDB_BATCH_QUERY_H__
+/// \file cpp2kdb/batch_query.h
+/// Run many independent queries with one round trip.
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// Batches of queries on connections opened by kdb_wrapper::OpenConnection.
+namespace cpp2kdb::batch_query {
+/// Run a batch of queries on a connection, pipelined.
+///
+/// All the queries are written to the connection before any reply is read, so
+/// the whole batch pays for one network round trip instead of one per query.
+/// The queries are sent with async_query::SendQueryWithReply, so the
+/// connection must not have any other reply pending.
+///
+/// Each result is owned by the caller and must be released with
+/// kdb_wrapper::DecreaseReferenceCount. A query failing on the server gives an
+/// error object (type -128), and does not stop the rest of the batch.
+/// \returns false if the connection is lost or a reply is not as expected,
+/// such as a second reply for the same query, and the results not received
+/// are set to nullptr. The connection is then closed, since the replies not
+/// read would be read by the next query, and must not be used again.
+bool RunQueryBatch(
+    /// Handle
+    int connection,
+    /// [in] Queries to run.
+    const char* const* queries,
+    /// Number of queries.
+    std::size_t number_of_queries,
+    /// [out] Results, in the same order as queries. Memory must hold
+    /// number_of_queries elements.
+    void** results);
+
+/// Run a batch of queries on a connection, pipelined.
+///
+/// Same as above, returning the results in a vector in the same order as
+/// queries. Results not received because the connection is lost are nullptr,
+/// and the connection is closed.
+std::vector<void*> RunQueryBatch(
+    /// Handle
+    int connection,
+    /// Queries to run.
+    const std::vector<std::string>& queries);
+
+/// Run a batch of queries on a connection, coalesced into one query.
+///
+/// Unlike RunQueryBatch, which still sends one message per query, this sends
+/// the queries as one mixed list of strings, evaluates them with value on the
+/// server, and gets all the results back in one mixed list, which is then
+/// split into one result per query. This saves both the messages and the
+/// dispatch overhead on the server, but the queries are evaluated one after
+/// another in the same call on the server.
+///
+/// Each result is owned by the caller and must be released with
+/// kdb_wrapper::DecreaseReferenceCount. A query failing on the server gives an
+/// error object (type -128), and does not stop the rest of the batch.
+/// \returns false if the connection is lost or the reply is not as expected,
+/// and all the results are set to nullptr.
+bool RunQueryCoalesced(
+    /// Handle
+    int connection,
+    /// [in] Queries to run.
+    const char* const* queries,
+    /// Number of queries.
+    std::size_t number_of_queries,
+    /// [out] Results, in the same order as queries. Memory must hold
+    /// number_of_queries elements.
+    void** results);
+
+/// Run a batch of queries on a connection, coalesced into one query.
+///
+/// Same as above, but the queries are K objects that can be evaluated by
+/// value, such as char vectors or parse trees. The caller keeps the ownership
+/// of the queries.
+bool RunQueryCoalesced(
+    /// Handle
+    int connection,
+    /// [in] Queries to run.
+    void* const* queries,
+    /// Number of queries.
+    std::size_t number_of_queries,
+    /// [out] Results, in the same order as queries. Memory must hold
+    /// number_of_queries elements.
+    void** results);
+
+/// Run a batch of queries on a connection, coalesced into one query.
+///
+/// Same as above, returning the results in a vector in the same order as
+/// queries. All the results are nullptr if the batch failed.
+std::vector<void*> RunQueryCoalesced(
+    /// Handle
+    int connection,
+    /// Queries to run.
+    const std::vector<std::string>& queries);
+}  // namespace cpp2kdb::batch_query
+#endif  // CPP2KDB_BATCH_QUERY_H__
@@ -0,0 +1,92 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "cpp2kdb/batch_query.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+// Requires a running KDB+ instance on localhost at port 5000.
+namespace {
+/// Connection shared by all the benchmarks.
+int GetConnection() {
+  static int connection =
+      cpp2kdb::kdb_wrapper::OpenConnection("127.0.0.1", 5000, "");
+  return connection;
+}
+
+/// Small lookups, like the ones issued one after another by the services.
+std::vector<std::string> MakeQueries(std::size_t number_of_queries) {
+  std::vector<std::string> queries;
+  for (std::size_t i = 0; i < number_of_queries; i++) {
+    queries.push_back("til " + std::to_string(i % 16));
+  }
+  return queries;
+}
+
+void BM_SequentialQueries(benchmark::State& state) {
+  int connection = GetConnection();
+  if (connection <= 0) {
+    state.SkipWithError("Cannot connect to 127.0.0.1:5000");
+    return;
+  }
+  std::vector<std::string> queries = MakeQueries(state.range(0));
+  for (auto _ : state) {
+    for (const std::string& query : queries) {
+      void* result =
+          cpp2kdb::kdb_wrapper::RunQueryOnConnection(connection, query.c_str());
+      if (result != nullptr) {
+        cpp2kdb::kdb_wrapper::DecreaseReferenceCount(result);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+BENCHMARK(BM_SequentialQueries)->RangeMultiplier(4)->Range(1, 1024);
+
+void BM_BatchQueries(benchmark::State& state) {
+  int connection = GetConnection();
+  if (connection <= 0) {
+    state.SkipWithError("Cannot connect to 127.0.0.1:5000");
+    return;
+  }
+  std::vector<std::string> queries = MakeQueries(state.range(0));
+  for (auto _ : state) {
+    std::vector<void*> results =
+        cpp2kdb::batch_query::RunQueryBatch(connection, queries);
+    for (void* result : results) {
+      if (result != nullptr) {
+        cpp2kdb::kdb_wrapper::DecreaseReferenceCount(result);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+BENCHMARK(BM_BatchQueries)->RangeMultiplier(4)->Range(1, 1024);
+
+void BM_CoalescedQueries(benchmark::State& state) {
+  int connection = GetConnection();
+  if (connection <= 0) {
+    state.SkipWithError("Cannot connect to 127.0.0.1:5000");
+    return;
+  }
+  std::vector<std::string> queries = MakeQueries(state.range(0));
+  for (auto _ : state) {
+    std::vector<void*> results =
+        cpp2kdb::batch_query::RunQueryCoalesced(connection, queries);
+    for (void* result : results) {
+      if (result != nullptr) {
+        cpp2kdb::kdb_wrapper::DecreaseReferenceCount(result);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+BENCHMARK(BM_CoalescedQueries)->RangeMultiplier(4)->Range(1, 1024);
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,86 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/batch_query.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+
+namespace {
+void TestBatch(int connection) {
+  std::vector<std::string> queries = {"1 + 1", "til 5", "`a`b`c", "1 + `a",
+                                      "\"abc\""};
+  std::vector<void*> results =
+      cpp2kdb::batch_query::RunQueryBatch(connection, queries);
+  for (std::size_t i = 0; i < results.size(); i++) {
+    if (results[i] == nullptr) {
+      std::cout << "Result of " << queries[i] << " is nullptr" << std::endl;
+      continue;
+    }
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(results[i]);
+    std::cout << "Type of result of " << queries[i] << " is "
+              << cpp2kdb::kdb_wrapper::GetQTypeId(results[i]) << std::endl;
+  }
+}
+
+void TestLargeBatch(int connection) {
+  constexpr int number_of_queries = 1000;
+  std::vector<std::string> queries;
+  for (int i = 0; i < number_of_queries; i++) {
+    queries.push_back(std::to_string(i));
+  }
+  std::vector<void*> results =
+      cpp2kdb::batch_query::RunQueryBatch(connection, queries);
+  int number_of_correct = 0;
+  for (int i = 0; i < number_of_queries; i++) {
+    if (results[i] == nullptr) {
+      continue;
+    }
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(results[i]);
+    if (cpp2kdb::accessors::GetValue<std::int64_t>(results[i]) == i) {
+      number_of_correct++;
+    }
+  }
+  std::cout << "Correct results in order: " << number_of_correct << " out of "
+            << number_of_queries << std::endl;
+}
+
+void TestCoalesced(int connection) {
+  std::vector<std::string> queries = {"1 + 1", "2 + 2", "1b", "1 + `a",
+                                      "`a`b`c"};
+  std::vector<void*> results =
+      cpp2kdb::batch_query::RunQueryCoalesced(connection, queries);
+  for (std::size_t i = 0; i < results.size(); i++) {
+    if (results[i] == nullptr) {
+      std::cout << "Result of " << queries[i] << " is nullptr" << std::endl;
+      continue;
+    }
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(results[i]);
+    std::cout << "Type of coalesced result of " << queries[i] << " is "
+              << cpp2kdb::kdb_wrapper::GetQTypeId(results[i]) << std::endl;
+  }
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  // Open connection
+  int connection = cpp2kdb::kdb_wrapper::OpenConnection("127.0.0.1", 5000, "");
+
+  if (connection <= 0) {
+    std::cerr << "Connection error: " << connection << std::endl;
+    return 1;
+  }
+
+  TestBatch(connection);
+  std::cout << "----------------------" << std::endl;
+  TestLargeBatch(connection);
+  std::cout << "----------------------" << std::endl;
+  TestCoalesced(connection);
+
+  cpp2kdb::kdb_wrapper::CloseConnection(connection);
+  return 0;
+}
@@ -0,0 +1,222 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/connection_pool.h"
+
+#include <thread>
+#include <utility>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace cpp2kdb::connection_pool {
+namespace {
+/// Query used for health check. :: is the generic null and is cheap to
+/// evaluate and send back.
+constexpr const char* health_check_query = "::";
+}  // namespace
+
+ConnectionLease::ConnectionLease()
+    : pool(nullptr), slot_index(0), connection(0) {
+  // do nothing here
+}
+
+ConnectionLease::ConnectionLease(ConnectionPool* pool, std::size_t slot_index,
+                                 int connection)
+    : pool(pool), slot_index(slot_index), connection(connection) {
+  // do nothing here
+}
+
+ConnectionLease::ConnectionLease(ConnectionLease&& other) noexcept
+    : pool(other.pool),
+      slot_index(other.slot_index),
+      connection(other.connection) {
+  other.pool = nullptr;
+}
+
+ConnectionLease& ConnectionLease::operator=(ConnectionLease&& other) noexcept {
+  if (this != &other) {
+    this->Release();
+    this->pool = other.pool;
+    this->slot_index = other.slot_index;
+    this->connection = other.connection;
+    other.pool = nullptr;
+  }
+  return *this;
+}
+
+ConnectionLease::~ConnectionLease() { this->Release(); }
+
+bool ConnectionLease::IsValid() const { return this->pool != nullptr; }
+
+int ConnectionLease::GetConnection() const { return this->connection; }
+
+void ConnectionLease::MarkBroken() {
+  if (this->pool == nullptr) {
+    return;
+  }
+  this->pool->CloseSlotConnection(&this->pool->slots[this->slot_index]);
+  this->connection = 0;
+}
+
+async_query::DeadlineResult ConnectionLease::RunQuery(
+    const char* query, std::chrono::milliseconds timeout, void** result) {
+  *result = nullptr;
+  if (this->connection <= 0) {
+    return async_query::DeadlineResult::ConnectionLost;
+  }
+  async_query::DeadlineResult deadline_result =
+      async_query::RunQueryWithDeadline(
+          this->connection, query, std::chrono::steady_clock::now() + timeout,
+          result);
+  if (deadline_result != async_query::DeadlineResult::Ok) {
+    // The connection is poisoned by the reply still to come.
+    this->MarkBroken();
+  }
+  return deadline_result;
+}
+
+void ConnectionLease::Release() {
+  // Only return if this lease holds a connection.
+  if (this->pool != nullptr) {
+    this->pool->ReturnSlot(this->slot_index, this->connection);
+    this->pool = nullptr;
+  }
+}
+
+ConnectionPool::ConnectionPool(ConnectionOptions options, std::size_t pool_size)
+    : options(std::move(options)),
+      pool_size(pool_size),
+      slots(new Slot[pool_size]) {
+  // do nothing here
+}
+
+ConnectionPool::~ConnectionPool() {
+  for (std::size_t i = 0; i < this->pool_size; i++) {
+    this->CloseSlotConnection(&this->slots[i]);
+  }
+}
+
+std::size_t ConnectionPool::Open() {
+  std::size_t number_of_opened = 0;
+  for (std::size_t i = 0; i < this->pool_size; i++) {
+    // Skip the slots that are in use.
+    if (!this->TryAcquireSlot(i)) {
+      continue;
+    }
+    Slot* slot = &this->slots[i];
+    if (this->EnsureConnected(slot)) {
+      number_of_opened++;
+    }
+    this->ReturnSlot(i, slot->connection);
+  }
+  return number_of_opened;
+}
+
+ConnectionLease ConnectionPool::TryCheckout() {
+  // Start from a different slot every time, so the connections are used
+  // evenly and threads don't all fight for the first slot.
+  std::size_t start =
+      this->next_slot_index.fetch_add(1, std::memory_order_relaxed);
+  for (std::size_t i = 0; i < this->pool_size; i++) {
+    std::size_t slot_index = (start + i) % this->pool_size;
+    if (!this->TryAcquireSlot(slot_index)) {
+      continue;
+    }
+    Slot* slot = &this->slots[slot_index];
+    if (!this->EnsureConnected(slot)) {
+      // Cannot connect, put it back and try the next one.
+      this->ReturnSlot(slot_index, slot->connection);
+      continue;
+    }
+    return ConnectionLease(this, slot_index, slot->connection);
+  }
+  return ConnectionLease();
+}
+
+ConnectionLease ConnectionPool::Checkout(std::chrono::milliseconds time_out) {
+  auto deadline = std::chrono::steady_clock::now() + time_out;
+  while (true) {
+    ConnectionLease lease = this->TryCheckout();
+    if (lease.IsValid() || std::chrono::steady_clock::now() >= deadline) {
+      return lease;
+    }
+    std::this_thread::yield();
+  }
+}
+
+std::size_t ConnectionPool::CheckHealth() {
+  std::size_t number_of_healthy = 0;
+  for (std::size_t i = 0; i < this->pool_size; i++) {
+    // Skip the slots that are in use.
+    if (!this->TryAcquireSlot(i)) {
+      continue;
+    }
+    Slot* slot = &this->slots[i];
+    if (slot->connection > 0) {
+      void* result = kdb_wrapper::RunQueryOnConnection(slot->connection,
+                                                       health_check_query);
+      // nullptr is returned when the connection is lost.
+      if (result == nullptr) {
+        this->CloseSlotConnection(slot);
+      } else {
+        if (accessors::IsError(result)) {
+          this->CloseSlotConnection(slot);
+        }
+        kdb_wrapper::DecreaseReferenceCount(result);
+      }
+    }
+    if (this->EnsureConnected(slot)) {
+      number_of_healthy++;
+    }
+    this->ReturnSlot(i, slot->connection);
+  }
+  return number_of_healthy;
+}
+
+std::size_t ConnectionPool::GetPoolSize() const { return this->pool_size; }
+
+std::size_t ConnectionPool::GetNumberOfIdleConnections() const {
+  std::size_t number_of_idle = 0;
+  for (std::size_t i = 0; i < this->pool_size; i++) {
+    if (this->slots[i].state.load(std::memory_order_relaxed) ==
+        SlotState::Idle) {
+      number_of_idle++;
+    }
+  }
+  return number_of_idle;
+}
+
+bool ConnectionPool::TryAcquireSlot(std::size_t slot_index) {
+  SlotState expected = SlotState::Idle;
+  // Acquire, so the connection written by the last owner is visible.
+  return this->slots[slot_index].state.compare_exchange_strong(
+      expected, SlotState::Leased, std::memory_order_acquire,
+      std::memory_order_relaxed);
+}
+
+bool ConnectionPool::EnsureConnected(Slot* slot) {
+  if (slot->connection <= 0) {
+    slot->connection = kdb_wrapper::OpenConnection(
+        this->options.host.c_str(), this->options.port,
+        this->options.username_password.c_str(), this->options.time_out,
+        this->options.capacity);
+  }
+  return slot->connection > 0;
+}
+
+void ConnectionPool::CloseSlotConnection(Slot* slot) {
+  if (slot->connection > 0) {
+    kdb_wrapper::CloseConnection(slot->connection);
+  }
+  slot->connection = 0;
+}
+
+void ConnectionPool::ReturnSlot(std::size_t slot_index, int connection) {
+  Slot* slot = &this->slots[slot_index];
+  slot->connection = connection;
+  // Release, so the next owner sees the connection.
+  slot->state.store(SlotState::Idle, std::memory_order_release);
+}
+}  // namespace cpp2kdb::connection_pool
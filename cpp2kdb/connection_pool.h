@@ -0,0 +1,186 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_CONNECTION_POOL_H__
+#define CPP2KDB_CONNECTION_POOL_H__
+/// \file cpp2kdb/connection_pool.h
+/// A bounded pool of pre-opened connections to KDB.
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "cpp2kdb/async_query.h"
+
+/// Pool of connections opened by kdb_wrapper::OpenConnection.
+namespace cpp2kdb::connection_pool {
+/// Parameters passed to kdb_wrapper::OpenConnection for every connection in
+/// the pool.
+struct ConnectionOptions {
+  /// host name to connect to.
+  std::string host;
+  /// port number to connect to.
+  int port = 0;
+  /// username and password in the format of "username:password"
+  std::string username_password;
+  /// Timeout in milliseconds.
+  int time_out = 0;
+  /// Capacity. See kdb_wrapper::OpenConnection.
+  int capacity = 0;
+};
+
+class ConnectionPool;
+
+/// Lease on one connection checked out from ConnectionPool.
+///
+/// The connection is returned to the pool when the lease is destructed. A
+/// lease can be moved but not copied, so exactly one owner uses the handle at a
+/// time. An empty lease (IsValid() returns false) is returned when the pool has
+/// no connection available.
+class ConnectionLease {
+ public:
+  /// Create an empty lease.
+  ConnectionLease();
+  /// Move constructor. other becomes empty.
+  ConnectionLease(ConnectionLease&& other) noexcept;
+  /// Move assignment. The connection currently held is returned first.
+  ConnectionLease& operator=(ConnectionLease&& other) noexcept;
+  /// Copy constructor is deleted.
+  ConnectionLease(const ConnectionLease&) = delete;
+  /// assignment operator is deleted.
+  ConnectionLease& operator=(const ConnectionLease&) = delete;
+
+  /// Destructor, returning the connection to the pool.
+  ~ConnectionLease();
+
+  /// Check if this lease holds a connection.
+  bool IsValid() const;
+
+  /// Get the handle to use with kdb_wrapper::RunQueryOnConnection.
+  int GetConnection() const;
+
+  /// Mark the connection as broken.
+  ///
+  /// The handle is closed right away, and the pool opens a new connection next
+  /// time the slot is checked out. Use this when a query returns nullptr (which
+  /// is what k returns on network error) or the state of the connection is
+  /// unknown.
+  void MarkBroken();
+
+  /// Run a query on the connection, giving up after timeout.
+  ///
+  /// Unlike kdb_wrapper::RunQueryOnConnection, this never blocks past the
+  /// timeout waiting for the reply. When the query times out or the connection
+  /// is lost, the connection is marked broken, since the reply may still
+  /// arrive, and the pool opens a new connection for the slot. See
+  /// async_query::RunQueryWithDeadline.
+  async_query::DeadlineResult RunQuery(
+      /// Query
+      const char* query,
+      /// Time to wait for the reply.
+      std::chrono::milliseconds timeout,
+      /// [out] Result owned by the caller when Ok. nullptr otherwise.
+      void** result);
+
+  /// Return the connection to the pool before the lease is destructed.
+  void Release();
+
+ private:
+  friend class ConnectionPool;
+  ConnectionLease(ConnectionPool* pool, std::size_t slot_index, int connection);
+
+  ConnectionPool* pool;
+  std::size_t slot_index;
+  int connection;
+};
+
+/// A bounded pool of pre-opened connections.
+///
+/// Checking out and returning a connection are lock free: each slot of the
+/// pool carries an atomic state, and checking out is a compare and swap on the
+/// state of the first idle slot found. Broken connections are reopened when
+/// their slot is checked out or by CheckHealth, never while holding other
+/// slots.
+///
+/// A handle must not be used by two threads at the same time, which is what
+/// ConnectionLease guarantees. The pool must outlive all the leases.
+class ConnectionPool {
+ public:
+  /// Create a pool of pool_size connections. No connection is opened until
+  /// Open is called.
+  ConnectionPool(ConnectionOptions options, std::size_t pool_size);
+  /// Default constructor is deleted.
+  ConnectionPool() = delete;
+  /// Copy constructor is deleted.
+  ConnectionPool(const ConnectionPool&) = delete;
+  /// assignment operator is deleted.
+  ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+  /// Destructor, closing all the connections.
+  ~ConnectionPool();
+
+  /// Open all the connections.
+  ///
+  /// \returns Number of connections opened successfully. Slots that failed to
+  /// open are retried when they are checked out.
+  std::size_t Open();
+
+  /// Try to check out a connection without waiting.
+  ///
+  /// \returns An empty lease if all connections are in use or the connection
+  /// in the idle slot cannot be opened.
+  ConnectionLease TryCheckout();
+
+  /// Check out a connection, waiting up to time_out for one to be returned.
+  ///
+  /// \returns An empty lease if no connection became available in time.
+  ConnectionLease Checkout(std::chrono::milliseconds time_out);
+
+  /// Check the idle connections by running a trivial query on them.
+  ///
+  /// Connections failing the check are closed and reopened. Connections in use
+  /// are skipped.
+  /// \returns Number of idle connections that are healthy after the check.
+  std::size_t CheckHealth();
+
+  /// Get the number of connections in the pool.
+  std::size_t GetPoolSize() const;
+
+  /// Get the number of connections not checked out right now.
+  std::size_t GetNumberOfIdleConnections() const;
+
+ private:
+  friend class ConnectionLease;
+
+  /// State of the slot.
+  enum class SlotState : int { Idle = 0, Leased };
+
+  /// One connection in the pool.
+  struct Slot {
+    /// Idle or Leased. Only the thread that moved the state to Leased can
+    /// access connection.
+    std::atomic<SlotState> state{SlotState::Idle};
+    /// Handle returned by OpenConnection, <= 0 if not connected.
+    int connection = 0;
+  };
+
+  /// Try to move slot from Idle to Leased.
+  bool TryAcquireSlot(std::size_t slot_index);
+  /// Open the connection of an acquired slot if it is not connected.
+  bool EnsureConnected(Slot* slot);
+  /// Close the connection of an acquired slot.
+  void CloseSlotConnection(Slot* slot);
+  /// Return the slot to the pool.
+  void ReturnSlot(std::size_t slot_index, int connection);
+
+  ConnectionOptions options;
+  std::size_t pool_size;
+  std::unique_ptr<Slot[]> slots;
+  /// Where the next checkout starts looking, to spread the load.
+  std::atomic<std::size_t> next_slot_index{0};
+};
+}  // namespace cpp2kdb::connection_pool
+#endif  // CPP2KDB_CONNECTION_POOL_H__
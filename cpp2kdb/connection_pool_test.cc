@@ -0,0 +1,142 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/connection_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+
+namespace {
+void TestCheckout(cpp2kdb::connection_pool::ConnectionPool* pool) {
+  std::cout << "Idle connections before checkout: "
+            << pool->GetNumberOfIdleConnections() << std::endl;
+  {
+    cpp2kdb::connection_pool::ConnectionLease lease = pool->TryCheckout();
+    std::cout << "Lease is valid? " << (lease.IsValid() ? "Yes" : "No")
+              << std::endl;
+    std::cout << "Idle connections with one lease: "
+              << pool->GetNumberOfIdleConnections() << std::endl;
+    void* result = cpp2kdb::kdb_wrapper::RunQueryOnConnection(
+        lease.GetConnection(), "4 * 5 + 6");
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(result);
+    std::cout << "Result of 4 * 5 + 6 is "
+              << cpp2kdb::accessors::GetValue<std::int64_t>(result)
+              << std::endl;
+  }
+  std::cout << "Idle connections after lease is destructed: "
+            << pool->GetNumberOfIdleConnections() << std::endl;
+}
+
+void TestExhaustion(cpp2kdb::connection_pool::ConnectionPool* pool) {
+  std::vector<cpp2kdb::connection_pool::ConnectionLease> leases;
+  for (std::size_t i = 0; i < pool->GetPoolSize(); i++) {
+    leases.push_back(pool->TryCheckout());
+  }
+  cpp2kdb::connection_pool::ConnectionLease extra =
+      pool->Checkout(std::chrono::milliseconds(10));
+  std::cout << "Lease is valid when pool is exhausted? "
+            << (extra.IsValid() ? "Yes" : "No") << std::endl;
+}
+
+void TestBrokenConnection(cpp2kdb::connection_pool::ConnectionPool* pool) {
+  {
+    cpp2kdb::connection_pool::ConnectionLease lease = pool->TryCheckout();
+    lease.MarkBroken();
+  }
+  std::cout << "Healthy connections after one is marked broken: "
+            << pool->CheckHealth() << std::endl;
+}
+
+void TestDeadline(cpp2kdb::connection_pool::ConnectionPool* pool) {
+  {
+    cpp2kdb::connection_pool::ConnectionLease lease = pool->TryCheckout();
+    void* result;
+    cpp2kdb::async_query::DeadlineResult deadline_result = lease.RunQuery(
+        "system \"sleep 1\"", std::chrono::milliseconds(100), &result);
+    std::cout << "Sleeping 1 second with 100ms timeout: " << deadline_result
+              << std::endl;
+    std::cout << "Lease holds a connection after timeout? "
+              << (lease.GetConnection() > 0 ? "Yes" : "No") << std::endl;
+  }
+  // The slot is reopened when it is checked out again.
+  std::cout << "Healthy connections after timeout: " << pool->CheckHealth()
+            << std::endl;
+  cpp2kdb::connection_pool::ConnectionLease lease = pool->TryCheckout();
+  void* result;
+  cpp2kdb::async_query::DeadlineResult deadline_result =
+      lease.RunQuery("4 * 5 + 6", std::chrono::milliseconds(1000), &result);
+  if (deadline_result == cpp2kdb::async_query::DeadlineResult::Ok) {
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(result);
+    std::cout << "Result of 4 * 5 + 6 with 1 second timeout is "
+              << cpp2kdb::accessors::GetValue<std::int64_t>(result)
+              << std::endl;
+  } else {
+    std::cout << "4 * 5 + 6 with 1 second timeout: " << deadline_result
+              << std::endl;
+  }
+}
+
+void TestConcurrentQueries(cpp2kdb::connection_pool::ConnectionPool* pool) {
+  constexpr int number_of_threads = 8;
+  constexpr int number_of_queries_per_thread = 100;
+  std::atomic<int> number_of_succeeded{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < number_of_threads; t++) {
+    threads.emplace_back([pool, &number_of_succeeded]() {
+      for (int i = 0; i < number_of_queries_per_thread; i++) {
+        cpp2kdb::connection_pool::ConnectionLease lease =
+            pool->Checkout(std::chrono::milliseconds(1000));
+        if (!lease.IsValid()) {
+          continue;
+        }
+        void* result = cpp2kdb::kdb_wrapper::RunQueryOnConnection(
+            lease.GetConnection(), "til 10");
+        if (result == nullptr) {
+          lease.MarkBroken();
+          continue;
+        }
+        cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(result);
+        if (cpp2kdb::kdb_wrapper::GetNumberOfVectorElements(result) == 10) {
+          number_of_succeeded++;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::cout << "Succeeded queries: " << number_of_succeeded << " out of "
+            << number_of_threads * number_of_queries_per_thread << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  cpp2kdb::connection_pool::ConnectionOptions options;
+  options.host = "127.0.0.1";
+  options.port = 5000;
+  cpp2kdb::connection_pool::ConnectionPool pool(options, 4);
+
+  std::size_t number_of_opened = pool.Open();
+  if (number_of_opened != pool.GetPoolSize()) {
+    std::cerr << "Only opened " << number_of_opened << " connections"
+              << std::endl;
+    return 1;
+  }
+
+  TestCheckout(&pool);
+  std::cout << "----------------------" << std::endl;
+  TestExhaustion(&pool);
+  std::cout << "----------------------" << std::endl;
+  TestBrokenConnection(&pool);
+  std::cout << "----------------------" << std::endl;
+  TestDeadline(&pool);
+  std::cout << "----------------------" << std::endl;
+  TestConcurrentQueries(&pool);
+  return 0;
+}
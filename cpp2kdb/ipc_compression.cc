@@ -0,0 +1,304 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/ipc_compression.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace cpp2kdb::ipc_compression {
+namespace {
+/// Size of the message header.
+constexpr std::size_t message_header_size = 8;
+
+/// Number of items following a flag byte.
+constexpr int items_per_group = 8;
+
+/// Largest number of bytes a back reference copies.
+constexpr std::size_t max_copy_size = 2 + 255;
+
+/// Back references in the middle of a message are copied in chunks of this
+/// size, writing up to a chunk past the end of the copy.
+constexpr std::size_t copy_chunk_size = 16;
+
+/// Largest number of bytes of a group in the compressed stream.
+constexpr std::size_t max_group_size = 1 + 2 * items_per_group;
+
+/// Table of the last position each hash of two consecutive bytes is seen at.
+/// Position 0 means not seen, which is in the message header.
+using PositionTable = std::uint32_t[256];
+
+/// Read a little endian 32 bit int. The host is assumed to be little endian.
+std::uint32_t ReadUInt32(const char* data) {
+  std::uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+/// Write a little endian 32 bit int.
+void WriteUInt32(std::uint32_t value, char* data) {
+  std::memcpy(data, &value, sizeof(value));
+}
+
+/// Record positions [*position, end) in the table, and move position to end.
+///
+/// Both compressor and decompressor must record exactly the same positions,
+/// so this is shared.
+inline void RecordPositions(const unsigned char* data, std::size_t end,
+                            std::size_t* position, PositionTable positions) {
+  std::size_t p = *position;
+  for (; p < end; p++) {
+    positions[data[p] ^ data[p + 1]] = static_cast<std::uint32_t>(p);
+  }
+  *position = p;
+}
+
+/// Copy size bytes from source position to destination position of data.
+///
+/// The source may overlap with the destination, where the bytes written
+/// earlier in the same copy are repeated.
+inline void CopyBackReference(unsigned char* data, std::size_t source,
+                              std::size_t destination, std::size_t size) {
+  if (source + size <= destination) {
+    std::memcpy(data + destination, data + source, size);
+  } else {
+    for (std::size_t i = 0; i < size; i++) {
+      data[destination + i] = data[source + i];
+    }
+  }
+}
+
+/// Same as CopyBackReference, but may write up to copy_chunk_size - 1 bytes
+/// past the end of the copy, which will be overwritten by following items.
+inline void CopyBackReferenceInChunks(unsigned char* data, std::size_t source,
+                                      std::size_t destination,
+                                      std::size_t size) {
+  // Every chunk reads only bytes written before the chunk.
+  if (destination - source >= copy_chunk_size) {
+    for (std::size_t i = 0; i < size; i += copy_chunk_size) {
+      std::memcpy(data + destination + i, data + source + i, copy_chunk_size);
+    }
+  } else {
+    for (std::size_t i = 0; i < size; i++) {
+      data[destination + i] = data[source + i];
+    }
+  }
+}
+}  // namespace
+
+const char* GetCompressionResultName(CompressionResult result) {
+  // Cast result to an int.
+  int temp_result = static_cast<int>(result);
+  // Make sure it's valid.
+  if (temp_result >= 0 && temp_result < number_of_compression_result_names) {
+    return CompressionResultNames[temp_result];
+  } else {
+    return "Invalid";
+  }
+}
+
+std::ostream& operator<<(std::ostream& output, CompressionResult result) {
+  return output << GetCompressionResultName(result);
+}
+
+CompressionResult GetUncompressedSize(const char* message,
+                                      std::size_t message_size,
+                                      std::size_t* uncompressed_size) {
+  if (message_size < compressed_header_size) {
+    return CompressionResult::Truncated;
+  }
+  if (message[2] == 0) {
+    return CompressionResult::NotCompressed;
+  }
+  std::size_t compressed_size = ReadUInt32(message + 4);
+  if (compressed_size < compressed_header_size) {
+    return CompressionResult::Corrupted;
+  }
+  if (compressed_size > message_size) {
+    return CompressionResult::Truncated;
+  }
+  *uncompressed_size = ReadUInt32(message + message_header_size);
+  if (*uncompressed_size < message_header_size) {
+    return CompressionResult::Corrupted;
+  }
+  return CompressionResult::Ok;
+}
+
+CompressionResult Decompress(const char* message, std::size_t message_size,
+                             char* output, std::size_t output_size) {
+  std::size_t uncompressed_size;
+  CompressionResult result =
+      GetUncompressedSize(message, message_size, &uncompressed_size);
+  if (result != CompressionResult::Ok) {
+    return result;
+  }
+  if (output_size < uncompressed_size) {
+    return CompressionResult::OutputTooSmall;
+  }
+
+  const unsigned char* input =
+      reinterpret_cast<const unsigned char*>(message) + compressed_header_size;
+  const unsigned char* input_end =
+      reinterpret_cast<const unsigned char*>(message) + ReadUInt32(message + 4);
+  unsigned char* data = reinterpret_cast<unsigned char*>(output);
+  // kdb decompresses with zeros in place of the header, and a back reference
+  // to a hash never seen reads them. The header is written at the end.
+  std::memset(data, 0, message_header_size);
+
+  PositionTable positions = {};
+  std::size_t s = message_header_size;
+  std::size_t p = message_header_size;
+  while (s < uncompressed_size) {
+    if (input == input_end) {
+      return CompressionResult::Truncated;
+    }
+    unsigned int flags = *input++;
+    if (static_cast<std::size_t>(input_end - input) >= max_group_size - 1 &&
+        uncompressed_size - s >=
+            items_per_group * max_copy_size + copy_chunk_size) {
+      // The whole group fits in both buffers, no need to check every item.
+      if (flags == 0) {
+        // All literals, common for data that does not compress well.
+        std::memcpy(data + s, input, items_per_group);
+        input += items_per_group;
+        s += items_per_group;
+        RecordPositions(data, s - 1, &p, positions);
+        continue;
+      }
+      for (int i = 0; i < items_per_group; i++, flags >>= 1) {
+        if (flags & 1) {
+          std::size_t r = positions[input[0]];
+          std::size_t n = 2 + input[1];
+          input += 2;
+          CopyBackReferenceInChunks(data, r, s, n);
+          RecordPositions(data, s + 1, &p, positions);
+          s += n;
+          p = s;
+        } else {
+          data[s++] = *input++;
+          RecordPositions(data, s - 1, &p, positions);
+        }
+      }
+      continue;
+    }
+
+    // Near the end of either buffer, check every item.
+    for (int i = 0; i < items_per_group && s < uncompressed_size;
+         i++, flags >>= 1) {
+      if (flags & 1) {
+        if (input_end - input < 2) {
+          return CompressionResult::Truncated;
+        }
+        std::size_t r = positions[input[0]];
+        std::size_t n = 2 + input[1];
+        input += 2;
+        if (n > uncompressed_size - s) {
+          return CompressionResult::Corrupted;
+        }
+        CopyBackReference(data, r, s, n);
+        RecordPositions(data, s + 1, &p, positions);
+        s += n;
+        p = s;
+      } else {
+        if (input == input_end) {
+          return CompressionResult::Truncated;
+        }
+        data[s++] = *input++;
+        RecordPositions(data, s - 1, &p, positions);
+      }
+    }
+  }
+
+  // Same header, but not compressed.
+  std::memcpy(output, message, message_header_size);
+  output[2] = 0;
+  WriteUInt32(static_cast<std::uint32_t>(uncompressed_size), output + 4);
+  return CompressionResult::Ok;
+}
+
+CompressionResult Decompress(const char* message, std::size_t message_size,
+                             std::vector<char>* output) {
+  std::size_t uncompressed_size;
+  CompressionResult result =
+      GetUncompressedSize(message, message_size, &uncompressed_size);
+  if (result != CompressionResult::Ok) {
+    return result;
+  }
+  output->resize(uncompressed_size);
+  return Decompress(message, message_size, output->data(), output->size());
+}
+
+CompressionResult Compress(const char* message, std::size_t message_size,
+                           std::vector<char>* output) {
+  if (message_size < message_header_size) {
+    return CompressionResult::Truncated;
+  }
+  if (message[2] != 0) {
+    return CompressionResult::Corrupted;
+  }
+  std::size_t uncompressed_size = ReadUInt32(message + 4);
+  if (uncompressed_size < message_header_size ||
+      uncompressed_size > message_size) {
+    return CompressionResult::Truncated;
+  }
+
+  // Like kdb, give up when the result is not less than half of the message,
+  // so there is always room for a whole group.
+  std::size_t capacity = uncompressed_size / 2;
+  output->resize(capacity + max_group_size);
+  const unsigned char* data = reinterpret_cast<const unsigned char*>(message);
+  unsigned char* compressed = reinterpret_cast<unsigned char*>(output->data());
+
+  PositionTable positions = {};
+  std::size_t s = message_header_size;
+  std::size_t p = message_header_size;
+  std::size_t d = compressed_header_size;
+  while (s < uncompressed_size) {
+    if (d >= capacity) {
+      return CompressionResult::NotCompressible;
+    }
+    std::size_t flag_position = d++;
+    unsigned int flags = 0;
+    for (int i = 0; i < items_per_group && s < uncompressed_size; i++) {
+      // Mirror the decompressor, so only positions it has recorded are used.
+      std::size_t r = 0;
+      unsigned char hash = 0;
+      if (uncompressed_size - s >= 2) {
+        hash = data[s] ^ data[s + 1];
+        r = positions[hash];
+      }
+      if (r != 0 && data[r] == data[s] && data[r + 1] == data[s + 1]) {
+        std::size_t max_n =
+            std::min(max_copy_size, uncompressed_size - s) - 2;
+        std::size_t n = 0;
+        while (n < max_n && data[r + 2 + n] == data[s + 2 + n]) {
+          n++;
+        }
+        compressed[d++] = hash;
+        compressed[d++] = static_cast<unsigned char>(n);
+        flags |= 1u << i;
+        RecordPositions(data, s + 1, &p, positions);
+        s += 2 + n;
+        p = s;
+      } else {
+        compressed[d++] = data[s++];
+        RecordPositions(data, s - 1, &p, positions);
+      }
+    }
+    compressed[flag_position] = static_cast<unsigned char>(flags);
+  }
+  if (d >= capacity) {
+    return CompressionResult::NotCompressible;
+  }
+
+  output->resize(d);
+  std::memcpy(output->data(), message, message_header_size);
+  (*output)[2] = 1;
+  WriteUInt32(static_cast<std::uint32_t>(d), output->data() + 4);
+  WriteUInt32(static_cast<std::uint32_t>(uncompressed_size),
+              output->data() + message_header_size);
+  return CompressionResult::Ok;
+}
+}  // namespace cpp2kdb::ipc_compression
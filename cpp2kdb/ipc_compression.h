@@ -0,0 +1,113 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_IPC_COMPRESSION_H__
+#define CPP2KDB_IPC_COMPRESSION_H__
+/// \file cpp2kdb/ipc_compression.h
+/// Compression scheme of kdb IPC messages.
+///
+/// kdb compresses messages larger than about 2MB sent to remote clients. A
+/// compressed message has the compressed flag (third byte) set, the size of
+/// the compressed message at offset 4, the size of the uncompressed message at
+/// offset 8, and the compressed stream from offset 12.
+///
+/// The stream is a sequence of groups, each is a flag byte followed by 8 items.
+/// Bit i of the flag tells whether item i is a literal byte, or a back
+/// reference of 2 bytes: an index into a table of the positions where each
+/// hash of two consecutive bytes was last seen, and the number of bytes to copy
+/// after the first two.
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+/// Compressing and decompressing kdb IPC messages without k.h
+namespace cpp2kdb::ipc_compression {
+/// Compression Result
+enum class CompressionResult {
+  /// Ok.
+  Ok = 0,
+  /// Buffer ends before the message or the compressed stream does.
+  Truncated,
+  /// Message is not compressed.
+  NotCompressed,
+  /// Output buffer is smaller than the uncompressed message.
+  OutputTooSmall,
+  /// Compressed stream refers to data outside of the uncompressed message.
+  Corrupted,
+  /// Message is not worth compressing, the compressed size is not less than
+  /// half of the message.
+  NotCompressible
+};
+
+/// Names for the enums.
+constexpr const char* CompressionResultNames[] = {
+    "Ok",        "Truncated", "NotCompressed", "OutputTooSmall",
+    "Corrupted", "NotCompressible"};
+
+/// Number of compression result names
+constexpr const int number_of_compression_result_names =
+    sizeof(CompressionResultNames) / sizeof(CompressionResultNames[0]);
+
+/// Get the name from a result
+const char* GetCompressionResultName(CompressionResult result);
+
+/// Overload << for result type `CompressionResult`.
+std::ostream& operator<<(std::ostream& output_stream, CompressionResult result);
+
+/// Size of the header of a compressed message, which is the message header
+/// followed by the size of the uncompressed message.
+constexpr std::size_t compressed_header_size = 12;
+
+/// Get the size of the uncompressed message, including its header.
+CompressionResult GetUncompressedSize(
+    /// [in] Compressed message.
+    const char* message,
+    /// Size of the buffer holding the message.
+    std::size_t message_size,
+    /// [out] Size of the uncompressed message.
+    std::size_t* uncompressed_size);
+
+/// Decompress a message into a buffer provided by the caller.
+///
+/// The output is a complete uncompressed message, with its header, that can
+/// be passed to ipc_decoder::DecodeMessage. The compressed stream is checked,
+/// so malformed input never reads or writes outside of the buffers.
+CompressionResult Decompress(
+    /// [in] Compressed message.
+    const char* message,
+    /// Size of the buffer holding the message.
+    std::size_t message_size,
+    /// [out] Uncompressed message.
+    char* output,
+    /// Size of output. Must be at least the size returned by
+    /// GetUncompressedSize.
+    std::size_t output_size);
+
+/// Decompress a message into a vector.
+///
+/// The vector is resized to the uncompressed size. Its memory is only
+/// allocated when it grows, so reusing the same vector for all the messages
+/// on a connection avoids allocating for every message.
+CompressionResult Decompress(
+    /// [in] Compressed message.
+    const char* message,
+    /// Size of the buffer holding the message.
+    std::size_t message_size,
+    /// [out] Uncompressed message.
+    std::vector<char>* output);
+
+/// Compress a message, the same way kdb does.
+///
+/// This is mostly for testing and replaying, since kdb decides itself whether
+/// to compress what it sends.
+CompressionResult Compress(
+    /// [in] Uncompressed message, including its header.
+    const char* message,
+    /// Size of the buffer holding the message.
+    std::size_t message_size,
+    /// [out] Compressed message.
+    std::vector<char>* output);
+}  // namespace cpp2kdb::ipc_compression
+#endif  // CPP2KDB_IPC_COMPRESSION_H__
@@ -0,0 +1,98 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "cpp2kdb/ipc_compression.h"
+#include "cpp2kdb/q_types.h"
+
+// Messages are built in process, no connection is needed.
+namespace {
+/// Build a message of a timestamp vector of about message_size bytes, with
+/// small random steps between the timestamps like a tick table.
+std::vector<char> MakeMessage(std::size_t message_size) {
+  constexpr std::size_t vector_offset = 8 + 6;
+  std::size_t number_of_elements =
+      (message_size - vector_offset) / sizeof(std::int64_t);
+  std::vector<char> message(vector_offset +
+                            number_of_elements * sizeof(std::int64_t));
+  message[0] = 1;
+  std::uint32_t size = message.size();
+  std::memcpy(message.data() + 4, &size, sizeof(size));
+  message[8] = cpp2kdb::q_types::q_timestamp_type_id;
+  std::uint32_t length = number_of_elements;
+  std::memcpy(message.data() + 10, &length, sizeof(length));
+
+  // Deterministic linear congruential generator.
+  std::uint32_t state = 1;
+  std::int64_t timestamp = 700000000000000000;
+  for (std::size_t i = 0; i < number_of_elements; i++) {
+    state = state * 1664525 + 1013904223;
+    timestamp += state >> 29;
+    std::memcpy(message.data() + vector_offset + i * sizeof(timestamp),
+                &timestamp, sizeof(timestamp));
+  }
+  return message;
+}
+
+/// Copy the uncompressed message, the lower bound of decompression.
+void BM_Copy(benchmark::State& state) {
+  std::vector<char> message = MakeMessage(state.range(0));
+  std::vector<char> output(message.size());
+  for (auto _ : state) {
+    std::memcpy(output.data(), message.data(), message.size());
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * message.size());
+}
+BENCHMARK(BM_Copy)->RangeMultiplier(16)->Range(1 << 20, 1 << 28);
+
+/// Decompress into a buffer allocated once.
+void BM_Decompress(benchmark::State& state) {
+  std::vector<char> compressed;
+  {
+    std::vector<char> message = MakeMessage(state.range(0));
+    if (cpp2kdb::ipc_compression::Compress(message.data(), message.size(),
+                                           &compressed) !=
+        cpp2kdb::ipc_compression::CompressionResult::Ok) {
+      state.SkipWithError("Message is not compressible");
+      return;
+    }
+  }
+  std::vector<char> output;
+  for (auto _ : state) {
+    cpp2kdb::ipc_compression::CompressionResult result =
+        cpp2kdb::ipc_compression::Decompress(compressed.data(),
+                                             compressed.size(), &output);
+    benchmark::DoNotOptimize(result);
+    benchmark::ClobberMemory();
+  }
+  // Throughput is in uncompressed bytes.
+  state.SetBytesProcessed(state.iterations() * output.size());
+  state.counters["ratio"] =
+      static_cast<double>(compressed.size()) / output.size();
+}
+BENCHMARK(BM_Decompress)->RangeMultiplier(16)->Range(1 << 20, 1 << 28);
+
+/// Compress, as kdb does before sending.
+void BM_Compress(benchmark::State& state) {
+  std::vector<char> message = MakeMessage(state.range(0));
+  std::vector<char> compressed;
+  for (auto _ : state) {
+    cpp2kdb::ipc_compression::CompressionResult result =
+        cpp2kdb::ipc_compression::Compress(message.data(), message.size(),
+                                           &compressed);
+    benchmark::DoNotOptimize(result);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * message.size());
+}
+BENCHMARK(BM_Compress)->RangeMultiplier(16)->Range(1 << 20, 1 << 28);
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,156 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/ipc_compression.h"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace {
+/// Serialize til number_of_elements with the given mode into a byte vector.
+void* MakeSerializedVector(int mode, std::size_t number_of_elements) {
+  void* vector = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_long_type_id, number_of_elements);
+  for (std::size_t i = 0; i < number_of_elements; i++) {
+    cpp2kdb::accessors::GetVector<std::int64_t>(vector)[i] = i;
+  }
+  void* bytes = cpp2kdb::kdb_wrapper::Serialize(mode, vector);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCount(vector);
+  return bytes;
+}
+
+bool IsSame(const char* buffer, std::size_t buffer_size,
+            const std::vector<char>& output) {
+  return output.size() == buffer_size &&
+         std::memcmp(buffer, output.data(), buffer_size) == 0;
+}
+
+void TestRoundTrip() {
+  void* bytes = MakeSerializedVector(2, 1000000);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(bytes);
+  const char* buffer = cpp2kdb::accessors::GetVector<char>(bytes);
+  std::size_t buffer_size =
+      cpp2kdb::kdb_wrapper::GetNumberOfVectorElements(bytes);
+
+  std::vector<char> compressed;
+  cpp2kdb::ipc_compression::CompressionResult result =
+      cpp2kdb::ipc_compression::Compress(buffer, buffer_size, &compressed);
+  std::cout << "Compress til 1000000: " << result << ", " << buffer_size
+            << " bytes to " << compressed.size() << " bytes" << std::endl;
+
+  std::size_t uncompressed_size = 0;
+  result = cpp2kdb::ipc_compression::GetUncompressedSize(
+      compressed.data(), compressed.size(), &uncompressed_size);
+  std::cout << "Uncompressed size: " << result << ", " << uncompressed_size
+            << std::endl;
+
+  std::vector<char> output;
+  result = cpp2kdb::ipc_compression::Decompress(
+      compressed.data(), compressed.size(), &output);
+  std::cout << "Decompress: " << result << ", same as serialized? "
+            << (IsSame(buffer, buffer_size, output) ? "Yes" : "No")
+            << std::endl;
+
+  // Smaller output buffer is rejected.
+  result = cpp2kdb::ipc_compression::Decompress(
+      compressed.data(), compressed.size(), output.data(), output.size() - 1);
+  std::cout << "Decompress into smaller buffer: " << result << std::endl;
+}
+
+void TestKdbCompressed() {
+  // Mode 3 lets kdb compress the message.
+  void* bytes = MakeSerializedVector(3, 1000000);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(bytes);
+  void* expected = MakeSerializedVector(2, 1000000);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard expected_guard(expected);
+  const char* buffer = cpp2kdb::accessors::GetVector<char>(bytes);
+  std::size_t buffer_size =
+      cpp2kdb::kdb_wrapper::GetNumberOfVectorElements(bytes);
+
+  std::vector<char> output;
+  cpp2kdb::ipc_compression::CompressionResult result =
+      cpp2kdb::ipc_compression::Decompress(buffer, buffer_size, &output);
+  std::cout << "Decompress message compressed by kdb: " << result;
+  if (result == cpp2kdb::ipc_compression::CompressionResult::Ok) {
+    std::cout << ", same as serialized? "
+              << (IsSame(cpp2kdb::accessors::GetVector<char>(expected),
+                         cpp2kdb::kdb_wrapper::GetNumberOfVectorElements(
+                             expected),
+                         output)
+                      ? "Yes"
+                      : "No");
+  }
+  std::cout << std::endl;
+}
+
+void TestNotCompressible() {
+  // Bytes of a linear congruential generator don't repeat in pairs.
+  std::vector<char> message(1 << 16);
+  std::uint32_t state = 1;
+  for (char& c : message) {
+    state = state * 1664525 + 1013904223;
+    c = static_cast<char>(state >> 24);
+  }
+  message[0] = 1;
+  message[2] = 0;
+  std::uint32_t message_size = message.size();
+  std::memcpy(message.data() + 4, &message_size, sizeof(message_size));
+
+  std::vector<char> compressed;
+  std::cout << "Compress random bytes: "
+            << cpp2kdb::ipc_compression::Compress(message.data(),
+                                                  message.size(), &compressed)
+            << std::endl;
+  std::vector<char> output;
+  std::cout << "Decompress not compressed message: "
+            << cpp2kdb::ipc_compression::Decompress(message.data(),
+                                                    message.size(), &output)
+            << std::endl;
+}
+
+void TestTruncated() {
+  void* bytes = MakeSerializedVector(2, 1000);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(bytes);
+  std::vector<char> compressed;
+  cpp2kdb::ipc_compression::Compress(
+      cpp2kdb::accessors::GetVector<char>(bytes),
+      cpp2kdb::kdb_wrapper::GetNumberOfVectorElements(bytes), &compressed);
+
+  // Cut the stream short, keeping the sizes in the header.
+  std::vector<char> output;
+  std::size_t number_of_rejected = 0;
+  for (std::size_t size = 0; size < compressed.size(); size++) {
+    std::vector<char> truncated(compressed.begin(), compressed.begin() + size);
+    if (size >= 8) {
+      std::uint32_t truncated_size = size;
+      std::memcpy(truncated.data() + 4, &truncated_size,
+                  sizeof(truncated_size));
+    }
+    if (cpp2kdb::ipc_compression::Decompress(
+            truncated.data(), truncated.size(), &output) !=
+        cpp2kdb::ipc_compression::CompressionResult::Ok) {
+      number_of_rejected++;
+    }
+  }
+  std::cout << "Truncated messages rejected: " << number_of_rejected
+            << " out of " << compressed.size() << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  // No connection is needed, objects are built and serialized in process.
+  TestRoundTrip();
+  std::cout << "----------------------" << std::endl;
+  TestKdbCompressed();
+  std::cout << "----------------------" << std::endl;
+  TestNotCompressible();
+  std::cout << "----------------------" << std::endl;
+  TestTruncated();
+  return 0;
+}
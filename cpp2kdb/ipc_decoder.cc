@@ -0,0 +1,404 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/ipc_decoder.h"
+
+namespace cpp2kdb::ipc_decoder {
+namespace {
+/// Objects nested deeper than this are rejected, so a malformed message
+/// cannot run the recursion out of stack.
+constexpr int max_depth = 256;
+
+/// Size of type byte, attribute byte and length of a vector.
+constexpr std::size_t vector_header_size = 6;
+
+/// Largest vector type id supported. Enumerations (20 and above) are not.
+constexpr int max_vector_type_id = q_types::q_time_type_id;
+
+/// Read a little endian 32 bit int. The host is assumed to be little endian,
+/// like the messages supported.
+std::int32_t ReadInt32(const char* data) {
+  std::int32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+/// Find the size of a \0 terminated string, including the \0.
+DecodeResult GetNullTerminatedSize(const char* data, std::size_t data_size,
+                                   std::size_t* size) {
+  const void* end = std::memchr(data, '\0', data_size);
+  if (end == nullptr) {
+    return DecodeResult::Truncated;
+  }
+  *size = static_cast<const char*>(end) - data + 1;
+  return DecodeResult::Ok;
+}
+
+DecodeResult DecodeObjectAtDepth(const char* buffer, std::size_t buffer_size,
+                                 int depth, ObjectView* view);
+
+/// Decode objects one after another, and get the total size.
+DecodeResult GetSizeOfObjects(const char* buffer, std::size_t buffer_size,
+                              long long number_of_objects,  // NOLINT
+                              int depth, std::size_t* size) {
+  std::size_t offset = 0;
+  ObjectView element;
+  for (long long i = 0; i < number_of_objects; i++) {  // NOLINT
+    DecodeResult result = DecodeObjectAtDepth(
+        buffer + offset, buffer_size - offset, depth, &element);
+    if (result != DecodeResult::Ok) {
+      return result;
+    }
+    offset += element.size;
+  }
+  *size = offset;
+  return DecodeResult::Ok;
+}
+
+DecodeResult DecodeAtom(const char* buffer, std::size_t buffer_size,
+                        ObjectView* view) {
+  view->number_of_elements = 1;
+  view->data = buffer + 1;
+  std::size_t value_size;
+  if (view->q_type_id == q_types::q_error_type_id ||
+      view->q_type_id == -q_types::q_symbol_type_id) {
+    DecodeResult result =
+        GetNullTerminatedSize(view->data, buffer_size - 1, &value_size);
+    if (result != DecodeResult::Ok) {
+      return result;
+    }
+  } else {
+    value_size = q_types::GetElementSizeOfQTypeId(view->q_type_id);
+    if (value_size == 0 || view->q_type_id < -max_vector_type_id) {
+      return DecodeResult::UnsupportedType;
+    }
+    if (value_size > buffer_size - 1) {
+      return DecodeResult::Truncated;
+    }
+  }
+  view->size = 1 + value_size;
+  return DecodeResult::Ok;
+}
+
+DecodeResult DecodeVector(const char* buffer, std::size_t buffer_size,
+                          int depth, ObjectView* view) {
+  if (buffer_size < vector_header_size) {
+    return DecodeResult::Truncated;
+  }
+  view->attribute = buffer[1];
+  std::int32_t number_of_elements = ReadInt32(buffer + 2);
+  if (number_of_elements < 0) {
+    return DecodeResult::InvalidLength;
+  }
+  view->number_of_elements = number_of_elements;
+  view->data = buffer + vector_header_size;
+
+  const std::size_t data_size = buffer_size - vector_header_size;
+  std::size_t vector_size = 0;
+  if (q_types::IsQTypeIdMixedVector(view->q_type_id)) {
+    DecodeResult result = GetSizeOfObjects(
+        view->data, data_size, number_of_elements, depth + 1, &vector_size);
+    if (result != DecodeResult::Ok) {
+      return result;
+    }
+  } else if (view->q_type_id == q_types::q_symbol_type_id) {
+    // Symbols are \0 terminated strings one after another.
+    for (std::int32_t i = 0; i < number_of_elements; i++) {
+      std::size_t symbol_size;
+      DecodeResult result = GetNullTerminatedSize(
+          view->data + vector_size, data_size - vector_size, &symbol_size);
+      if (result != DecodeResult::Ok) {
+        return result;
+      }
+      vector_size += symbol_size;
+    }
+  } else {
+    std::size_t element_size =
+        q_types::GetElementSizeOfQTypeId(view->q_type_id);
+    if (element_size == 0) {
+      return DecodeResult::UnsupportedType;
+    }
+    // Divide instead of multiply, so it cannot overflow.
+    if (static_cast<std::size_t>(number_of_elements) >
+        data_size / element_size) {
+      return DecodeResult::Truncated;
+    }
+    vector_size = number_of_elements * element_size;
+  }
+  view->size = vector_header_size + vector_size;
+  return DecodeResult::Ok;
+}
+
+DecodeResult DecodeDict(const char* buffer, std::size_t buffer_size, int depth,
+                        ObjectView* view) {
+  view->data = buffer + 1;
+  std::size_t keys_and_values_size;
+  DecodeResult result = GetSizeOfObjects(view->data, buffer_size - 1, 2,
+                                         depth + 1, &keys_and_values_size);
+  if (result != DecodeResult::Ok) {
+    return result;
+  }
+  view->size = 1 + keys_and_values_size;
+  return DecodeResult::Ok;
+}
+
+DecodeResult DecodeTable(const char* buffer, std::size_t buffer_size,
+                         int depth, ObjectView* view) {
+  // Type byte and attribute byte.
+  if (buffer_size < 2) {
+    return DecodeResult::Truncated;
+  }
+  view->attribute = buffer[1];
+  view->data = buffer + 2;
+  ObjectView dict;
+  DecodeResult result =
+      DecodeObjectAtDepth(view->data, buffer_size - 2, depth + 1, &dict);
+  if (result != DecodeResult::Ok) {
+    return result;
+  }
+  if (dict.q_type_id != q_types::q_dict_type_id) {
+    return DecodeResult::NotDictionary;
+  }
+  view->size = 2 + dict.size;
+  return DecodeResult::Ok;
+}
+
+DecodeResult DecodeObjectAtDepth(const char* buffer, std::size_t buffer_size,
+                                 int depth, ObjectView* view) {
+  if (depth > max_depth) {
+    return DecodeResult::TooDeep;
+  }
+  if (buffer_size < 1) {
+    return DecodeResult::Truncated;
+  }
+  *view = ObjectView();
+  view->q_type_id = static_cast<signed char>(buffer[0]);
+
+  if (view->q_type_id < 0) {
+    return DecodeAtom(buffer, buffer_size, view);
+  } else if (view->q_type_id <= max_vector_type_id) {
+    return DecodeVector(buffer, buffer_size, depth, view);
+  } else if (view->q_type_id == q_types::q_table_type_id) {
+    return DecodeTable(buffer, buffer_size, depth, view);
+  } else if (view->q_type_id == q_types::q_dict_type_id ||
+             view->q_type_id == q_sorted_dict_type_id) {
+    return DecodeDict(buffer, buffer_size, depth, view);
+  } else if (view->q_type_id == q_generic_null_type_id) {
+    // Followed by one byte.
+    if (buffer_size < 2) {
+      return DecodeResult::Truncated;
+    }
+    view->data = buffer + 1;
+    view->size = 2;
+    return DecodeResult::Ok;
+  }
+  return DecodeResult::UnsupportedType;
+}
+}  // namespace
+
+const char* GetDecodeResultName(DecodeResult result) {
+  // Cast result to an int.
+  int temp_result = static_cast<int>(result);
+  // Make sure it's valid.
+  if (temp_result >= 0 && temp_result < number_of_decode_result_names) {
+    return DecodeResultNames[temp_result];
+  } else {
+    return "Invalid";
+  }
+}
+
+std::ostream& operator<<(std::ostream& output, DecodeResult result) {
+  return output << GetDecodeResultName(result);
+}
+
+DecodeResult DecodeMessageHeader(const char* buffer, std::size_t buffer_size,
+                                 MessageHeader* header) {
+  if (buffer_size < message_header_size) {
+    return DecodeResult::Truncated;
+  }
+  // First byte is 1 for little endian.
+  if (buffer[0] != 1) {
+    return DecodeResult::NotLittleEndian;
+  }
+  header->message_type = buffer[1];
+  header->is_compressed = buffer[2] != 0;
+  header->message_size = static_cast<std::uint32_t>(ReadInt32(buffer + 4));
+  return DecodeResult::Ok;
+}
+
+DecodeResult DecodeObject(const char* buffer, std::size_t buffer_size,
+                          ObjectView* view) {
+  return DecodeObjectAtDepth(buffer, buffer_size, 0, view);
+}
+
+DecodeResult DecodeMessage(const char* buffer, std::size_t buffer_size,
+                           MessageHeader* header, ObjectView* view) {
+  DecodeResult result = DecodeMessageHeader(buffer, buffer_size, header);
+  if (result != DecodeResult::Ok) {
+    return result;
+  }
+  if (header->is_compressed) {
+    return DecodeResult::Compressed;
+  }
+  if (header->message_size < message_header_size ||
+      header->message_size > buffer_size) {
+    return DecodeResult::Truncated;
+  }
+  return DecodeObject(buffer + message_header_size,
+                      header->message_size - message_header_size, view);
+}
+
+DecodeResult GetMixedVectorElements(const ObjectView& mixed_vector,
+                                    ObjectView* elements) {
+  if (!q_types::IsQTypeIdMixedVector(mixed_vector.q_type_id)) {
+    return DecodeResult::NotMixedVector;
+  }
+  // Elements are checked to be inside the mixed vector when it's decoded.
+  const char* element_data = mixed_vector.data;
+  const char* end = mixed_vector.data - vector_header_size + mixed_vector.size;
+  for (long long i = 0; i < mixed_vector.number_of_elements; i++) {  // NOLINT
+    DecodeResult result =
+        DecodeObject(element_data, end - element_data, elements + i);
+    if (result != DecodeResult::Ok) {
+      return result;
+    }
+    element_data += elements[i].size;
+  }
+  return DecodeResult::Ok;
+}
+
+DecodeResult GetDictKeysAndValues(const ObjectView& dict, ObjectView* keys,
+                                  ObjectView* values) {
+  if (dict.q_type_id != q_types::q_dict_type_id &&
+      dict.q_type_id != q_sorted_dict_type_id) {
+    return DecodeResult::NotDictionary;
+  }
+  // The dictionary is the type byte followed by keys and values.
+  const char* end = dict.data - 1 + dict.size;
+  DecodeResult result = DecodeObject(dict.data, end - dict.data, keys);
+  if (result != DecodeResult::Ok) {
+    return result;
+  }
+  const char* values_data = dict.data + keys->size;
+  return DecodeObject(values_data, end - values_data, values);
+}
+
+DecodeResult GetSimpleTable(const ObjectView& simple_table,
+                            ObjectView* column_heading, ObjectView* values,
+                            std::size_t* number_of_columns,
+                            std::size_t* number_of_rows) {
+  if (simple_table.q_type_id != q_types::q_table_type_id) {
+    return DecodeResult::NotTable;
+  }
+  // The dictionary is checked when the table is decoded, so build its view
+  // without walking it again. Type byte and attribute byte come before it.
+  ObjectView dict;
+  dict.q_type_id = q_types::q_dict_type_id;
+  dict.data = simple_table.data + 1;
+  dict.size = simple_table.size - 2;
+  DecodeResult result = GetDictKeysAndValues(dict, column_heading, values);
+  if (result != DecodeResult::Ok) {
+    return result;
+  }
+  if (!q_types::IsQTypeIdMixedVector(values->q_type_id)) {
+    return DecodeResult::NotMixedVector;
+  }
+
+  *number_of_columns = column_heading->number_of_elements;
+  *number_of_rows = 0;
+  // If the number of columns is zero, return rightway.
+  if (*number_of_columns == 0) {
+    return DecodeResult::Ok;
+  }
+  // Only the first column is needed for the number of rows.
+  ObjectView first_column;
+  result = DecodeObject(values->data, values->size - vector_header_size,
+                        &first_column);
+  if (result != DecodeResult::Ok) {
+    return result;
+  }
+  *number_of_rows = first_column.number_of_elements;
+  return DecodeResult::Ok;
+}
+
+std::string GetStringValue(const ObjectView& view) {
+  if (view.q_type_id == q_types::q_char_type_id) {
+    return std::string(view.data, view.number_of_elements);
+  }
+  // Symbol and error are \0 terminated.
+  return std::string(view.data);
+}
+
+accessors::DataRetrievalResult CheckVectorForVectorDataRetrieval(
+    const ObjectView& input_vector) {
+  // First, check if the view points to anything.
+  if (input_vector.data == nullptr) {
+    return accessors::DataRetrievalResult::NullInput;
+  }
+  // Check if this is an error
+  if (q_types::IsQTypeIdError(input_vector.q_type_id)) {
+    return accessors::DataRetrievalResult::ValueError;
+  }
+  // Check if this is a vector
+  if (!q_types::IsQTypeIdVector(input_vector.q_type_id)) {
+    return accessors::DataRetrievalResult::NotVector;
+  }
+  // Return OK.
+  return accessors::DataRetrievalResult::Ok;
+}
+
+accessors::DataRetrievalResult RetrieveVectorData(
+    const ObjectView& input_vector, std::string* output_vector) {
+  accessors::DataRetrievalResult check_result =
+      CheckVectorForVectorDataRetrieval(input_vector);
+  if (check_result != accessors::DataRetrievalResult::Ok) {
+    return check_result;
+  }
+  if (input_vector.q_type_id == q_types::q_symbol_type_id) {
+    // Symbols are \0 terminated strings one after another.
+    const char* symbol = input_vector.data;
+    for (long long i = 0; i < input_vector.number_of_elements;  // NOLINT
+         i++) {
+      std::size_t length = std::strlen(symbol);
+      output_vector[i].assign(symbol, length);
+      symbol += length + 1;
+    }
+    return accessors::DataRetrievalResult::Ok;
+  } else if (q_types::IsQTypeIdMixedVector(input_vector.q_type_id)) {
+    const char* element_data = input_vector.data;
+    const char* end = input_vector.data - vector_header_size + input_vector.size;
+    ObjectView element;
+    for (long long i = 0; i < input_vector.number_of_elements;  // NOLINT
+         i++) {
+      if (DecodeObject(element_data, end - element_data, &element) !=
+              DecodeResult::Ok ||
+          element.q_type_id != q_types::q_char_type_id) {
+        return accessors::DataRetrievalResult::NotCharVectorInMixedVector;
+      }
+      output_vector[i].assign(element.data, element.number_of_elements);
+      element_data += element.size;
+    }
+    return accessors::DataRetrievalResult::Ok;
+  } else {
+    // Not a string...
+    return accessors::DataRetrievalResult::NotStringVector;
+  }
+}
+
+accessors::DataRetrievalResult RetrieveVectorData(
+    const ObjectView& input_vector, q_types::QGuid* output_vector) {
+  accessors::DataRetrievalResult check_result =
+      CheckVectorForVectorDataRetrieval(input_vector);
+  if (check_result != accessors::DataRetrievalResult::Ok) {
+    return check_result;
+  }
+  if (input_vector.q_type_id != q_types::q_guid_type_id) {
+    return accessors::DataRetrievalResult::NotGuidVector;
+  }
+  // Copy over.
+  std::memcpy(output_vector, input_vector.data,
+              input_vector.number_of_elements * sizeof(q_types::QGuid));
+  return accessors::DataRetrievalResult::Ok;
+}
+}  // namespace cpp2kdb::ipc_decoder
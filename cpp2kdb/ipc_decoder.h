@@ -0,0 +1,328 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_IPC_DECODER_H__
+#define CPP2KDB_IPC_DECODER_H__
+/// \file cpp2kdb/ipc_decoder.h
+/// Pure C++ decoder for the kdb IPC wire format.
+///
+/// Unlike d9, which creates a new K object for every reply, the decoder only
+/// creates read-only views pointing into the buffer holding the message. The
+/// data is copied out only when it is retrieved, with functions following
+/// accessors.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <type_traits>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/q_types.h"
+
+/// Decoding kdb IPC messages without k.h
+namespace cpp2kdb::ipc_decoder {
+/// Decode Result
+enum class DecodeResult {
+  /// Ok.
+  Ok = 0,
+  /// Buffer ends before the message or object does.
+  Truncated,
+  /// Message is in big endian, which is not supported.
+  NotLittleEndian,
+  /// Message is compressed. Decompress it with ipc_compression first.
+  Compressed,
+  /// Type of the object is not supported, such as functions.
+  UnsupportedType,
+  /// Length of a vector is negative.
+  InvalidLength,
+  /// Objects are nested too deep.
+  TooDeep,
+  /// Not a mixed list.
+  NotMixedVector,
+  /// Not a dictionary.
+  NotDictionary,
+  /// Not a table.
+  NotTable
+};
+
+/// Names for the enums.
+constexpr const char* DecodeResultNames[] = {"Ok",
+                                             "Truncated",
+                                             "NotLittleEndian",
+                                             "Compressed",
+                                             "UnsupportedType",
+                                             "InvalidLength",
+                                             "TooDeep",
+                                             "NotMixedVector",
+                                             "NotDictionary",
+                                             "NotTable"};
+
+/// Number of decode result names
+constexpr const int number_of_decode_result_names =
+    sizeof(DecodeResultNames) / sizeof(DecodeResultNames[0]);
+
+/// Get the name from a result
+const char* GetDecodeResultName(DecodeResult result);
+
+/// Overload << for result type `DecodeResult`.
+std::ostream& operator<<(std::ostream& output_stream, DecodeResult result);
+
+/// Size of the message header, in bytes.
+constexpr std::size_t message_header_size = 8;
+
+/// Q Type Id for the generic null (::)
+constexpr const int q_generic_null_type_id = 101;
+
+/// Q Type Id for sorted dictionary.
+constexpr const int q_sorted_dict_type_id = 127;
+
+/// Header of an IPC message.
+struct MessageHeader {
+  /// 0 for async, 1 for sync, 2 for response.
+  int message_type = 0;
+  /// If the message is compressed.
+  bool is_compressed = false;
+  /// Size of the whole message, including the header.
+  std::size_t message_size = 0;
+};
+
+/// Read-only view over one object in an IPC message.
+///
+/// The view points into the buffer, which must outlive the view. Note the data
+/// is not aligned, so it must be read through std::memcpy or the functions
+/// below, and not by casting data to a typed pointer.
+struct ObjectView {
+  /// Q type id of the object.
+  int q_type_id = 0;
+  /// Attribute of vectors and tables, 0 for none.
+  int attribute = 0;
+  /// Number of elements for vectors. 1 for atoms.
+  long long number_of_elements = 0;  // NOLINT
+  /// - atom: the value. For symbol, the first char.
+  /// - vector: the first element. For symbol vectors, the first char of the
+  ///   first symbol. For mixed list, the first element object.
+  /// - dict: the key object, which is followed by the value object.
+  /// - table: the dictionary object.
+  /// - error: the first char of the error message.
+  const char* data = nullptr;
+  /// Number of bytes the whole object takes in the buffer.
+  std::size_t size = 0;
+};
+
+/// Decode the header of a message.
+DecodeResult DecodeMessageHeader(
+    /// [in] Buffer holding the message.
+    const char* buffer,
+    /// Size of the buffer.
+    std::size_t buffer_size,
+    /// [out] Header.
+    MessageHeader* header);
+
+/// Decode one object.
+///
+/// All the nested objects are walked to find the size of the object, and
+/// checked to be inside the buffer, so the functions getting nested objects
+/// below don't need to check the bounds again.
+DecodeResult DecodeObject(
+    /// [in] Buffer starting with the type byte of the object.
+    const char* buffer,
+    /// Size of the buffer.
+    std::size_t buffer_size,
+    /// [out] View over the object.
+    ObjectView* view);
+
+/// Decode a whole message, which is a header followed by one object.
+DecodeResult DecodeMessage(
+    /// [in] Buffer holding the message.
+    const char* buffer,
+    /// Size of the buffer.
+    std::size_t buffer_size,
+    /// [out] Header.
+    MessageHeader* header,
+    /// [out] View over the object in the message.
+    ObjectView* view);
+
+/// Get the elements of a mixed list.
+DecodeResult GetMixedVectorElements(
+    /// [in] Mixed list decoded by DecodeObject.
+    const ObjectView& mixed_vector,
+    /// [out] Views of the elements. Memory must hold number_of_elements
+    /// elements.
+    ObjectView* elements);
+
+/// Get the keys and values of a dictionary or a keyed table.
+DecodeResult GetDictKeysAndValues(
+    /// [in] Dictionary decoded by DecodeObject.
+    const ObjectView& dict,
+    /// [out] View of the keys.
+    ObjectView* keys,
+    /// [out] View of the values.
+    ObjectView* values);
+
+/// Get the column heading and the number of columns and rows of a simple
+/// table.
+///
+/// Like accessors::GetSimpleTable, but the columns are obtained by calling
+/// GetMixedVectorElements on values.
+DecodeResult GetSimpleTable(
+    /// [in] Table decoded by DecodeObject.
+    const ObjectView& simple_table,
+    /// [out] View of the column heading, a symbol vector.
+    ObjectView* column_heading,
+    /// [out] View of the mixed list of columns.
+    ObjectView* values,
+    /// [out] Will be set to number of columns.
+    std::size_t* number_of_columns,
+    /// [out] Will be set to number of rows.
+    std::size_t* number_of_rows);
+
+/// Get the atomic value as type T.
+///
+/// The value is static_cast from the type indicated by the view to T. There is
+/// no check, like accessors::GetValue.
+template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+T GetValue(const ObjectView& view) {
+  // Symbol atom is not a pointer in the buffer, nothing to copy.
+  if (view.q_type_id == -q_types::q_symbol_type_id) {
+    return T();
+  }
+  // Copy out, since the data is not aligned.
+  char value[sizeof(q_types::QGuid)];
+  std::memcpy(value, view.data,
+              q_types::GetElementSizeOfQTypeId(view.q_type_id));
+  T result = T();
+  q_types::TryGetAtomicValue(view.q_type_id, value, &result);
+  return result;
+}
+
+/// Get the symbol or error message as std::string.
+std::string GetStringValue(const ObjectView& view);
+
+/// Check if the view is valid for retrieving data into a vector.
+accessors::DataRetrievalResult CheckVectorForVectorDataRetrieval(
+    const ObjectView& input_vector);
+
+namespace internal {
+/// Copy and convert elements of type S, which are not aligned, into T.
+template <typename S, typename T>
+void CopyConvertedData(const char* input_data, std::size_t number_of_elements,
+                       T* output_data) {
+  for (std::size_t i = 0; i < number_of_elements; i++) {
+    S value;
+    std::memcpy(&value, input_data + i * sizeof(S), sizeof(S));
+    output_data[i] = static_cast<T>(value);
+  }
+}
+
+/// Copy the vector of input_q_type_id into T, converting the elements.
+template <typename T>
+bool TryCopyConvertedData(int input_q_type_id, std::size_t number_of_elements,
+                          const char* input_data, T* output_data) {
+  switch (input_q_type_id) {
+    case q_types::q_boolean_type_id:
+      CopyConvertedData<q_types::CTypeForQTypeId<q_types::q_boolean_type_id>>(
+          input_data, number_of_elements, output_data);
+      return true;
+    case q_types::q_byte_type_id:
+      CopyConvertedData<q_types::CTypeForQTypeId<q_types::q_byte_type_id>>(
+          input_data, number_of_elements, output_data);
+      return true;
+    case q_types::q_short_type_id:
+      CopyConvertedData<q_types::CTypeForQTypeId<q_types::q_short_type_id>>(
+          input_data, number_of_elements, output_data);
+      return true;
+    case q_types::q_int_type_id:
+    case q_types::q_month_type_id:
+    case q_types::q_date_type_id:
+    case q_types::q_minute_type_id:
+    case q_types::q_second_type_id:
+    case q_types::q_time_type_id:
+      CopyConvertedData<q_types::CTypeForQTypeId<q_types::q_int_type_id>>(
+          input_data, number_of_elements, output_data);
+      return true;
+    case q_types::q_long_type_id:
+    case q_types::q_timestamp_type_id:
+    case q_types::q_timespan_type_id:
+      CopyConvertedData<q_types::CTypeForQTypeId<q_types::q_long_type_id>>(
+          input_data, number_of_elements, output_data);
+      return true;
+    case q_types::q_real_type_id:
+      CopyConvertedData<q_types::CTypeForQTypeId<q_types::q_real_type_id>>(
+          input_data, number_of_elements, output_data);
+      return true;
+    case q_types::q_float_type_id:
+    case q_types::q_datetime_type_id:
+      CopyConvertedData<q_types::CTypeForQTypeId<q_types::q_float_type_id>>(
+          input_data, number_of_elements, output_data);
+      return true;
+    case q_types::q_char_type_id:
+      CopyConvertedData<q_types::CTypeForQTypeId<q_types::q_char_type_id>>(
+          input_data, number_of_elements, output_data);
+      return true;
+    default:
+      return false;
+  }
+}
+}  // namespace internal
+
+/// Retrieve Data Into Vector.
+///
+/// Same as accessors::RetrieveVectorData. When T is the C type of the vector,
+/// this is a single std::memcpy from the buffer.
+template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+accessors::DataRetrievalResult RetrieveVectorData(
+    /// [in] input vector.
+    const ObjectView& input_vector,
+    /// [out] output location.
+    T* output_vector) {
+  // Check the vector first.
+  accessors::DataRetrievalResult check_vector_result =
+      CheckVectorForVectorDataRetrieval(input_vector);
+  // return if not OK.
+  if (check_vector_result != accessors::DataRetrievalResult::Ok) {
+    return check_vector_result;
+  }
+  // Check if this is mixed vector or symbol vector
+  if (q_types::IsQTypeIdMixedVector(input_vector.q_type_id) ||
+      input_vector.q_type_id == q_types::q_symbol_type_id) {
+    return accessors::DataRetrievalResult::NotNumericalVector;
+  }
+
+  // Same type, copy the bytes over.
+  if (q_types::IsSameType<T>(input_vector.q_type_id) &&
+      q_types::GetElementSizeOfQTypeId(input_vector.q_type_id) == sizeof(T)) {
+    std::memcpy(output_vector, input_vector.data,
+                input_vector.number_of_elements * sizeof(T));
+    return accessors::DataRetrievalResult::Ok;
+  }
+
+  if (internal::TryCopyConvertedData<T>(input_vector.q_type_id,
+                                        input_vector.number_of_elements,
+                                        input_vector.data, output_vector)) {
+    return accessors::DataRetrievalResult::Ok;
+  } else {
+    return accessors::DataRetrievalResult::InvalidQTypeId;
+  }
+}
+
+/// Specialization for type std::string of Retrieving Data into Vector.
+/// std::string can be either a vector of symbol (type 11), or a mixed vector
+/// with each element a vector of char (type 0, and then type 10 for all
+/// elements).
+accessors::DataRetrievalResult RetrieveVectorData(
+    /// [in] input vector.
+    const ObjectView& input_vector,
+    /// [out] output location.
+    std::string* output_vector);
+
+/// Specialization for type QGuid of Retrieving Data into Vector.
+accessors::DataRetrievalResult RetrieveVectorData(
+    /// [in] input vector.
+    const ObjectView& input_vector,
+    /// [out] output location.
+    q_types::QGuid* output_vector);
+}  // namespace cpp2kdb::ipc_decoder
+#endif  // CPP2KDB_IPC_DECODER_H__
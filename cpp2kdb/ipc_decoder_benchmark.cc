@@ -0,0 +1,139 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/ipc_decoder.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+// Objects are built and serialized in process, no connection is needed.
+namespace {
+/// Serialize ([] J:til n; F:n?1.; S:n?`a`b`c`d) into a byte vector.
+void* MakeSerializedTable(std::size_t number_of_rows) {
+  const char* names[] = {"J", "F", "S"};
+  void* heading = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_symbol_type_id, 3);
+  for (int i = 0; i < 3; i++) {
+    cpp2kdb::accessors::GetVector<char*>(heading)[i] =
+        cpp2kdb::kdb_wrapper::InternSymbol(names[i]);
+  }
+  char* symbols[] = {cpp2kdb::kdb_wrapper::InternSymbol("a"),
+                     cpp2kdb::kdb_wrapper::InternSymbol("b"),
+                     cpp2kdb::kdb_wrapper::InternSymbol("c"),
+                     cpp2kdb::kdb_wrapper::InternSymbol("d")};
+
+  void* columns =
+      cpp2kdb::kdb_wrapper::CreateVector(cpp2kdb::q_types::q_mixed_type_id, 3);
+  void** column_list = cpp2kdb::accessors::GetVector<void*>(columns);
+  column_list[0] = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_long_type_id, number_of_rows);
+  column_list[1] = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_float_type_id, number_of_rows);
+  column_list[2] = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_symbol_type_id, number_of_rows);
+  for (std::size_t i = 0; i < number_of_rows; i++) {
+    cpp2kdb::accessors::GetVector<std::int64_t>(column_list[0])[i] = i;
+    cpp2kdb::accessors::GetVector<double>(column_list[1])[i] = i * 0.5;
+    cpp2kdb::accessors::GetVector<char*>(column_list[2])[i] = symbols[i % 4];
+  }
+  void* table = cpp2kdb::kdb_wrapper::CreateTable(
+      cpp2kdb::kdb_wrapper::CreateDict(heading, columns));
+  void* bytes = cpp2kdb::kdb_wrapper::Serialize(2, table);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCount(table);
+  return bytes;
+}
+
+void SetCounters(benchmark::State& state, void* bytes) {
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(
+      state.iterations() *
+      cpp2kdb::kdb_wrapper::GetNumberOfVectorElements(bytes));
+}
+
+/// Deserialize with d9, which creates a new K object.
+void BM_DeserializeWithD9(benchmark::State& state) {
+  void* bytes = MakeSerializedTable(state.range(0));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(bytes);
+  for (auto _ : state) {
+    void* table = cpp2kdb::kdb_wrapper::Deserialize(bytes);
+    benchmark::DoNotOptimize(table);
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCount(table);
+  }
+  SetCounters(state, bytes);
+}
+BENCHMARK(BM_DeserializeWithD9)->RangeMultiplier(16)->Range(1, 1 << 24);
+
+/// Decode with ipc_decoder, which only creates views.
+void BM_DecodeWithIpcDecoder(benchmark::State& state) {
+  void* bytes = MakeSerializedTable(state.range(0));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(bytes);
+  const char* buffer = cpp2kdb::accessors::GetVector<char>(bytes);
+  std::size_t buffer_size =
+      cpp2kdb::kdb_wrapper::GetNumberOfVectorElements(bytes);
+  for (auto _ : state) {
+    cpp2kdb::ipc_decoder::MessageHeader header;
+    cpp2kdb::ipc_decoder::ObjectView view;
+    cpp2kdb::ipc_decoder::DecodeMessage(buffer, buffer_size, &header, &view);
+    benchmark::DoNotOptimize(view);
+  }
+  SetCounters(state, bytes);
+}
+BENCHMARK(BM_DecodeWithIpcDecoder)->RangeMultiplier(16)->Range(1, 1 << 24);
+
+/// Deserialize with d9, and retrieve the numerical columns with accessors.
+void BM_DeserializeWithD9AndRetrieve(benchmark::State& state) {
+  void* bytes = MakeSerializedTable(state.range(0));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(bytes);
+  std::vector<std::int64_t> j_column(state.range(0));
+  std::vector<double> f_column(state.range(0));
+  for (auto _ : state) {
+    void* table = cpp2kdb::kdb_wrapper::Deserialize(bytes);
+    void* column_heading;
+    void** values;
+    std::size_t nc, nr;
+    cpp2kdb::accessors::GetSimpleTable(table, &column_heading, &values, &nc,
+                                       &nr);
+    cpp2kdb::accessors::RetrieveVectorData(values[0], j_column.data());
+    cpp2kdb::accessors::RetrieveVectorData(values[1], f_column.data());
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCount(table);
+  }
+  SetCounters(state, bytes);
+}
+BENCHMARK(BM_DeserializeWithD9AndRetrieve)
+    ->RangeMultiplier(16)
+    ->Range(1, 1 << 24);
+
+/// Decode with ipc_decoder, and retrieve the numerical columns.
+void BM_DecodeWithIpcDecoderAndRetrieve(benchmark::State& state) {
+  void* bytes = MakeSerializedTable(state.range(0));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(bytes);
+  const char* buffer = cpp2kdb::accessors::GetVector<char>(bytes);
+  std::size_t buffer_size =
+      cpp2kdb::kdb_wrapper::GetNumberOfVectorElements(bytes);
+  std::vector<std::int64_t> j_column(state.range(0));
+  std::vector<double> f_column(state.range(0));
+  cpp2kdb::ipc_decoder::ObjectView columns[3];
+  for (auto _ : state) {
+    cpp2kdb::ipc_decoder::MessageHeader header;
+    cpp2kdb::ipc_decoder::ObjectView view, column_heading, values;
+    std::size_t nc, nr;
+    cpp2kdb::ipc_decoder::DecodeMessage(buffer, buffer_size, &header, &view);
+    cpp2kdb::ipc_decoder::GetSimpleTable(view, &column_heading, &values, &nc,
+                                         &nr);
+    cpp2kdb::ipc_decoder::GetMixedVectorElements(values, columns);
+    cpp2kdb::ipc_decoder::RetrieveVectorData(columns[0], j_column.data());
+    cpp2kdb::ipc_decoder::RetrieveVectorData(columns[1], f_column.data());
+  }
+  SetCounters(state, bytes);
+}
+BENCHMARK(BM_DecodeWithIpcDecoderAndRetrieve)
+    ->RangeMultiplier(16)
+    ->Range(1, 1 << 24);
+}  // namespace
+
+BENCHMARK_MAIN();
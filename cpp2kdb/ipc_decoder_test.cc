@@ -0,0 +1,155 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/ipc_decoder.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+/// Build ([] J:0 1 2 3 4; F:0 0.5 1 1.5 2.; S:`a`b`c`d`e; C:("a";"bb";...))
+void* MakeTable() {
+  constexpr int number_of_rows = 5;
+  const char* names[] = {"J", "F", "S", "C"};
+  void* heading = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_symbol_type_id, 4);
+  for (int i = 0; i < 4; i++) {
+    cpp2kdb::accessors::GetVector<char*>(heading)[i] =
+        cpp2kdb::kdb_wrapper::InternSymbol(names[i]);
+  }
+
+  void* columns =
+      cpp2kdb::kdb_wrapper::CreateVector(cpp2kdb::q_types::q_mixed_type_id, 4);
+  void** column_list = cpp2kdb::accessors::GetVector<void*>(columns);
+  column_list[0] = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_long_type_id, number_of_rows);
+  column_list[1] = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_float_type_id, number_of_rows);
+  column_list[2] = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_symbol_type_id, number_of_rows);
+  column_list[3] = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_mixed_type_id, number_of_rows);
+  for (int i = 0; i < number_of_rows; i++) {
+    cpp2kdb::accessors::GetVector<std::int64_t>(column_list[0])[i] = i;
+    cpp2kdb::accessors::GetVector<double>(column_list[1])[i] = i * 0.5;
+    std::string symbol(1, static_cast<char>('a' + i));
+    cpp2kdb::accessors::GetVector<char*>(column_list[2])[i] =
+        cpp2kdb::kdb_wrapper::InternSymbol(symbol.c_str());
+    std::string text(i + 1, static_cast<char>('a' + i));
+    cpp2kdb::accessors::GetVector<void*>(column_list[3])[i] =
+        cpp2kdb::kdb_wrapper::CreateCharVector(text.c_str());
+  }
+  return cpp2kdb::kdb_wrapper::CreateTable(
+      cpp2kdb::kdb_wrapper::CreateDict(heading, columns));
+}
+
+void TestTable() {
+  void* table = MakeTable();
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard table_guard(table);
+  void* bytes = cpp2kdb::kdb_wrapper::Serialize(2, table);
+  if (bytes == nullptr) {
+    std::cout << "Serialization failed" << std::endl;
+    return;
+  }
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard bytes_guard(bytes);
+  const char* buffer = cpp2kdb::accessors::GetVector<char>(bytes);
+  std::size_t buffer_size =
+      cpp2kdb::kdb_wrapper::GetNumberOfVectorElements(bytes);
+  std::cout << "Serialized size is " << buffer_size << std::endl;
+
+  cpp2kdb::ipc_decoder::MessageHeader header;
+  cpp2kdb::ipc_decoder::ObjectView view;
+  cpp2kdb::ipc_decoder::DecodeResult decode_result =
+      cpp2kdb::ipc_decoder::DecodeMessage(buffer, buffer_size, &header, &view);
+  std::cout << "Decode result is " << decode_result << ", type is "
+            << view.q_type_id << std::endl;
+
+  cpp2kdb::ipc_decoder::ObjectView column_heading, values;
+  std::size_t nc, nr;
+  decode_result = cpp2kdb::ipc_decoder::GetSimpleTable(
+      view, &column_heading, &values, &nc, &nr);
+  std::cout << "Get table result is " << decode_result
+            << ", shape of the table is: row count " << nr << " column count "
+            << nc << std::endl;
+  std::vector<std::string> column_names(nc);
+  cpp2kdb::ipc_decoder::RetrieveVectorData(column_heading,
+                                           column_names.data());
+  std::vector<cpp2kdb::ipc_decoder::ObjectView> columns(nc);
+  cpp2kdb::ipc_decoder::GetMixedVectorElements(values, columns.data());
+  for (std::size_t i = 0; i < nc; i++) {
+    std::cout << "column " << i << ": " << column_names[i]
+              << ", column type is " << columns[i].q_type_id << std::endl;
+  }
+
+  std::vector<std::int64_t> j_column(nr);
+  std::cout << "Retrieve J: "
+            << cpp2kdb::ipc_decoder::RetrieveVectorData(columns[0],
+                                                        j_column.data())
+            << std::endl;
+  std::vector<double> f_column(nr);
+  std::cout << "Retrieve F: "
+            << cpp2kdb::ipc_decoder::RetrieveVectorData(columns[1],
+                                                        f_column.data())
+            << std::endl;
+  std::vector<std::string> s_column(nr);
+  std::cout << "Retrieve S: "
+            << cpp2kdb::ipc_decoder::RetrieveVectorData(columns[2],
+                                                        s_column.data())
+            << std::endl;
+  std::vector<std::string> c_column(nr);
+  std::cout << "Retrieve C: "
+            << cpp2kdb::ipc_decoder::RetrieveVectorData(columns[3],
+                                                        c_column.data())
+            << std::endl;
+  for (std::size_t i = 0; i < nr; i++) {
+    std::cout << j_column[i] << " " << f_column[i] << " " << s_column[i] << " "
+              << c_column[i] << std::endl;
+  }
+
+  std::vector<std::int64_t> wrong_type(nr);
+  std::cout << "Retrieve S as std::int64_t: "
+            << cpp2kdb::ipc_decoder::RetrieveVectorData(columns[2],
+                                                        wrong_type.data())
+            << std::endl;
+}
+
+void TestTruncated() {
+  void* table = MakeTable();
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard table_guard(table);
+  void* bytes = cpp2kdb::kdb_wrapper::Serialize(2, table);
+  if (bytes == nullptr) {
+    std::cout << "Serialization failed" << std::endl;
+    return;
+  }
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard bytes_guard(bytes);
+  const char* buffer = cpp2kdb::accessors::GetVector<char>(bytes);
+  std::size_t buffer_size =
+      cpp2kdb::kdb_wrapper::GetNumberOfVectorElements(bytes);
+
+  int number_of_rejected = 0;
+  for (std::size_t i = 0; i + cpp2kdb::ipc_decoder::message_header_size <
+                          buffer_size;
+       i++) {
+    cpp2kdb::ipc_decoder::ObjectView view;
+    if (cpp2kdb::ipc_decoder::DecodeObject(
+            buffer + cpp2kdb::ipc_decoder::message_header_size, i, &view) !=
+        cpp2kdb::ipc_decoder::DecodeResult::Ok) {
+      number_of_rejected++;
+    }
+  }
+  std::cout << "Truncated objects rejected: " << number_of_rejected
+            << " out of "
+            << buffer_size - cpp2kdb::ipc_decoder::message_header_size
+            << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  // No connection is needed, objects are built and serialized in process.
+  TestTable();
+  std::cout << "----------------------" << std::endl;
+  TestTruncated();
+  return 0;
+}
@@ -0,0 +1,64 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/k_object.h"
+
+#include <utility>
+
+namespace cpp2kdb::k_object {
+KObject::KObject() : object(nullptr) {
+  // do nothing here
+}
+
+KObject::KObject(void* x) : object(x) {
+  // do nothing here
+}
+
+KObject::KObject(KObject&& other) noexcept
+    : object(std::exchange(other.object, nullptr)) {
+  // do nothing here
+}
+
+KObject& KObject::operator=(KObject&& other) noexcept {
+  if (this != &other) {
+    this->Reset(std::exchange(other.object, nullptr));
+  }
+  return *this;
+}
+
+KObject::~KObject() { this->Reset(); }
+
+KObject KObject::Share(void* x) {
+  return KObject(x == nullptr ? nullptr
+                              : kdb_wrapper::IncreaseReferenceCount(x));
+}
+
+KObject KObject::Copy() const { return KObject::Share(this->object); }
+
+void* KObject::Get() const { return this->object; }
+
+void* KObject::Release() { return std::exchange(this->object, nullptr); }
+
+void KObject::Reset(void* x) {
+  // Only call when object is not nullptr.
+  if (this->object != nullptr) {
+    kdb_wrapper::DecreaseReferenceCount(this->object);
+  }
+  this->object = x;
+}
+
+KObject::operator bool() const { return this->object != nullptr; }
+
+int KObject::GetQTypeId() const {
+  return kdb_wrapper::GetQTypeId(this->object);
+}
+
+bool KObject::IsNullOrError() const {
+  return this->object == nullptr || accessors::IsError(this->object);
+}
+
+std::size_t KObject::GetNumberOfElements() const {
+  return kdb_wrapper::GetNumberOfVectorElements(this->object);
+}
+}  // namespace cpp2kdb::k_object
@@ -0,0 +1,90 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_K_OBJECT_H__
+#define CPP2KDB_K_OBJECT_H__
+/// \file cpp2kdb/k_object.h
+/// Owning handle of a K object, which can be moved.
+///
+/// DecreaseReferenceCountGuard can be neither copied nor moved, so it cannot
+/// be returned or kept in containers. KObject owns one reference, which moves
+/// with it, and is only copied by an explicit call to Copy.
+
+#include <cstddef>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+#include "cpp2kdb/vector_view.h"
+
+/// Owning handle of K objects.
+namespace cpp2kdb::k_object {
+/// Owner of one reference to a K object, released with r0 when destructed.
+class KObject {
+ public:
+  /// Create an empty KObject.
+  KObject();
+  /// Take the reference held by the caller to x, which can be nullptr.
+  explicit KObject(void* x);
+  /// Copy constructor is deleted, use Copy.
+  KObject(const KObject&) = delete;
+  /// assignment operator is deleted, use Copy.
+  KObject& operator=(const KObject&) = delete;
+  /// Move constructor, leaving other empty.
+  KObject(KObject&& other) noexcept;
+  /// Move assignment, releasing the object held and leaving other empty.
+  KObject& operator=(KObject&& other) noexcept;
+  /// Destructor, calling r0 on the object if it's not nullptr.
+  ~KObject();
+
+  /// Create a KObject with a new reference to x, so the caller keeps its own.
+  static KObject Share(void* x);
+
+  /// Create another KObject for the same object, with a new reference taken
+  /// by IncreaseReferenceCount.
+  KObject Copy() const;
+
+  /// Get the object, nullptr if empty. The reference stays with KObject.
+  void* Get() const;
+  /// Give up the reference to the caller and make KObject empty.
+  /// \returns the object, which the caller must release.
+  void* Release();
+  /// Release the object held, and take the reference held by the caller to x.
+  void Reset(void* x = nullptr);
+  /// Check if there is an object.
+  explicit operator bool() const;
+
+  /// Q type id of the object, which must not be empty.
+  int GetQTypeId() const;
+  /// Check if the object is empty or an error.
+  bool IsNullOrError() const;
+  /// Number of elements of a vector, which must not be empty.
+  std::size_t GetNumberOfElements() const;
+
+  /// Get an atom as T, see accessors::GetValue.
+  template <typename T>
+  T GetValue() const {
+    return accessors::GetValue<T>(this->object);
+  }
+  /// Get the elements of a vector as T*, see accessors::GetVector.
+  template <typename T>
+  T* GetVector() const {
+    return accessors::GetVector<T>(this->object);
+  }
+  /// Copy a vector into output, see accessors::RetrieveVectorData.
+  template <typename T>
+  accessors::DataRetrievalResult RetrieveVectorData(T* output) const {
+    return accessors::RetrieveVectorData(this->object, output);
+  }
+  /// Create a view over a vector, see vector_view::MakeKVectorView.
+  template <typename T>
+  accessors::DataRetrievalResult GetView(
+      vector_view::KVectorView<T>* view) const {
+    return vector_view::MakeKVectorView(this->object, view);
+  }
+
+ private:
+  void* object;
+};
+}  // namespace cpp2kdb::k_object
+#endif  // CPP2KDB_K_OBJECT_H__
@@ -0,0 +1,101 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/k_object.h"
+
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "cpp2kdb/kdb_wrapper.h"
+
+// Objects are built in process, no connection is needed.
+namespace {
+/// Reference count of x, read from the k0 header: m, a, t, u and then r.
+int GetReferenceCount(void* x) { return static_cast<int*>(x)[1]; }
+
+/// Build til n as a long vector.
+cpp2kdb::k_object::KObject MakeTil(std::int64_t n) {
+  cpp2kdb::k_object::KObject vector(cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_long_type_id, n));
+  std::int64_t* data = vector.GetVector<std::int64_t>();
+  std::iota(data, data + n, 0);
+  // Returned by move.
+  return vector;
+}
+
+void TestOwnership() {
+  cpp2kdb::k_object::KObject vector = MakeTil(10);
+  void* raw = vector.Get();
+  std::cout << "Reference count after return: " << GetReferenceCount(raw)
+            << std::endl;
+  {
+    cpp2kdb::k_object::KObject copy = vector.Copy();
+    std::cout << "Reference count with a copy: " << GetReferenceCount(raw)
+              << std::endl;
+  }
+  std::cout << "Reference count after the copy is gone: "
+            << GetReferenceCount(raw) << std::endl;
+
+  cpp2kdb::k_object::KObject moved = std::move(vector);
+  std::cout << "After move, source is empty? " << (vector ? "No" : "Yes")
+            << ", reference count " << GetReferenceCount(raw) << std::endl;
+
+  void* released = moved.Release();
+  std::cout << "Released pointer is the same? "
+            << (released == raw ? "Yes" : "No") << std::endl;
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCount(released);
+}
+
+void TestTypedAccessors() {
+  cpp2kdb::k_object::KObject vector = MakeTil(100);
+  std::vector<double> output(vector.GetNumberOfElements());
+  std::cout << "RetrieveVectorData as double: "
+            << vector.RetrieveVectorData(output.data()) << ", last "
+            << output.back() << std::endl;
+  cpp2kdb::vector_view::KVectorView<std::int64_t> view;
+  std::cout << "GetView as int64_t: " << vector.GetView(&view) << ", sum "
+            << std::accumulate(view.begin(), view.end(), std::int64_t{0})
+            << std::endl;
+
+  cpp2kdb::k_object::KObject atom(cpp2kdb::kdb_wrapper::CreateLong(42));
+  std::cout << "Atom as double: " << atom.GetValue<double>()
+            << ", q type id " << atom.GetQTypeId() << std::endl;
+
+  cpp2kdb::k_object::KObject error(cpp2kdb::kdb_wrapper::CreateError("type"));
+  cpp2kdb::k_object::KObject empty;
+  std::cout << "Error is null or error? "
+            << (error.IsNullOrError() ? "Yes" : "No")
+            << ", empty is null or error? "
+            << (empty.IsNullOrError() ? "Yes" : "No") << std::endl;
+}
+
+void TestContainers() {
+  std::vector<cpp2kdb::k_object::KObject> results;
+  for (int i = 1; i <= 100; i++) {
+    results.push_back(MakeTil(i));
+  }
+  // Hand the results to another thread.
+  std::int64_t total = 0;
+  std::thread worker([results = std::move(results), &total]() {
+    for (const cpp2kdb::k_object::KObject& result : results) {
+      total += result.GetNumberOfElements();
+    }
+  });
+  worker.join();
+  std::cout << "Elements in 100 results: " << total << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  TestOwnership();
+  std::cout << "----------------------" << std::endl;
+  TestTypedAccessors();
+  std::cout << "----------------------" << std::endl;
+  TestContainers();
+  return 0;
+}
@@ -15,6 +15,14 @@ k0* GetK(void* input) {
   //
   return reinterpret_cast<k0*>(input);
 }
+
+/// Call hooks set, accessed with the atomic builtins since <atomic> cannot be
+/// included here.
+const CallHooks* call_hooks = nullptr;
+
+/// Number of conversions running on this thread, so the conversions made by
+/// another conversion are not reported again.
+thread_local int conversion_depth = 0;
 }  // namespace
 
 char* ConvertToNonConst(const char* c) {
@@ -24,49 +32,145 @@ char* ConvertToNonConst(const char* c) {
 
 int OpenConnection(const char* host, int port, const char* username_password,
                    int time_out, int capacity) {
+  CallHooksGuard hooks_guard(CallKind::OpenConnection, "OpenConnection", 0,
+                             host, nullptr);
   int result = khpunc(ConvertToNonConst(host), port,
                       ConvertToNonConst(username_password), time_out, capacity);
+  hooks_guard.SetConnection(result);
   return result;
 }
 
 void CloseConnection(int connection) {
+  CallHooksGuard hooks_guard(CallKind::CloseConnection, "CloseConnection",
+                             connection, nullptr, nullptr);
   // call kclose
   return kclose(connection);
 }
 
 void* RunQueryOnConnection(int connection, const char* query) {
+  CallHooksGuard hooks_guard(CallKind::Query, "RunQueryOnConnection",
+                             connection, query, nullptr);
   // Call k.
-  return k(connection, ConvertToNonConst(query), 0);
+  void* result = k(connection, ConvertToNonConst(query), 0);
+  hooks_guard.SetObject(result);
+  return result;
 }
 
 void* RunQueryOnConnection(int connection, const char* query, void* arg) {
+  CallHooksGuard hooks_guard(CallKind::Query, "RunQueryOnConnection",
+                             connection, query, nullptr);
   // Call k.
-  return k(connection, ConvertToNonConst(query), arg, 0);
+  void* result = k(connection, ConvertToNonConst(query), arg, 0);
+  hooks_guard.SetObject(result);
+  return result;
 }
 
 void* RunQueryOnConnection(int connection, const char* query, void* arg1,
                            void* arg2) {
+  CallHooksGuard hooks_guard(CallKind::Query, "RunQueryOnConnection",
+                             connection, query, nullptr);
   // Call k.
-  return k(connection, ConvertToNonConst(query), arg1, arg2, 0);
+  void* result = k(connection, ConvertToNonConst(query), arg1, arg2, 0);
+  hooks_guard.SetObject(result);
+  return result;
 }
 
 void* RunQueryOnConnection(int connection, const char* query, void* arg1,
                            void* arg2, void* arg3) {
+  CallHooksGuard hooks_guard(CallKind::Query, "RunQueryOnConnection",
+                             connection, query, nullptr);
   // Call k.
-  return k(connection, ConvertToNonConst(query), arg1, arg2, arg3, 0);
+  void* result = k(connection, ConvertToNonConst(query), arg1, arg2, arg3, 0);
+  hooks_guard.SetObject(result);
+  return result;
 }
 
 void* RunQueryOnConnection(int connection, const char* query, void* arg1,
                            void* arg2, void* arg3, void* arg4) {
+  CallHooksGuard hooks_guard(CallKind::Query, "RunQueryOnConnection",
+                             connection, query, nullptr);
   // Call k.
-  return k(connection, ConvertToNonConst(query), arg1, arg2, arg3, arg4, 0);
+  void* result =
+      k(connection, ConvertToNonConst(query), arg1, arg2, arg3, arg4, 0);
+  hooks_guard.SetObject(result);
+  return result;
 }
 
 void* RunQueryOnConnection(int connection, const char* query, void* arg1,
                            void* arg2, void* arg3, void* arg4, void* arg5) {
+  CallHooksGuard hooks_guard(CallKind::Query, "RunQueryOnConnection",
+                             connection, query, nullptr);
   // Call k.
-  return k(connection, ConvertToNonConst(query), arg1, arg2, arg3, arg4, arg5,
-           0);
+  void* result = k(connection, ConvertToNonConst(query), arg1, arg2, arg3,
+                   arg4, arg5, 0);
+  hooks_guard.SetObject(result);
+  return result;
+}
+
+bool SendAsyncQueryOnConnection(int connection, const char* query) {
+  // Negative handle for async.
+  return k(-connection, ConvertToNonConst(query), 0) != nullptr;
+}
+
+bool SendAsyncQueryOnConnection(int connection, const char* query, void* arg1,
+                                void* arg2) {
+  // Negative handle for async.
+  return k(-connection, ConvertToNonConst(query), arg1, arg2, 0) != nullptr;
+}
+
+void* ReadMessageFromConnection(int connection) {
+  // k with null query reads the incoming message.
+  return k(connection, static_cast<S>(nullptr));
+}
+
+int SetSymbolInterningMutex(int flag) {
+  // call setm
+  return setm(flag);
+}
+
+void* CreateLong(long long value) {  // NOLINT
+  // call kj
+  return kj(value);
+}
+
+void* CreateVector(int q_type_id, long long n) {  // NOLINT
+  // call ktn
+  return ktn(q_type_id, n);
+}
+
+void* CreateCharVector(const char* value) {
+  // call kp
+  return kp(ConvertToNonConst(value));
+}
+
+void* CreateError(const char* message) {
+  // krr keeps the pointer, so intern the message.
+  return krr(ss(ConvertToNonConst(message)));
+}
+
+char* InternSymbol(const char* value) {
+  // call ss
+  return ss(ConvertToNonConst(value));
+}
+
+void* CreateDict(void* keys, void* values) {
+  // call xD
+  return xD(GetK(keys), GetK(values));
+}
+
+void* CreateTable(void* dict) {
+  // call xT
+  return xT(GetK(dict));
+}
+
+void* Serialize(int mode, void* x) {
+  // call b9
+  return b9(mode, GetK(x));
+}
+
+void* Deserialize(void* bytes) {
+  // call d9
+  return d9(GetK(bytes));
 }
 
 int GetQTypeId(void* x) {
@@ -117,4 +221,37 @@ DecreaseReferenceCountGuard::~DecreaseReferenceCountGuard() {
     kdb_wrapper::DecreaseReferenceCount(this->pointer_to_guard);
   }
 }
+
+void SetCallHooks(const CallHooks* hooks) {
+  __atomic_store_n(&call_hooks, hooks, __ATOMIC_RELEASE);
+}
+
+const CallHooks* GetCallHooks() {
+  return __atomic_load_n(&call_hooks, __ATOMIC_ACQUIRE);
+}
+
+CallHooksGuard::CallHooksGuard(CallKind kind, const char* function,
+                               int connection, const char* query, void* object)
+    : info{kind, function, connection, query, object, 0, GetCallHooks()} {
+  // Only the outermost conversion is reported.
+  if (kind == CallKind::Conversion && conversion_depth++ > 0) {
+    this->info.hooks = nullptr;
+  }
+  if (this->info.hooks != nullptr) {
+    this->info.hooks->before(&this->info);
+  }
+}
+void CallHooksGuard::SetConnection(int connection) {
+  this->info.connection = connection;
+}
+void CallHooksGuard::SetObject(void* object) { this->info.object = object; }
+CallHooksGuard::~CallHooksGuard() {
+  // Only call when hooks are set.
+  if (this->info.hooks != nullptr) {
+    this->info.hooks->after(&this->info);
+  }
+  if (this->info.kind == CallKind::Conversion) {
+    --conversion_depth;
+  }
+}
 }  // namespace cpp2kdb::kdb_wrapper
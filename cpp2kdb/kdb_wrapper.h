@@ -117,6 +117,101 @@ void* RunQueryOnConnection(
     /// Argument 5
     void* arg5);
 
+/// Send query on a connection asynchronously.
+///
+/// This calls k on the negative handle, so the call returns once the message
+/// is written, and the server doesn't send anything back unless the query
+/// itself writes to .z.w.
+/// \returns false if the message cannot be sent.
+bool SendAsyncQueryOnConnection(
+    /// Handle
+    int connection,
+    /// Query
+    const char* query);
+
+/// Send query on a connection asynchronously.
+///
+/// Like RunQueryOnConnection, k decreases the reference count of the argument.
+/// \returns false if the message cannot be sent.
+bool SendAsyncQueryOnConnection(
+    /// Handle
+    int connection,
+    /// Query
+    const char* query,
+    /// Argument 1
+    void* arg1,
+    /// Argument 2
+    void* arg2);
+
+/// Read the next incoming message on a connection.
+///
+/// This calls k with a null query, which blocks until a message, such as the
+/// one sent by neg[.z.w] on the server, arrives.
+/// \returns nullptr if the connection is lost.
+void* ReadMessageFromConnection(
+    /// Handle
+    int connection);
+
+/// Set whether interning symbols is protected by a mutex, by calling setm.
+///
+/// This must be turned on before K objects with symbols are created or
+/// received on more than one thread.
+/// \returns the previous setting.
+int SetSymbolInterningMutex(
+    /// 1 to turn on the mutex, 0 to turn off.
+    int flag);
+
+/// Create a long atom by calling kj.
+void* CreateLong(long long value);  // NOLINT
+
+/// Create a vector of q type id and n elements by calling ktn.
+///
+/// The elements are not initialized. For a mixed list (type 0), every element
+/// must be set to a K object before the list is used or released.
+void* CreateVector(int q_type_id, long long n);  // NOLINT
+
+/// Create a char vector from a \0 terminated string by calling kp.
+void* CreateCharVector(const char* value);
+
+/// Create an error object by calling krr.
+///
+/// The message is interned with ss first, since krr keeps the pointer.
+void* CreateError(const char* message);
+
+/// Intern a \0 terminated string as a symbol by calling ss.
+///
+/// Interned symbols with the same content share the same pointer, which is
+/// what a symbol vector holds for each element.
+char* InternSymbol(const char* value);
+
+/// Create a dictionary from keys and values by calling xD.
+///
+/// The dictionary takes over the references to keys and values.
+void* CreateDict(void* keys, void* values);
+
+/// Create a table from a dictionary of column names to columns by calling xT.
+///
+/// The table takes over the reference to dict.
+/// \returns nullptr if dict is not a valid table.
+void* CreateTable(void* dict);
+
+/// Serialize x to the IPC format by calling b9.
+///
+/// The result is a byte vector (type 4) holding the whole message, including
+/// the 8 byte message header.
+/// \returns nullptr if x cannot be serialized.
+void* Serialize(
+    /// Mode, per kdb doc. 2 is unenumerate and allow timestamp/timespan, 3 is
+    /// the same and also compress.
+    int mode,
+    /// Object to serialize.
+    void* x);
+
+/// Deserialize a byte vector in IPC format by calling d9.
+///
+/// \returns nullptr or an error object if bytes cannot be deserialized.
+void* Deserialize(void* bytes);
+
 /// Obtain type id of this K pointer.
 ///
 /// Get the type id of the data contained in this k.
@@ -191,5 +286,109 @@ class DecreaseReferenceCountGuard {
  private:
   void* pointer_to_guard;
 };
+
+/// Kind of the call reported to the call hooks.
+enum class CallKind {
+  /// OpenConnection.
+  OpenConnection = 0,
+  /// CloseConnection.
+  CloseConnection,
+  /// RunQueryOnConnection.
+  Query,
+  /// Conversion of a K object by accessors, such as RetrieveVectorData.
+  Conversion
+};
+
+struct CallHooks;
+
+/// A call reported to the call hooks.
+///
+/// The same CallInfo is passed to the before hook and the after hook.
+struct CallInfo {
+  /// Kind of the call.
+  CallKind kind;
+  /// Name of the function called, such as "RunQueryOnConnection".
+  const char* function;
+  /// Handle. For OpenConnection, this is the value returned when the after
+  /// hook is called. 0 for conversions.
+  int connection;
+  /// Query for RunQueryOnConnection, host for OpenConnection, nullptr
+  /// otherwise.
+  const char* query;
+  /// K object returned by RunQueryOnConnection when the after hook is called,
+  /// or K object converted. nullptr otherwise.
+  void* object;
+  /// Free for the hooks to use, for example to keep the time when the before
+  /// hook is called.
+  long long hook_data;  // NOLINT
+  /// Hooks called, which are the hooks set when the call starts.
+  const CallHooks* hooks;
+};
+
+/// Functions called before and after the calls to OpenConnection,
+/// CloseConnection, RunQueryOnConnection and the conversions in accessors.
+///
+/// Hooks are called on the thread making the call, and must be thread safe if
+/// calls are made on more than one thread.
+struct CallHooks {
+  /// Called before the call.
+  void (*before)(CallInfo* info);
+  /// Called after the call.
+  void (*after)(CallInfo* info);
+};
+
+/// Set the call hooks, nullptr to remove them.
+///
+/// Hooks are not owned and must outlive all the calls, including the calls
+/// started before they are replaced. When no hooks are set, a call only
+/// checks a pointer. There is only one set of hooks, cpp2kdb/tracing.h sets
+/// them to call any number of interceptors.
+void SetCallHooks(const CallHooks* hooks);
+
+/// Get the call hooks set, nullptr if there are none.
+const CallHooks* GetCallHooks();
+
+/// Report a call to the call hooks.
+///
+/// The before hook is called when constructed and the after hook when
+/// destructed, with the hooks set when constructed. Nothing is done if no
+/// hooks are set.
+///
+/// A conversion made while another conversion is running on the same thread,
+/// such as RetrieveVectorData called by RetrieveStringColumn, is not reported,
+/// so each conversion is reported once with its whole time.
+class CallHooksGuard {
+ public:
+  /// Create CallHooksGuard and call the before hook.
+  CallHooksGuard(
+      /// Kind of the call.
+      CallKind kind,
+      /// Name of the function called.
+      const char* function,
+      /// Handle, 0 if there is none.
+      int connection,
+      /// Query or host, nullptr if there is none.
+      const char* query,
+      /// K object converted, nullptr if there is none.
+      void* object);
+  /// Default constructor is deleted.
+  CallHooksGuard() = delete;
+  /// Copy constructor is deleted.
+  CallHooksGuard(const CallHooksGuard&) = delete;
+  /// Move constructor is deleted.
+  CallHooksGuard(CallHooksGuard&&) = delete;
+  /// assignment operator is deleted.
+  CallHooksGuard& operator=(const CallHooksGuard&) = delete;
+  /// Set the handle returned by the call.
+  void SetConnection(int connection);
+  /// Set the K object returned by the call.
+  void SetObject(void* object);
+
+  /// Destructor, calling the after hook.
+  ~CallHooksGuard();
+
+ private:
+  CallInfo info;
+};
 }  // namespace cpp2kdb::kdb_wrapper
 #endif  // CPP2KDB_KDB_WRAPPER_H__
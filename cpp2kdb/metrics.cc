@@ -0,0 +1,427 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/metrics.h"
+
+#include <linux/tcp.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+#include "cpp2kdb/tracing.h"
+
+namespace cpp2kdb::metrics {
+namespace {
+/// Size of the header of a K object, as counted by
+/// accessors::EstimateObjectSize.
+constexpr std::uint64_t object_header_size = 16;
+
+/// log2 of number_of_sub_buckets.
+constexpr int sub_bucket_bits = 4;
+static_assert((1 << sub_bucket_bits) == number_of_sub_buckets,
+              "sub_bucket_bits must match number_of_sub_buckets");
+
+/// Histogram updated by many threads.
+class AtomicHistogram {
+ public:
+  /// Zeroed histogram.
+  AtomicHistogram() { this->Reset(); }
+  /// Copy constructor is deleted.
+  AtomicHistogram(const AtomicHistogram&) = delete;
+  /// assignment operator is deleted.
+  AtomicHistogram& operator=(const AtomicHistogram&) = delete;
+
+  /// Add a value.
+  void Record(std::uint64_t value) {
+    this->buckets[GetHistogramBucket(value)].fetch_add(
+        1, std::memory_order_relaxed);
+    this->count.fetch_add(1, std::memory_order_relaxed);
+    this->total.fetch_add(value, std::memory_order_relaxed);
+    std::uint64_t max_value = this->max.load(std::memory_order_relaxed);
+    while (max_value < value &&
+           !this->max.compare_exchange_weak(max_value, value,
+                                            std::memory_order_relaxed)) {
+      // max_value is reloaded by compare_exchange_weak.
+    }
+  }
+
+  /// Copy the counts.
+  Histogram GetSnapshot() const {
+    Histogram histogram;
+    histogram.count = this->count.load(std::memory_order_relaxed);
+    histogram.total = this->total.load(std::memory_order_relaxed);
+    histogram.max = this->max.load(std::memory_order_relaxed);
+    for (int i = 0; i < number_of_histogram_buckets; i++) {
+      histogram.buckets[i] = this->buckets[i].load(std::memory_order_relaxed);
+    }
+    return histogram;
+  }
+
+  /// Set all the counts to 0.
+  void Reset() {
+    this->count.store(0, std::memory_order_relaxed);
+    this->total.store(0, std::memory_order_relaxed);
+    this->max.store(0, std::memory_order_relaxed);
+    for (auto& bucket : this->buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  std::atomic<std::uint64_t> count;
+  std::atomic<std::uint64_t> total;
+  std::atomic<std::uint64_t> max;
+  std::array<std::atomic<std::uint64_t>, number_of_histogram_buckets> buckets;
+};
+
+/// Counters of a handle.
+struct ConnectionCounters {
+  std::atomic<bool> is_open;
+  std::atomic<std::uint64_t> number_of_queries;
+  std::atomic<std::uint64_t> number_of_errors;
+  std::atomic<std::uint64_t> number_of_failures;
+  std::atomic<std::uint64_t> bytes_received;
+  std::atomic<std::uint64_t> object_bytes;
+  /// Bytes received on the socket when last read, to take the difference.
+  std::atomic<std::uint64_t> socket_bytes_received;
+};
+
+/// All the metrics. Atomics in static storage start at 0.
+struct Metrics {
+  std::atomic<std::uint64_t> number_of_connections_opened;
+  std::atomic<std::uint64_t> number_of_failed_connections;
+  std::atomic<std::uint64_t> number_of_queries;
+  std::atomic<std::uint64_t> number_of_errors;
+  std::atomic<std::uint64_t> number_of_failures;
+  std::atomic<std::uint64_t> bytes_received;
+  AtomicHistogram query_latency;
+  AtomicHistogram object_size;
+  AtomicHistogram conversion_latency;
+  std::array<ConnectionCounters, max_number_of_connections> connections;
+};
+
+Metrics metrics;
+
+/// Set from MetricsOptions::estimate_nested_objects.
+std::atomic<bool> is_estimating_nested_objects{false};
+
+/// Add 1 to a counter.
+void Increment(std::atomic<std::uint64_t>* counter) {
+  counter->fetch_add(1, std::memory_order_relaxed);
+}
+
+/// Get the counters of a handle, nullptr if the handle is out of range.
+ConnectionCounters* GetConnectionCounters(int connection) {
+  if (connection <= 0 || connection >= max_number_of_connections) {
+    return nullptr;
+  }
+  return &metrics.connections[connection];
+}
+
+/// Get the bytes received on a socket since it is opened, 0 if this is not a
+/// TCP socket.
+std::uint64_t GetSocketBytesReceived(int connection) {
+  tcp_info info;
+  socklen_t length = sizeof(info);
+  if (getsockopt(connection, IPPROTO_TCP, TCP_INFO, &info, &length) != 0 ||
+      length < sizeof(info)) {
+    return 0;
+  }
+  return info.tcpi_bytes_received;
+}
+
+/// Estimate the size of x like accessors::EstimateObjectSize, but only size
+/// the elements of mixed lists while number_of_sized_lists is positive.
+/// Tables and dictionaries don't count as lists, so 1 sizes the columns of a
+/// table, keyed or not, and a mixed list column only counts its pointers.
+std::uint64_t EstimateResultSize(void* x, int number_of_sized_lists) {
+  int q_type_id = kdb_wrapper::GetQTypeId(x);
+  if (q_type_id == q_types::q_table_type_id) {
+    return object_header_size +
+           EstimateResultSize(accessors::GetValue<void*>(x),
+                              number_of_sized_lists);
+  }
+  if (q_type_id == q_types::q_dict_type_id) {
+    void** key_value = accessors::GetVector<void*>(x);
+    return object_header_size + 2 * sizeof(void*) +
+           EstimateResultSize(key_value[0], number_of_sized_lists) +
+           EstimateResultSize(key_value[1], number_of_sized_lists);
+  }
+  if (q_types::IsQTypeIdMixedVector(q_type_id)) {
+    std::size_t number_of_elements = kdb_wrapper::GetNumberOfVectorElements(x);
+    std::uint64_t size =
+        object_header_size + number_of_elements * sizeof(void*);
+    if (number_of_sized_lists > 0) {
+      void** elements = accessors::GetVector<void*>(x);
+      for (std::size_t i = 0; i < number_of_elements; i++) {
+        size += EstimateResultSize(elements[i], number_of_sized_lists - 1);
+      }
+    }
+    return size;
+  }
+  if (q_types::IsQTypeIdVector(q_type_id)) {
+    return object_header_size + kdb_wrapper::GetNumberOfVectorElements(x) *
+                                    q_types::GetElementSizeOfQTypeId(q_type_id);
+  }
+  // Atoms, errors and functions.
+  return object_header_size;
+}
+
+void RecordOpenConnection(const tracing::CallEvent& event) {
+  Increment(&metrics.number_of_connections_opened);
+  if (event.connection <= 0) {
+    Increment(&metrics.number_of_failed_connections);
+    return;
+  }
+  ConnectionCounters* counters = GetConnectionCounters(event.connection);
+  if (counters == nullptr) {
+    return;
+  }
+  // The handle may be reused, start from 0.
+  counters->number_of_queries.store(0, std::memory_order_relaxed);
+  counters->number_of_errors.store(0, std::memory_order_relaxed);
+  counters->number_of_failures.store(0, std::memory_order_relaxed);
+  counters->bytes_received.store(0, std::memory_order_relaxed);
+  counters->object_bytes.store(0, std::memory_order_relaxed);
+  counters->socket_bytes_received.store(
+      GetSocketBytesReceived(event.connection), std::memory_order_relaxed);
+  counters->is_open.store(true, std::memory_order_relaxed);
+}
+
+void RecordQuery(const tracing::CallEvent& event,
+                 std::uint64_t nanoseconds) {
+  Increment(&metrics.number_of_queries);
+  metrics.query_latency.Record(nanoseconds);
+  ConnectionCounters* counters = GetConnectionCounters(event.connection);
+  if (counters != nullptr) {
+    Increment(&counters->number_of_queries);
+  }
+
+  if (event.object == nullptr) {
+    Increment(&metrics.number_of_failures);
+    if (counters != nullptr) {
+      Increment(&counters->number_of_failures);
+    }
+    return;
+  }
+  if (accessors::IsError(event.object)) {
+    Increment(&metrics.number_of_errors);
+    if (counters != nullptr) {
+      Increment(&counters->number_of_errors);
+    }
+  }
+  std::uint64_t object_bytes =
+      is_estimating_nested_objects.load(std::memory_order_relaxed)
+          ? accessors::EstimateObjectSize(event.object)
+          : EstimateResultSize(event.object, 1);
+  metrics.object_size.Record(object_bytes);
+  if (counters == nullptr) {
+    return;
+  }
+  counters->object_bytes.fetch_add(object_bytes, std::memory_order_relaxed);
+  // Bytes received are counted by the socket, take the difference since the
+  // last query.
+  std::uint64_t socket_bytes_received =
+      GetSocketBytesReceived(event.connection);
+  std::uint64_t last_socket_bytes_received =
+      counters->socket_bytes_received.exchange(socket_bytes_received,
+                                               std::memory_order_relaxed);
+  if (socket_bytes_received > last_socket_bytes_received) {
+    std::uint64_t bytes_received =
+        socket_bytes_received - last_socket_bytes_received;
+    counters->bytes_received.fetch_add(bytes_received,
+                                       std::memory_order_relaxed);
+    metrics.bytes_received.fetch_add(bytes_received,
+                                     std::memory_order_relaxed);
+  }
+}
+
+/// Interceptor updating the metrics.
+class MetricsInterceptor : public tracing::Interceptor {
+ public:
+  /// Update the metrics with a call.
+  void OnAfter(const tracing::CallEvent& event) override {
+    std::uint64_t nanoseconds =
+        event.duration.count() > 0 ? event.duration.count() : 0;
+    switch (event.kind) {
+      case kdb_wrapper::CallKind::OpenConnection:
+        RecordOpenConnection(event);
+        break;
+      case kdb_wrapper::CallKind::CloseConnection: {
+        ConnectionCounters* counters =
+            GetConnectionCounters(event.connection);
+        if (counters != nullptr) {
+          counters->is_open.store(false, std::memory_order_relaxed);
+        }
+        break;
+      }
+      case kdb_wrapper::CallKind::Query:
+        RecordQuery(event, nanoseconds);
+        break;
+      case kdb_wrapper::CallKind::Conversion:
+        metrics.conversion_latency.Record(nanoseconds);
+        break;
+    }
+  }
+};
+
+MetricsInterceptor metrics_interceptor;
+
+/// Print count, mean, percentiles and max of a histogram.
+void PrintHistogram(std::ostream& output_stream, const char* name,
+                    const Histogram& histogram) {
+  output_stream << name << ": count " << histogram.count;
+  if (histogram.count > 0) {
+    output_stream << ", mean " << histogram.total / histogram.count << ", p50 "
+                  << GetPercentile(histogram, 0.5) << ", p99 "
+                  << GetPercentile(histogram, 0.99) << ", p99.9 "
+                  << GetPercentile(histogram, 0.999) << ", max "
+                  << histogram.max;
+  }
+  output_stream << std::endl;
+}
+}  // namespace
+
+int GetHistogramBucket(std::uint64_t value) {
+  if (value < 2 * number_of_sub_buckets) {
+    return static_cast<int>(value);
+  }
+  int exponent = 63 - __builtin_clzll(value);
+  if (exponent >= max_histogram_exponent) {
+    return number_of_histogram_buckets - 1;
+  }
+  // The top sub_bucket_bits + 1 bits pick the bucket, the first of them is 1.
+  int shift = exponent - sub_bucket_bits;
+  return (shift + 1) * number_of_sub_buckets +
+         static_cast<int>(value >> shift) - number_of_sub_buckets;
+}
+
+std::uint64_t GetHistogramBucketLowerBound(int bucket) {
+  if (bucket < 2 * number_of_sub_buckets) {
+    return bucket;
+  }
+  if (bucket >= number_of_histogram_buckets - 1) {
+    return std::uint64_t{1} << max_histogram_exponent;
+  }
+  int shift = bucket / number_of_sub_buckets - 1;
+  return static_cast<std::uint64_t>(bucket % number_of_sub_buckets +
+                                    number_of_sub_buckets)
+         << shift;
+}
+
+std::uint64_t GetPercentile(const Histogram& histogram, double fraction) {
+  std::uint64_t total = 0;
+  for (std::uint64_t count : histogram.buckets) {
+    total += count;
+  }
+  std::uint64_t cumulative = 0;
+  for (int i = 0; i < number_of_histogram_buckets; i++) {
+    cumulative += histogram.buckets[i];
+    if (cumulative > 0 && cumulative >= fraction * total) {
+      if (i == number_of_histogram_buckets - 1) {
+        return histogram.max;
+      }
+      return std::min(GetHistogramBucketLowerBound(i + 1), histogram.max);
+    }
+  }
+  return 0;
+}
+
+void EnableMetrics(MetricsOptions options) {
+  is_estimating_nested_objects.store(options.estimate_nested_objects,
+                                     std::memory_order_relaxed);
+  tracing::AddInterceptor(&metrics_interceptor);
+}
+
+void DisableMetrics() { tracing::RemoveInterceptor(&metrics_interceptor); }
+
+MetricsSnapshot GetSnapshot() {
+  MetricsSnapshot snapshot;
+  snapshot.number_of_connections_opened =
+      metrics.number_of_connections_opened.load(std::memory_order_relaxed);
+  snapshot.number_of_failed_connections =
+      metrics.number_of_failed_connections.load(std::memory_order_relaxed);
+  snapshot.number_of_queries =
+      metrics.number_of_queries.load(std::memory_order_relaxed);
+  snapshot.number_of_errors =
+      metrics.number_of_errors.load(std::memory_order_relaxed);
+  snapshot.number_of_failures =
+      metrics.number_of_failures.load(std::memory_order_relaxed);
+  snapshot.bytes_received =
+      metrics.bytes_received.load(std::memory_order_relaxed);
+  snapshot.query_latency = metrics.query_latency.GetSnapshot();
+  snapshot.object_size = metrics.object_size.GetSnapshot();
+  snapshot.conversion_latency = metrics.conversion_latency.GetSnapshot();
+  for (int i = 1; i < max_number_of_connections; i++) {
+    const ConnectionCounters& counters = metrics.connections[i];
+    ConnectionMetrics connection;
+    connection.connection = i;
+    connection.is_open = counters.is_open.load(std::memory_order_relaxed);
+    connection.number_of_queries =
+        counters.number_of_queries.load(std::memory_order_relaxed);
+    if (!connection.is_open && connection.number_of_queries == 0) {
+      continue;
+    }
+    connection.number_of_errors =
+        counters.number_of_errors.load(std::memory_order_relaxed);
+    connection.number_of_failures =
+        counters.number_of_failures.load(std::memory_order_relaxed);
+    connection.bytes_received =
+        counters.bytes_received.load(std::memory_order_relaxed);
+    connection.object_bytes =
+        counters.object_bytes.load(std::memory_order_relaxed);
+    snapshot.connections.push_back(connection);
+  }
+  return snapshot;
+}
+
+void ResetMetrics() {
+  metrics.number_of_connections_opened.store(0, std::memory_order_relaxed);
+  metrics.number_of_failed_connections.store(0, std::memory_order_relaxed);
+  metrics.number_of_queries.store(0, std::memory_order_relaxed);
+  metrics.number_of_errors.store(0, std::memory_order_relaxed);
+  metrics.number_of_failures.store(0, std::memory_order_relaxed);
+  metrics.bytes_received.store(0, std::memory_order_relaxed);
+  metrics.query_latency.Reset();
+  metrics.object_size.Reset();
+  metrics.conversion_latency.Reset();
+  for (ConnectionCounters& counters : metrics.connections) {
+    counters.number_of_queries.store(0, std::memory_order_relaxed);
+    counters.number_of_errors.store(0, std::memory_order_relaxed);
+    counters.number_of_failures.store(0, std::memory_order_relaxed);
+    counters.bytes_received.store(0, std::memory_order_relaxed);
+    counters.object_bytes.store(0, std::memory_order_relaxed);
+  }
+}
+
+std::ostream& operator<<(std::ostream& output_stream,
+                         const MetricsSnapshot& snapshot) {
+  output_stream << "connections opened: "
+                << snapshot.number_of_connections_opened << ", failed "
+                << snapshot.number_of_failed_connections << std::endl;
+  output_stream << "queries: " << snapshot.number_of_queries << ", errors "
+                << snapshot.number_of_errors << ", failures "
+                << snapshot.number_of_failures << ", bytes received "
+                << snapshot.bytes_received << std::endl;
+  PrintHistogram(output_stream, "query latency (ns)", snapshot.query_latency);
+  PrintHistogram(output_stream, "object size (bytes)", snapshot.object_size);
+  PrintHistogram(output_stream, "conversion latency (ns)",
+                 snapshot.conversion_latency);
+  for (const ConnectionMetrics& connection : snapshot.connections) {
+    output_stream << "handle " << connection.connection
+                  << (connection.is_open ? " (open)" : " (closed)")
+                  << ": queries " << connection.number_of_queries
+                  << ", errors " << connection.number_of_errors
+                  << ", failures " << connection.number_of_failures
+                  << ", bytes received " << connection.bytes_received
+                  << ", object bytes " << connection.object_bytes
+                  << std::endl;
+  }
+  return output_stream;
+}
+}  // namespace cpp2kdb::metrics
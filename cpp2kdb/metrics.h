@@ -0,0 +1,150 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_METRICS_H__
+#define CPP2KDB_METRICS_H__
+/// \file cpp2kdb/metrics.h
+/// Metrics of the queries and the conversions, collected by an interceptor of
+/// tracing.
+///
+/// Once enabled, every OpenConnection, RunQueryOnConnection and conversion by
+/// accessors (RetrieveVectorData and GetSimpleTable) is counted and timed.
+/// Counters are atomics updated with relaxed order, so a snapshot can be taken
+/// on any thread while queries run. The cost is the one of tracing, which is
+/// two reads of the steady clock per call, plus for queries one getsockopt to
+/// read the bytes received and an estimate of the size of the result, which
+/// stops at the columns of tables (see MetricsOptions).
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+/// Metrics of the queries and the conversions.
+namespace cpp2kdb::metrics {
+/// Number of buckets for each power of two in the histograms, so the bucket
+/// of a value is at most 1/16 of the value wide.
+constexpr int number_of_sub_buckets = 16;
+
+/// Values of 2^max_histogram_exponent and above are counted in the last
+/// bucket. That is about 73 minutes for latencies in nanoseconds.
+constexpr int max_histogram_exponent = 42;
+
+/// Number of buckets in the histograms.
+///
+/// Values below 2 * number_of_sub_buckets have a bucket each. Above that,
+/// each power of two is split into number_of_sub_buckets buckets of the same
+/// width, as in an HDR histogram. The last bucket counts the values too large.
+constexpr int number_of_histogram_buckets =
+    (max_histogram_exponent - 3) * number_of_sub_buckets + 1;
+
+/// Get the bucket of a value.
+int GetHistogramBucket(std::uint64_t value);
+
+/// Get the smallest value counted in a bucket.
+std::uint64_t GetHistogramBucketLowerBound(int bucket);
+
+/// Histogram of latencies in nanoseconds or sizes in bytes.
+struct Histogram {
+  /// Number of values.
+  std::uint64_t count = 0;
+  /// Sum of the values.
+  std::uint64_t total = 0;
+  /// Largest value.
+  std::uint64_t max = 0;
+  /// Number of values in each bucket, see GetHistogramBucket.
+  std::array<std::uint64_t, number_of_histogram_buckets> buckets = {};
+};
+
+/// Get the value under which the given fraction of the values are, as the
+/// upper bound of the bucket, but no more than the largest value.
+std::uint64_t GetPercentile(
+    /// [in] Histogram.
+    const Histogram& histogram,
+    /// Fraction, between 0 and 1.
+    double fraction);
+
+/// Options of the metrics.
+struct MetricsOptions {
+  /// Size the results by accessors::EstimateObjectSize, which walks every
+  /// element of mixed lists, such as the char vectors of a string column.
+  /// Otherwise, the size is estimated the same way, but only down to the
+  /// columns of a table or the elements of a mixed list returned: the elements
+  /// of mixed lists below are counted as pointers, so the cost is in the
+  /// number of columns and not of rows.
+  bool estimate_nested_objects = false;
+};
+
+/// Handles are file descriptors, which are small numbers. Handles from
+/// max_number_of_connections up are only counted in the totals.
+constexpr int max_number_of_connections = 1024;
+
+/// Metrics of a connection, since it is opened.
+struct ConnectionMetrics {
+  /// Handle.
+  int connection = 0;
+  /// Whether the connection is open, as far as OpenConnection and
+  /// CloseConnection tell.
+  bool is_open = false;
+  /// Number of queries run.
+  std::uint64_t number_of_queries = 0;
+  /// Number of queries returning a q error.
+  std::uint64_t number_of_errors = 0;
+  /// Number of queries returning nullptr, which means the connection is lost.
+  std::uint64_t number_of_failures = 0;
+  /// Bytes received on the socket by the queries, read from TCP_INFO.
+  std::uint64_t bytes_received = 0;
+  /// Sum of the estimated sizes of the results, see MetricsOptions.
+  std::uint64_t object_bytes = 0;
+};
+
+/// Snapshot of the metrics.
+struct MetricsSnapshot {
+  /// Number of calls to OpenConnection.
+  std::uint64_t number_of_connections_opened = 0;
+  /// Number of calls to OpenConnection returning no handle.
+  std::uint64_t number_of_failed_connections = 0;
+  /// Number of queries run.
+  std::uint64_t number_of_queries = 0;
+  /// Number of queries returning a q error.
+  std::uint64_t number_of_errors = 0;
+  /// Number of queries returning nullptr.
+  std::uint64_t number_of_failures = 0;
+  /// Bytes received on the sockets by the queries.
+  std::uint64_t bytes_received = 0;
+  /// Latency of the queries in nanoseconds.
+  Histogram query_latency;
+  /// Estimated size of the results in bytes, see MetricsOptions.
+  Histogram object_size;
+  /// Time spent in the conversions in nanoseconds.
+  Histogram conversion_latency;
+  /// Connections open or queried since they were opened, by handle.
+  std::vector<ConnectionMetrics> connections;
+};
+
+/// Start collecting metrics by adding an interceptor with
+/// tracing::AddInterceptor. Enabling again replaces the options.
+void EnableMetrics(
+    /// Options.
+    MetricsOptions options = MetricsOptions());
+
+/// Stop collecting metrics by removing the interceptor. Metrics collected are
+/// kept.
+void DisableMetrics();
+
+/// Get a snapshot of the metrics, which can be called on any thread.
+///
+/// Counters are read one by one while they may be updated, so the snapshot
+/// can be off by the calls running when it is taken.
+MetricsSnapshot GetSnapshot();
+
+/// Reset all the metrics to 0. Connections open are kept open.
+void ResetMetrics();
+
+/// Print the snapshot, with the 50th, 99th and 99.9th percentiles of the
+/// histograms.
+std::ostream& operator<<(std::ostream& output_stream,
+                         const MetricsSnapshot& snapshot);
+}  // namespace cpp2kdb::metrics
+#endif  // CPP2KDB_METRICS_H__
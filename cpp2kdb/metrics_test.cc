@@ -0,0 +1,115 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/metrics.h"
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace {
+void TestHistogramBuckets() {
+  bool is_consistent = true;
+  for (int i = 0; i < cpp2kdb::metrics::number_of_histogram_buckets; i++) {
+    std::uint64_t lower_bound =
+        cpp2kdb::metrics::GetHistogramBucketLowerBound(i);
+    is_consistent =
+        is_consistent &&
+        cpp2kdb::metrics::GetHistogramBucket(lower_bound) == i &&
+        (i == 0 || cpp2kdb::metrics::GetHistogramBucket(lower_bound - 1) ==
+                       i - 1);
+  }
+  std::cout << "Bucket bounds are consistent? "
+            << (is_consistent ? "Yes" : "No") << std::endl;
+
+  cpp2kdb::metrics::Histogram histogram;
+  for (std::uint64_t value = 1; value <= 1000000; value++) {
+    histogram.buckets[cpp2kdb::metrics::GetHistogramBucket(value)]++;
+    histogram.count++;
+    histogram.total += value;
+  }
+  histogram.max = 1000000;
+  std::cout << "Percentiles of 1 to 1000000: p50 "
+            << cpp2kdb::metrics::GetPercentile(histogram, 0.5) << ", p99 "
+            << cpp2kdb::metrics::GetPercentile(histogram, 0.99) << ", p100 "
+            << cpp2kdb::metrics::GetPercentile(histogram, 1) << std::endl;
+}
+
+// No connection is needed for conversions.
+void TestConversions() {
+  void* vector = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_long_type_id, 1000000);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(vector);
+  std::vector<double> output(1000000);
+  for (int i = 0; i < 100; i++) {
+    cpp2kdb::accessors::RetrieveVectorData(vector, output.data());
+  }
+  cpp2kdb::metrics::MetricsSnapshot snapshot = cpp2kdb::metrics::GetSnapshot();
+  std::cout << "Conversions timed: " << snapshot.conversion_latency.count
+            << ", taking " << snapshot.conversion_latency.total / 1000000
+            << "ms" << std::endl;
+}
+
+void TestQueries(int connection) {
+  for (int i = 0; i < 100; i++) {
+    void* result = cpp2kdb::kdb_wrapper::RunQueryOnConnection(
+        connection, "([] a:til 10000; b:10000?1.0)");
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(result);
+    void* column_heading;
+    void** columns;
+    std::size_t number_of_columns, number_of_rows;
+    cpp2kdb::accessors::GetSimpleTable(result, &column_heading, &columns,
+                                       &number_of_columns, &number_of_rows);
+    std::vector<std::int64_t> a(number_of_rows);
+    cpp2kdb::accessors::RetrieveVectorData(columns[0], a.data());
+  }
+  void* error = cpp2kdb::kdb_wrapper::RunQueryOnConnection(connection, "1+`a");
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCount(error);
+  std::cout << cpp2kdb::metrics::GetSnapshot();
+}
+
+/// Get the estimated size of the result of a query with a string column.
+std::uint64_t GetStringTableSize(int connection) {
+  cpp2kdb::metrics::ResetMetrics();
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(
+      cpp2kdb::kdb_wrapper::RunQueryOnConnection(
+          connection, "([] a:til 1000; s:string til 1000)"));
+  return cpp2kdb::metrics::GetSnapshot().object_size.total;
+}
+
+void TestObjectSize(int connection) {
+  // The char vectors of s are counted as pointers only.
+  std::uint64_t size = GetStringTableSize(connection);
+  cpp2kdb::metrics::MetricsOptions options;
+  options.estimate_nested_objects = true;
+  cpp2kdb::metrics::EnableMetrics(options);
+  std::uint64_t nested_size = GetStringTableSize(connection);
+  cpp2kdb::metrics::EnableMetrics();
+  std::cout << "Size of a string table: " << size << " bytes, with the strings "
+            << nested_size << " bytes" << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  cpp2kdb::metrics::EnableMetrics();
+  TestHistogramBuckets();
+  std::cout << "----------------------" << std::endl;
+  TestConversions();
+  std::cout << "----------------------" << std::endl;
+  cpp2kdb::metrics::ResetMetrics();
+  int connection = cpp2kdb::kdb_wrapper::OpenConnection("127.0.0.1", 5000, "");
+  if (connection <= 0) {
+    std::cerr << "Connection error: " << connection << std::endl;
+    return 1;
+  }
+  TestQueries(connection);
+  std::cout << "----------------------" << std::endl;
+  TestObjectSize(connection);
+  cpp2kdb::kdb_wrapper::CloseConnection(connection);
+  cpp2kdb::metrics::DisableMetrics();
+  return 0;
+}
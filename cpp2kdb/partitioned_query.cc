@@ -0,0 +1,356 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/partitioned_query.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "cpp2kdb/async_query.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace cpp2kdb::partitioned_query {
+namespace {
+/// Days from 1970.01.01 to 2000.01.01, where q dates start.
+constexpr int q_date_epoch_in_unix_days = 10957;
+
+/// Result of one partition sent back by a worker.
+struct Completion {
+  std::size_t partition_index = 0;
+  FanOutResult result = FanOutResult::Ok;
+  /// Result of the query, owned by the completion.
+  void* table = nullptr;
+};
+
+/// Queue of completions from the workers to the calling thread.
+class CompletionQueue {
+ public:
+  void Push(Completion completion) {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->completions.push_back(completion);
+    }
+    this->condition.notify_one();
+  }
+
+  Completion Pop() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->condition.wait(lock, [this] { return !this->completions.empty(); });
+    Completion completion = this->completions.front();
+    this->completions.pop_front();
+    return completion;
+  }
+
+  /// Release the results left after the workers are joined.
+  void ReleaseAll() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (Completion& completion : this->completions) {
+      if (completion.table != nullptr) {
+        kdb_wrapper::DecreaseReferenceCount(completion.table);
+      }
+    }
+    this->completions.clear();
+  }
+
+ private:
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<Completion> completions;
+};
+
+FanOutResult ConvertDeadlineResult(async_query::DeadlineResult result) {
+  switch (result) {
+    case async_query::DeadlineResult::Ok:
+      return FanOutResult::Ok;
+    case async_query::DeadlineResult::TimedOut:
+      return FanOutResult::TimedOut;
+    default:
+      return FanOutResult::ConnectionLost;
+  }
+}
+
+/// Find the column named name in a symbol vector of column names.
+/// \returns number_of_columns if not found.
+std::size_t FindColumn(void* column_heading, std::size_t number_of_columns,
+                       const std::string& name) {
+  char** names = accessors::GetVector<char*>(column_heading);
+  for (std::size_t i = 0; i < number_of_columns; i++) {
+    if (std::strcmp(names[i], name.c_str()) == 0) {
+      return i;
+    }
+  }
+  return number_of_columns;
+}
+}  // namespace
+
+const char* GetFanOutResultName(FanOutResult result) {
+  // Cast result to an int.
+  int temp_result = static_cast<int>(result);
+  // Make sure it's valid.
+  if (temp_result >= 0 && temp_result < number_of_fan_out_result_names) {
+    return FanOutResultNames[temp_result];
+  } else {
+    return "Invalid";
+  }
+}
+
+std::ostream& operator<<(std::ostream& output, FanOutResult result) {
+  return output << GetFanOutResultName(result);
+}
+
+int MakeDate(int year, int month, int day) {
+  // Days from civil, counting years from March so the leap day is the last.
+  year -= month <= 2;
+  int era = (year >= 0 ? year : year - 399) / 400;
+  int year_of_era = year - era * 400;
+  int day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  int day_of_era =
+      year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+  return era * 146097 + day_of_era - 719468 - q_date_epoch_in_unix_days;
+}
+
+std::string FormatDate(int date) {
+  // Civil from days, the inverse of MakeDate.
+  int days = date + q_date_epoch_in_unix_days + 719468;
+  int era = (days >= 0 ? days : days - 146096) / 146097;
+  int day_of_era = days - era * 146097;
+  int year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 -
+                     day_of_era / 146096) /
+                    365;
+  int day_of_year =
+      day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+  int shifted_month = (5 * day_of_year + 2) / 153;
+  int day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+  int month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+  int year = year_of_era + era * 400 + (month <= 2);
+
+  char buffer[16];
+  std::snprintf(buffer, sizeof(buffer), "%04d.%02d.%02d", year, month, day);
+  return buffer;
+}
+
+std::size_t MergedTable::GetNumberOfRows() const {
+  return this->partition_first_rows.empty() ? 0
+                                            : this->partition_first_rows.back();
+}
+
+const std::vector<std::size_t>& MergedTable::GetPartitionFirstRows() const {
+  return this->partition_first_rows;
+}
+
+MergedTable::Column::Column(std::string name) : name(std::move(name)) {
+  // do nothing here
+}
+
+PartitionedQuery::PartitionedQuery(connection_pool::ConnectionPool* pool,
+                                   std::string query, FanOutOptions options)
+    : pool(pool), query(std::move(query)), options(options) {
+  // do nothing here
+}
+
+std::string PartitionedQuery::GetPartitionQuery(int date) const {
+  return this->query + "[" + FormatDate(date) + "]";
+}
+
+FanOutResult PartitionedQuery::Run(int first_date, int last_date,
+                                   DeliveryOrder order,
+                                   const PartitionCallback& callback) {
+  return this->FanOut(first_date, last_date, order,
+                      [&callback](const Partition& partition) {
+                        return callback(partition) ? FanOutResult::Ok
+                                                   : FanOutResult::Stopped;
+                      });
+}
+
+FanOutResult PartitionedQuery::RunMerged(int first_date, int last_date,
+                                         MergedTable* output) {
+  output->partition_first_rows.clear();
+  // Hold every partition, since the total number of rows is only known when
+  // all of them arrive.
+  std::vector<Partition> partitions;
+  FanOutResult result = this->FanOut(
+      first_date, last_date, DeliveryOrder::Ordered,
+      [&partitions](const Partition& partition) {
+        partitions.push_back(partition);
+        kdb_wrapper::IncreaseReferenceCount(partition.table);
+        return FanOutResult::Ok;
+      });
+
+  if (result == FanOutResult::Ok) {
+    std::size_t number_of_rows = 0;
+    for (const Partition& partition : partitions) {
+      output->partition_first_rows.push_back(number_of_rows);
+      number_of_rows += partition.number_of_rows;
+    }
+    output->partition_first_rows.push_back(number_of_rows);
+
+    for (auto& column : output->columns) {
+      column->Resize(number_of_rows);
+      for (std::size_t i = 0;
+           i < partitions.size() && result == FanOutResult::Ok; i++) {
+        const Partition& partition = partitions[i];
+        if (partition.number_of_columns == 0) {
+          continue;
+        }
+        std::size_t column_index =
+            FindColumn(partition.column_heading, partition.number_of_columns,
+                       column->name);
+        if (column_index == partition.number_of_columns) {
+          this->error_message =
+              FormatDate(partition.date) + ": no column " + column->name;
+          result = FanOutResult::ColumnNotFound;
+          break;
+        }
+        accessors::DataRetrievalResult retrieval_result =
+            column->Retrieve(partition.columns[column_index],
+                             output->partition_first_rows[i]);
+        if (retrieval_result != accessors::DataRetrievalResult::Ok) {
+          this->error_message = FormatDate(partition.date) + ": column " +
+                                column->name + " " +
+                                accessors::GetDataRetrievalResultName(
+                                    retrieval_result);
+          result = FanOutResult::ColumnRetrievalFailed;
+        }
+      }
+      if (result != FanOutResult::Ok) {
+        break;
+      }
+    }
+  }
+
+  for (const Partition& partition : partitions) {
+    kdb_wrapper::DecreaseReferenceCount(partition.table);
+  }
+  return result;
+}
+
+const std::string& PartitionedQuery::GetErrorMessage() const {
+  return this->error_message;
+}
+
+FanOutResult PartitionedQuery::FanOut(
+    int first_date, int last_date, DeliveryOrder order,
+    const std::function<FanOutResult(const Partition&)>& consume) {
+  if (last_date < first_date) {
+    return FanOutResult::Ok;
+  }
+  std::size_t number_of_partitions =
+      static_cast<std::size_t>(last_date - first_date) + 1;
+  std::size_t number_of_workers = this->options.max_concurrency == 0
+                                      ? this->pool->GetPoolSize()
+                                      : this->options.max_concurrency;
+  number_of_workers = std::max<std::size_t>(
+      1, std::min(number_of_workers, number_of_partitions));
+
+  // Results are created on the worker threads.
+  kdb_wrapper::SetSymbolInterningMutex(1);
+
+  std::atomic<std::size_t> next_partition_index{0};
+  std::atomic<bool> is_stopped{false};
+  CompletionQueue queue;
+  std::vector<std::thread> workers;
+  for (std::size_t i = 0; i < number_of_workers; i++) {
+    workers.emplace_back([&, first_date] {
+      while (!is_stopped.load(std::memory_order_relaxed)) {
+        std::size_t partition_index = next_partition_index.fetch_add(1);
+        if (partition_index >= number_of_partitions) {
+          return;
+        }
+        Completion completion;
+        completion.partition_index = partition_index;
+        connection_pool::ConnectionLease lease =
+            this->pool->Checkout(this->options.checkout_time_out);
+        if (!lease.IsValid()) {
+          completion.result = FanOutResult::NoConnection;
+        } else {
+          std::string partition_query = this->GetPartitionQuery(
+              first_date + static_cast<int>(partition_index));
+          completion.result = ConvertDeadlineResult(
+              lease.RunQuery(partition_query.c_str(),
+                             this->options.query_time_out, &completion.table));
+        }
+        queue.Push(completion);
+      }
+    });
+  }
+
+  // Partitions arrived but not delivered yet, only used when ordered.
+  std::vector<void*> pending(number_of_partitions, nullptr);
+  std::size_t next_to_deliver = 0;
+  FanOutResult result = FanOutResult::Ok;
+  for (std::size_t number_of_received = 0;
+       number_of_received < number_of_partitions && result == FanOutResult::Ok;
+       number_of_received++) {
+    Completion completion = queue.Pop();
+    int date = first_date + static_cast<int>(completion.partition_index);
+    if (completion.result != FanOutResult::Ok) {
+      this->error_message =
+          FormatDate(date) + ": " + GetFanOutResultName(completion.result);
+      result = completion.result;
+      break;
+    }
+    if (accessors::IsError(completion.table)) {
+      this->error_message =
+          FormatDate(date) + ": " +
+          *static_cast<char**>(kdb_wrapper::GetValue(completion.table));
+      kdb_wrapper::DecreaseReferenceCount(completion.table);
+      result = FanOutResult::QueryFailed;
+      break;
+    }
+    if (!accessors::IsTable(completion.table)) {
+      this->error_message = FormatDate(date) + ": not a table";
+      kdb_wrapper::DecreaseReferenceCount(completion.table);
+      result = FanOutResult::NotTable;
+      break;
+    }
+    pending[completion.partition_index] = completion.table;
+
+    // Deliver this partition, or every partition ready in date order.
+    std::size_t first = completion.partition_index;
+    std::size_t last = first + 1;
+    if (order == DeliveryOrder::Ordered) {
+      first = next_to_deliver;
+      last = first;
+      while (last < number_of_partitions && pending[last] != nullptr) {
+        last++;
+      }
+      next_to_deliver = last;
+    }
+    for (std::size_t j = first; j < last; j++) {
+      Partition partition;
+      partition.date = first_date + static_cast<int>(j);
+      partition.partition_index = j;
+      partition.table = pending[j];
+      accessors::GetSimpleTable(partition.table, &partition.column_heading,
+                                &partition.columns,
+                                &partition.number_of_columns,
+                                &partition.number_of_rows);
+      if (result == FanOutResult::Ok) {
+        result = consume(partition);
+      }
+      kdb_wrapper::DecreaseReferenceCount(pending[j]);
+      pending[j] = nullptr;
+    }
+  }
+
+  // Stop starting new partitions, and release whatever is still coming.
+  is_stopped.store(true, std::memory_order_relaxed);
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  queue.ReleaseAll();
+  for (void* table : pending) {
+    if (table != nullptr) {
+      kdb_wrapper::DecreaseReferenceCount(table);
+    }
+  }
+  return result;
+}
+}  // namespace cpp2kdb::partitioned_query
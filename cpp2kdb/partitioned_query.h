@@ -0,0 +1,300 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_PARTITIONED_QUERY_H__
+#define CPP2KDB_PARTITIONED_QUERY_H__
+/// \file cpp2kdb/partitioned_query.h
+/// Run a query on a range of date partitions in parallel.
+///
+/// The date range is split into one query per date, and the queries are run
+/// concurrently on connections checked out from a connection_pool. The tables
+/// returned are either handed to a callback as they arrive, or concatenated
+/// column by column into columns allocated once for the whole range.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/connection_pool.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+/// Query date partitioned databases with connections from a
+/// connection_pool::ConnectionPool.
+namespace cpp2kdb::partitioned_query {
+/// Fan Out Result
+enum class FanOutResult {
+  /// Ok.
+  Ok = 0,
+  /// No connection could be checked out from the pool.
+  NoConnection,
+  /// Connection is lost.
+  ConnectionLost,
+  /// No reply before the time out.
+  TimedOut,
+  /// Query failed on the server. The error message is available from
+  /// PartitionedQuery::GetErrorMessage.
+  QueryFailed,
+  /// Result of a partition is not a simple table.
+  NotTable,
+  /// A column of the merged table is not in the result of a partition.
+  ColumnNotFound,
+  /// A column cannot be retrieved into the type of the merged column.
+  ColumnRetrievalFailed,
+  /// Stopped by the callback.
+  Stopped
+};
+
+/// Names for the enums.
+constexpr const char* FanOutResultNames[] = {"Ok",
+                                             "NoConnection",
+                                             "ConnectionLost",
+                                             "TimedOut",
+                                             "QueryFailed",
+                                             "NotTable",
+                                             "ColumnNotFound",
+                                             "ColumnRetrievalFailed",
+                                             "Stopped"};
+
+/// Number of fan out result names
+constexpr const int number_of_fan_out_result_names =
+    sizeof(FanOutResultNames) / sizeof(FanOutResultNames[0]);
+
+/// Get the name from a result
+const char* GetFanOutResultName(FanOutResult result);
+
+/// Overload << for result type `FanOutResult`.
+std::ostream& operator<<(std::ostream& output_stream, FanOutResult result);
+
+/// Create a q date, which is the number of days since 2000.01.01.
+int MakeDate(int year, int month, int day);
+
+/// Format a q date as yyyy.mm.dd, which is how a date is written in a query.
+std::string FormatDate(int date);
+
+/// Order the partitions are delivered in.
+enum class DeliveryOrder {
+  /// By date, so a partition waits for the partitions before it.
+  Ordered = 0,
+  /// As soon as the result arrives.
+  Unordered
+};
+
+/// Result of one partition.
+///
+/// The table is owned by PartitionedQuery and is released when the callback
+/// returns. Call kdb_wrapper::IncreaseReferenceCount on table to keep it
+/// longer.
+struct Partition {
+  /// Date of the partition.
+  int date = 0;
+  /// Index of the partition in the date range.
+  std::size_t partition_index = 0;
+  /// The result, a simple table.
+  void* table = nullptr;
+  /// Column heading, a symbol vector.
+  void* column_heading = nullptr;
+  /// Columns, each one can be retrieved with accessors::RetrieveVectorData.
+  void** columns = nullptr;
+  /// Number of columns.
+  std::size_t number_of_columns = 0;
+  /// Number of rows.
+  std::size_t number_of_rows = 0;
+};
+
+/// Function called with each partition. Return false to stop.
+using PartitionCallback = std::function<bool(const Partition& partition)>;
+
+/// Columns of the partitions concatenated in date order.
+///
+/// Add the columns wanted with AddColumn before PartitionedQuery::RunMerged.
+/// The columns are found by name in every partition, and are resized once to
+/// the total number of rows before any data is copied.
+class MergedTable {
+ public:
+  /// Create a table without columns.
+  MergedTable() = default;
+  /// Copy constructor is deleted.
+  MergedTable(const MergedTable&) = delete;
+  /// assignment operator is deleted.
+  MergedTable& operator=(const MergedTable&) = delete;
+
+  /// Add a column to be retrieved as type T.
+  ///
+  /// T is any type supported by accessors::RetrieveVectorData except void*.
+  /// std::vector<bool> has no data() to retrieve into, so bool columns are
+  /// retrieved through a buffer for each partition.
+  /// \returns the column, which is owned by the table and stays valid until
+  /// the table is destructed.
+  template <typename T>
+  std::vector<T>* AddColumn(
+      /// Name of the column.
+      std::string name) {
+    auto column = std::make_unique<TypedColumn<T>>(std::move(name));
+    std::vector<T>* data = &column->data;
+    this->columns.push_back(std::move(column));
+    return data;
+  }
+
+  /// Get the number of rows, which is set by PartitionedQuery::RunMerged.
+  std::size_t GetNumberOfRows() const;
+
+  /// Get the first row of every partition in date order, followed by the
+  /// number of rows, which is set by PartitionedQuery::RunMerged.
+  const std::vector<std::size_t>& GetPartitionFirstRows() const;
+
+ private:
+  friend class PartitionedQuery;
+
+  /// A column of any type.
+  class Column {
+   public:
+    /// Create a column with a name.
+    explicit Column(std::string name);
+    /// Destructor.
+    virtual ~Column() = default;
+    /// Resize the column to number_of_rows.
+    virtual void Resize(std::size_t number_of_rows) = 0;
+    /// Retrieve a column of a partition into the rows starting at first_row.
+    virtual accessors::DataRetrievalResult Retrieve(
+        void* partition_column, std::size_t first_row) = 0;
+    /// Name of the column.
+    std::string name;
+  };
+
+  /// A column of T.
+  template <typename T>
+  class TypedColumn : public Column {
+   public:
+    /// Create a column with a name.
+    explicit TypedColumn(std::string name) : Column(std::move(name)) {}
+    void Resize(std::size_t number_of_rows) override {
+      this->data.resize(number_of_rows);
+    }
+    accessors::DataRetrievalResult Retrieve(void* partition_column,
+                                            std::size_t first_row) override {
+      if constexpr (std::is_same_v<T, bool>) {
+        accessors::DataRetrievalResult result =
+            accessors::CheckVectorForVectorDataRetrieval(partition_column);
+        if (result != accessors::DataRetrievalResult::Ok) {
+          return result;
+        }
+        std::size_t number_of_rows =
+            kdb_wrapper::GetNumberOfVectorElements(partition_column);
+        std::unique_ptr<bool[]> buffer(new bool[number_of_rows]);
+        result = accessors::RetrieveVectorData(partition_column, buffer.get());
+        if (result == accessors::DataRetrievalResult::Ok) {
+          std::copy(buffer.get(), buffer.get() + number_of_rows,
+                    this->data.begin() + first_row);
+        }
+        return result;
+      } else {
+        return accessors::RetrieveVectorData(partition_column,
+                                             this->data.data() + first_row);
+      }
+    }
+    /// Data of the column.
+    std::vector<T> data;
+  };
+
+  std::vector<std::unique_ptr<Column>> columns;
+  std::vector<std::size_t> partition_first_rows;
+};
+
+/// Options of PartitionedQuery.
+struct FanOutOptions {
+  /// Maximum number of partitions queried at the same time. 0 uses as many as
+  /// there are connections in the pool.
+  std::size_t max_concurrency = 0;
+  /// Time to wait for a connection to be checked out.
+  std::chrono::milliseconds checkout_time_out{1000};
+  /// Time to wait for the result of each partition.
+  std::chrono::milliseconds query_time_out{60000};
+};
+
+/// Run a query on every date of a range, in parallel.
+///
+/// The query is a unary q function, such as
+/// "{select from trade where date=x, sym=`AAPL}", and is applied to each date
+/// of the range in a separate query, so every partition is read by its own
+/// connection. Partitions with no data are expected to return an empty table
+/// with the same columns.
+///
+/// Worker threads only run the queries. The callbacks and the merge are run
+/// on the calling thread, so they don't need to be thread safe. Symbol
+/// interning is protected by mutex (kdb_wrapper::SetSymbolInterningMutex),
+/// since results are created on the worker threads.
+class PartitionedQuery {
+ public:
+  /// Create on a pool, which must outlive the PartitionedQuery.
+  PartitionedQuery(
+      /// Pool to check out connections from.
+      connection_pool::ConnectionPool* pool,
+      /// Unary q function applied to each date.
+      std::string query,
+      /// Options.
+      FanOutOptions options = FanOutOptions());
+  /// Default constructor is deleted.
+  PartitionedQuery() = delete;
+  /// Copy constructor is deleted.
+  PartitionedQuery(const PartitionedQuery&) = delete;
+  /// assignment operator is deleted.
+  PartitionedQuery& operator=(const PartitionedQuery&) = delete;
+
+  /// Get the query sent for one date, which is the function applied to the
+  /// date.
+  std::string GetPartitionQuery(int date) const;
+
+  /// Run the query on every date from first_date to last_date, both included,
+  /// and call callback with each partition.
+  ///
+  /// When a partition fails, no more partitions are started, the partitions
+  /// in flight are released, and the error is returned.
+  FanOutResult Run(
+      /// First date.
+      int first_date,
+      /// Last date.
+      int last_date,
+      /// Order of delivery.
+      DeliveryOrder order,
+      /// Function called with each partition on the calling thread.
+      const PartitionCallback& callback);
+
+  /// Run the query on every date from first_date to last_date, both included,
+  /// and concatenate the columns of all the partitions in date order.
+  ///
+  /// The results are held until all partitions arrive, then the columns of
+  /// output are resized to the total number of rows and filled.
+  FanOutResult RunMerged(
+      /// First date.
+      int first_date,
+      /// Last date.
+      int last_date,
+      /// [in, out] Columns to fill.
+      MergedTable* output);
+
+  /// Get the error message of the last run failed.
+  const std::string& GetErrorMessage() const;
+
+ private:
+  /// Run the queries, and call consume with each partition in order on the
+  /// calling thread. The result is released when consume returns.
+  FanOutResult FanOut(
+      int first_date, int last_date, DeliveryOrder order,
+      const std::function<FanOutResult(const Partition&)>& consume);
+
+  connection_pool::ConnectionPool* pool;
+  std::string query;
+  FanOutOptions options;
+  std::string error_message;
+};
+}  // namespace cpp2kdb::partitioned_query
+#endif  // CPP2KDB_PARTITIONED_QUERY_H__
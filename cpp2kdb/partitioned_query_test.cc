@@ -0,0 +1,156 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/partitioned_query.h"
+
+#include <cstdint>
+#include <iostream>
+#include <set>
+#include <vector>
+
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace {
+// fan_out_test returns 1000 rows for every date, with column a counting the
+// days since 2000.01.01, and column c telling if the count is odd.
+constexpr const char* create_function_query =
+    "fan_out_test:{([] date:1000#x; a:1000#`long$x; b:1000?1.; "
+    "c:1000#1=(`long$x) mod 2)}";
+
+void TestDates() {
+  int date = cpp2kdb::partitioned_query::MakeDate(2021, 1, 4);
+  std::cout << "2021.01.04 is " << date << " days since 2000.01.01, formatted "
+            << cpp2kdb::partitioned_query::FormatDate(date) << std::endl;
+  std::cout << "2000.02.29 formatted: "
+            << cpp2kdb::partitioned_query::FormatDate(
+                   cpp2kdb::partitioned_query::MakeDate(2000, 2, 29))
+            << std::endl;
+}
+
+void TestMerged(cpp2kdb::connection_pool::ConnectionPool* pool) {
+  cpp2kdb::partitioned_query::PartitionedQuery query(pool, "fan_out_test");
+  int first_date = cpp2kdb::partitioned_query::MakeDate(2021, 1, 1);
+  int last_date = cpp2kdb::partitioned_query::MakeDate(2021, 3, 31);
+
+  cpp2kdb::partitioned_query::MergedTable table;
+  std::vector<std::int64_t>* a = table.AddColumn<std::int64_t>("a");
+  std::vector<double>* b = table.AddColumn<double>("b");
+  std::vector<bool>* c = table.AddColumn<bool>("c");
+  std::cout << "RunMerged: " << query.RunMerged(first_date, last_date, &table)
+            << ", number of rows is " << table.GetNumberOfRows() << std::endl;
+
+  bool is_ordered = a->size() == table.GetNumberOfRows() &&
+                    b->size() == table.GetNumberOfRows() &&
+                    c->size() == table.GetNumberOfRows();
+  for (std::size_t i = 0; is_ordered && i < a->size(); i++) {
+    is_ordered = (*a)[i] == first_date + static_cast<std::int64_t>(i / 1000);
+  }
+  std::cout << "Column a is in date order? " << (is_ordered ? "Yes" : "No")
+            << std::endl;
+  bool is_odd_day = c->size() == a->size();
+  for (std::size_t i = 0; is_odd_day && i < c->size(); i++) {
+    is_odd_day = (*c)[i] == ((*a)[i] % 2 == 1);
+  }
+  std::cout << "Boolean column c matches a? " << (is_odd_day ? "Yes" : "No")
+            << std::endl;
+
+  cpp2kdb::partitioned_query::MergedTable wrong_table;
+  wrong_table.AddColumn<double>("no_such_column");
+  std::cout << "RunMerged with a column not existing: "
+            << query.RunMerged(first_date, last_date, &wrong_table) << ", "
+            << query.GetErrorMessage() << std::endl;
+}
+
+void TestStreaming(cpp2kdb::connection_pool::ConnectionPool* pool) {
+  cpp2kdb::partitioned_query::PartitionedQuery query(pool, "fan_out_test");
+  int first_date = cpp2kdb::partitioned_query::MakeDate(2021, 1, 1);
+  int last_date = cpp2kdb::partitioned_query::MakeDate(2021, 1, 31);
+
+  std::set<int> dates;
+  std::size_t number_of_rows = 0;
+  cpp2kdb::partitioned_query::FanOutResult result =
+      query.Run(first_date, last_date,
+                cpp2kdb::partitioned_query::DeliveryOrder::Unordered,
+                [&](const cpp2kdb::partitioned_query::Partition& partition) {
+                  dates.insert(partition.date);
+                  number_of_rows += partition.number_of_rows;
+                  return true;
+                });
+  std::cout << "Run unordered: " << result << ", " << dates.size()
+            << " partitions and " << number_of_rows << " rows" << std::endl;
+
+  std::vector<int> ordered_dates;
+  query.Run(first_date, last_date,
+            cpp2kdb::partitioned_query::DeliveryOrder::Ordered,
+            [&](const cpp2kdb::partitioned_query::Partition& partition) {
+              ordered_dates.push_back(partition.date);
+              return true;
+            });
+  bool is_ordered = ordered_dates.size() == dates.size();
+  for (std::size_t i = 0; is_ordered && i < ordered_dates.size(); i++) {
+    is_ordered = ordered_dates[i] == first_date + static_cast<int>(i);
+  }
+  std::cout << "Partitions delivered in date order? "
+            << (is_ordered ? "Yes" : "No") << std::endl;
+
+  std::size_t number_of_partitions = 0;
+  std::cout << "Run stopped by callback: "
+            << query.Run(first_date, last_date,
+                         cpp2kdb::partitioned_query::DeliveryOrder::Ordered,
+                         [&](const cpp2kdb::partitioned_query::Partition&) {
+                           return ++number_of_partitions < 3;
+                         })
+            << " after " << number_of_partitions << " partitions"
+            << std::endl;
+}
+
+void TestError(cpp2kdb::connection_pool::ConnectionPool* pool) {
+  cpp2kdb::partitioned_query::PartitionedQuery query(
+      pool, "{$[x=2021.01.15; 'bad_partition; fan_out_test x]}");
+  std::cout << "Run with a failed partition: "
+            << query.Run(cpp2kdb::partitioned_query::MakeDate(2021, 1, 1),
+                         cpp2kdb::partitioned_query::MakeDate(2021, 1, 31),
+                         cpp2kdb::partitioned_query::DeliveryOrder::Unordered,
+                         [](const cpp2kdb::partitioned_query::Partition&) {
+                           return true;
+                         })
+            << ", " << query.GetErrorMessage() << std::endl;
+  std::cout << "Healthy connections after the failure: " << pool->CheckHealth()
+            << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  cpp2kdb::connection_pool::ConnectionOptions options;
+  options.host = "127.0.0.1";
+  options.port = 5000;
+  cpp2kdb::connection_pool::ConnectionPool pool(options, 4);
+
+  std::size_t number_of_opened = pool.Open();
+  if (number_of_opened != pool.GetPoolSize()) {
+    std::cerr << "Only opened " << number_of_opened << " connections"
+              << std::endl;
+    return 1;
+  }
+  {
+    cpp2kdb::connection_pool::ConnectionLease lease = pool.TryCheckout();
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard create_guard(
+        cpp2kdb::kdb_wrapper::RunQueryOnConnection(lease.GetConnection(),
+                                                   create_function_query));
+  }
+
+  TestDates();
+  std::cout << "----------------------" << std::endl;
+  TestMerged(&pool);
+  std::cout << "----------------------" << std::endl;
+  TestStreaming(&pool);
+  std::cout << "----------------------" << std::endl;
+  TestError(&pool);
+
+  cpp2kdb::connection_pool::ConnectionLease lease = pool.TryCheckout();
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard delete_guard(
+      cpp2kdb::kdb_wrapper::RunQueryOnConnection(
+          lease.GetConnection(), "delete fan_out_test from `."));
+  return 0;
+}
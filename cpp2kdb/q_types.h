@@ -478,6 +478,59 @@ constexpr bool IsQTypeIdMixedVector(int input_q_type_id) {
   return input_q_type_id == q_mixed_type_id;
 }
 
+/// Get the size in bytes of one element of q type id.
+///
+/// This works both for atomic types and vector types. Symbol is the size of
+/// char*, since that is how a symbol is stored in K. 0 is returned for types
+/// without fixed size elements, such as mixed list, table or dict.
+constexpr std::size_t GetElementSizeOfQTypeId(
+    /// Input Q Type Id
+    int input_q_type_id) {
+  // If the input is negative, make it positive.
+  int positive_q_type_id =
+      input_q_type_id > 0 ? input_q_type_id : -input_q_type_id;
+  switch (positive_q_type_id) {
+    case q_boolean_type_id:
+      return sizeof(CTypeForQTypeId<q_boolean_type_id>);
+    case q_byte_type_id:
+      return sizeof(CTypeForQTypeId<q_byte_type_id>);
+    case q_short_type_id:
+      return sizeof(CTypeForQTypeId<q_short_type_id>);
+    case q_int_type_id:
+      return sizeof(CTypeForQTypeId<q_int_type_id>);
+    case q_long_type_id:
+      return sizeof(CTypeForQTypeId<q_long_type_id>);
+    case q_real_type_id:
+      return sizeof(CTypeForQTypeId<q_real_type_id>);
+    case q_float_type_id:
+      return sizeof(CTypeForQTypeId<q_float_type_id>);
+    case q_char_type_id:
+      return sizeof(CTypeForQTypeId<q_char_type_id>);
+    case q_timestamp_type_id:
+      return sizeof(CTypeForQTypeId<q_timestamp_type_id>);
+    case q_month_type_id:
+      return sizeof(CTypeForQTypeId<q_month_type_id>);
+    case q_date_type_id:
+      return sizeof(CTypeForQTypeId<q_date_type_id>);
+    case q_datetime_type_id:
+      return sizeof(CTypeForQTypeId<q_datetime_type_id>);
+    case q_timespan_type_id:
+      return sizeof(CTypeForQTypeId<q_timespan_type_id>);
+    case q_minute_type_id:
+      return sizeof(CTypeForQTypeId<q_minute_type_id>);
+    case q_second_type_id:
+      return sizeof(CTypeForQTypeId<q_second_type_id>);
+    case q_time_type_id:
+      return sizeof(CTypeForQTypeId<q_time_type_id>);
+    case q_guid_type_id:
+      return sizeof(QGuid);
+    case q_symbol_type_id:
+      return sizeof(char*);
+    default:
+      return 0;
+  }
+}
+
 /// Get Atomic Value indicated by q_type_id into a T*
 ///
 /// \tparam T Desired type for output.
@@ -0,0 +1,143 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/query_cache.h"
+
+#include <iterator>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace cpp2kdb::query_cache {
+QueryCache::QueryCache(std::size_t byte_budget,
+                       std::chrono::milliseconds time_to_live)
+    : byte_budget(byte_budget), time_to_live(time_to_live), number_of_bytes(0) {
+  // do nothing here
+}
+
+QueryCache::~QueryCache() { this->Clear(); }
+
+void* QueryCache::RunQuery(int connection, const char* query) {
+  std::string key = MakeKey(query, nullptr);
+  void* result = this->Get(key);
+  if (result != nullptr) {
+    return result;
+  }
+  return this->PutIfNotError(
+      key, kdb_wrapper::RunQueryOnConnection(connection, query));
+}
+
+void* QueryCache::RunQuery(int connection, const char* query, void* arg) {
+  std::string key = MakeKey(query, arg);
+  if (key.empty()) {
+    // Cannot tell the arguments apart, don't cache.
+    return kdb_wrapper::RunQueryOnConnection(connection, query, arg);
+  }
+  void* result = this->Get(key);
+  if (result != nullptr) {
+    kdb_wrapper::DecreaseReferenceCount(arg);
+    return result;
+  }
+  return this->PutIfNotError(
+      key, kdb_wrapper::RunQueryOnConnection(connection, query, arg));
+}
+
+void* QueryCache::Get(const std::string& key) {
+  auto index_iterator = this->index.find(key);
+  if (index_iterator == this->index.end()) {
+    this->statistics.number_of_misses++;
+    return nullptr;
+  }
+  std::list<Entry>::iterator iterator = index_iterator->second;
+  if (std::chrono::steady_clock::now() >= iterator->expiry_time) {
+    this->Erase(iterator);
+    this->statistics.number_of_expirations++;
+    this->statistics.number_of_misses++;
+    return nullptr;
+  }
+  // Move to the front, the most recently used.
+  this->entries.splice(this->entries.begin(), this->entries, iterator);
+  this->statistics.number_of_hits++;
+  return kdb_wrapper::IncreaseReferenceCount(iterator->result);
+}
+
+bool QueryCache::Put(const std::string& key, void* result) {
+  if (result == nullptr) {
+    return false;
+  }
+  auto index_iterator = this->index.find(key);
+  if (index_iterator != this->index.end()) {
+    this->Erase(index_iterator->second);
+  }
+  std::size_t size = accessors::EstimateObjectSize(result);
+  if (size > this->byte_budget) {
+    return false;
+  }
+  // Evict the least recently used until the result fits.
+  while (this->number_of_bytes + size > this->byte_budget) {
+    this->Erase(std::prev(this->entries.end()));
+    this->statistics.number_of_evictions++;
+  }
+  this->entries.push_front(
+      Entry{key, kdb_wrapper::IncreaseReferenceCount(result), size,
+            std::chrono::steady_clock::now() + this->time_to_live});
+  this->index[key] = this->entries.begin();
+  this->number_of_bytes += size;
+  return true;
+}
+
+void QueryCache::Clear() {
+  for (Entry& entry : this->entries) {
+    kdb_wrapper::DecreaseReferenceCount(entry.result);
+  }
+  this->entries.clear();
+  this->index.clear();
+  this->number_of_bytes = 0;
+}
+
+std::string QueryCache::MakeKey(const char* query, void* arg) {
+  std::string key(query);
+  if (arg == nullptr) {
+    return key;
+  }
+  void* bytes = kdb_wrapper::Serialize(2, arg);
+  if (bytes == nullptr) {
+    return std::string();
+  }
+  kdb_wrapper::DecreaseReferenceCountGuard guard(bytes);
+  if (accessors::IsError(bytes)) {
+    return std::string();
+  }
+  // The query never contains \0, so the argument cannot be mistaken for a
+  // part of the query.
+  key.push_back('\0');
+  key.append(accessors::GetVector<char>(bytes),
+             kdb_wrapper::GetNumberOfVectorElements(bytes));
+  return key;
+}
+
+std::size_t QueryCache::GetNumberOfEntries() const {
+  return this->entries.size();
+}
+
+std::size_t QueryCache::GetNumberOfBytes() const {
+  return this->number_of_bytes;
+}
+
+CacheStatistics QueryCache::GetStatistics() const { return this->statistics; }
+
+void* QueryCache::PutIfNotError(const std::string& key, void* result) {
+  if (result != nullptr && !accessors::IsError(result)) {
+    this->Put(key, result);
+  }
+  return result;
+}
+
+void QueryCache::Erase(std::list<Entry>::iterator iterator) {
+  kdb_wrapper::DecreaseReferenceCount(iterator->result);
+  this->number_of_bytes -= iterator->size;
+  this->index.erase(iterator->key);
+  this->entries.erase(iterator);
+}
+}  // namespace cpp2kdb::query_cache
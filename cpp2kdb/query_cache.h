@@ -0,0 +1,153 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_QUERY_CACHE_H__
+#define CPP2KDB_QUERY_CACHE_H__
+/// \file cpp2kdb/query_cache.h
+/// Cache of query results, shared by reference counting.
+///
+/// The cache keeps one reference to each result, and hands out a new reference
+/// with kdb_wrapper::IncreaseReferenceCount on every hit, so the same result is
+/// never deserialized twice. Entries expire after a time to live, and the
+/// least recently used entries are evicted when the estimated size of the
+/// results goes over the budget.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+/// Cache of results of queries run by kdb_wrapper::RunQueryOnConnection.
+namespace cpp2kdb::query_cache {
+/// Counters of the cache.
+struct CacheStatistics {
+  /// Number of lookups finding a live entry.
+  std::uint64_t number_of_hits = 0;
+  /// Number of lookups finding no entry or an expired one.
+  std::uint64_t number_of_misses = 0;
+  /// Number of entries evicted to stay within the budget.
+  std::uint64_t number_of_evictions = 0;
+  /// Number of entries dropped since their time to live has passed.
+  std::uint64_t number_of_expirations = 0;
+};
+
+/// Cache of query results with time to live and a memory budget.
+///
+/// The key is the query text followed by the arguments serialized with
+/// kdb_wrapper::Serialize, so the same function called with different
+/// arguments is cached separately. Errors and nullptr are never cached.
+///
+/// Results returned are owned by the caller like the result of
+/// kdb_wrapper::RunQueryOnConnection, but are shared with the cache and the
+/// other callers, so they must not be modified.
+///
+/// QueryCache is not thread safe. Reference counts of K objects are not
+/// atomic, so a result must not be released on another thread either.
+class QueryCache {
+ public:
+  /// Create an empty cache.
+  QueryCache(
+      /// Budget of the estimated size of the results cached, in bytes. See
+      /// accessors::EstimateObjectSize.
+      std::size_t byte_budget,
+      /// Time an entry stays in the cache after being added.
+      std::chrono::milliseconds time_to_live);
+  /// Default constructor is deleted.
+  QueryCache() = delete;
+  /// Copy constructor is deleted.
+  QueryCache(const QueryCache&) = delete;
+  /// assignment operator is deleted.
+  QueryCache& operator=(const QueryCache&) = delete;
+
+  /// Destructor, releasing the references held by the cache.
+  ~QueryCache();
+
+  /// Get the result of a query from the cache, or run it on the connection
+  /// and add the result to the cache.
+  /// \returns result owned by the caller, nullptr on network error.
+  void* RunQuery(
+      /// Handle
+      int connection,
+      /// Query
+      const char* query);
+
+  /// Get the result of a query with an argument from the cache, or run it on
+  /// the connection and add the result to the cache.
+  ///
+  /// Like kdb_wrapper::RunQueryOnConnection, the reference to arg is taken
+  /// over, also on a hit.
+  /// \returns result owned by the caller, nullptr on network error.
+  void* RunQuery(
+      /// Handle
+      int connection,
+      /// Query
+      const char* query,
+      /// Argument
+      void* arg);
+
+  /// Get a new reference to the result cached under key.
+  /// \returns nullptr if there is no live entry for key.
+  void* Get(const std::string& key);
+
+  /// Add a result to the cache, replacing the entry of the same key.
+  ///
+  /// The cache takes a new reference, so the caller still owns result. A
+  /// result larger than the whole budget is not cached.
+  /// \returns false if result is not cached.
+  bool Put(
+      /// Key, see MakeKey.
+      const std::string& key,
+      /// Result of the query.
+      void* result);
+
+  /// Drop all the entries.
+  void Clear();
+
+  /// Make the key of a query and its argument.
+  /// \returns empty string if arg cannot be serialized.
+  static std::string MakeKey(
+      /// Query
+      const char* query,
+      /// Argument, nullptr if the query has none. Not released.
+      void* arg);
+
+  /// Get the number of entries in the cache, including the expired ones not
+  /// dropped yet.
+  std::size_t GetNumberOfEntries() const;
+
+  /// Get the estimated size of the results in the cache, in bytes.
+  std::size_t GetNumberOfBytes() const;
+
+  /// Get the counters.
+  CacheStatistics GetStatistics() const;
+
+ private:
+  /// One cached result.
+  struct Entry {
+    std::string key;
+    /// Reference held by the cache.
+    void* result;
+    /// Estimated size of result.
+    std::size_t size;
+    std::chrono::steady_clock::time_point expiry_time;
+  };
+
+  /// Cache the result of a query run on a miss, unless it is an error.
+  /// \returns result.
+  void* PutIfNotError(const std::string& key, void* result);
+  /// Remove an entry and release its result.
+  void Erase(std::list<Entry>::iterator iterator);
+
+  std::size_t byte_budget;
+  std::chrono::milliseconds time_to_live;
+  /// Most recently used first.
+  std::list<Entry> entries;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index;
+  std::size_t number_of_bytes;
+  CacheStatistics statistics;
+};
+}  // namespace cpp2kdb::query_cache
+#endif  // CPP2KDB_QUERY_CACHE_H__
@@ -0,0 +1,123 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/query_cache.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace {
+void PrintStatistics(const cpp2kdb::query_cache::QueryCache& cache) {
+  cpp2kdb::query_cache::CacheStatistics statistics = cache.GetStatistics();
+  std::cout << "Hits: " << statistics.number_of_hits
+            << " misses: " << statistics.number_of_misses
+            << " evictions: " << statistics.number_of_evictions
+            << " expirations: " << statistics.number_of_expirations
+            << " entries: " << cache.GetNumberOfEntries()
+            << " bytes: " << cache.GetNumberOfBytes() << std::endl;
+}
+
+void TestHit(int connection) {
+  cpp2kdb::query_cache::QueryCache cache(1 << 20, std::chrono::minutes(1));
+  // .test.counter goes up every time the query runs on the server.
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(
+      cpp2kdb::kdb_wrapper::RunQueryOnConnection(connection,
+                                                 ".test.counter:0"));
+  const char* query = ".test.counter+:1; til 100";
+  for (int i = 0; i < 5; i++) {
+    void* result = cache.RunQuery(connection, query);
+    if (result == nullptr) {
+      std::cout << "Result is nullptr" << std::endl;
+      return;
+    }
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard result_guard(result);
+    std::cout << "Number of elements: "
+              << cpp2kdb::kdb_wrapper::GetNumberOfVectorElements(result)
+              << std::endl;
+  }
+  void* counter =
+      cpp2kdb::kdb_wrapper::RunQueryOnConnection(connection, ".test.counter");
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard counter_guard(counter);
+  std::cout << "Query ran on the server "
+            << cpp2kdb::accessors::GetValue<std::int64_t>(counter)
+            << " time(s)" << std::endl;
+  PrintStatistics(cache);
+}
+
+void TestArguments(int connection) {
+  cpp2kdb::query_cache::QueryCache cache(1 << 20, std::chrono::minutes(1));
+  std::int64_t arguments[] = {3, 5, 3};
+  for (std::int64_t argument : arguments) {
+    void* result = cache.RunQuery(connection, "{til x}",
+                                  cpp2kdb::kdb_wrapper::CreateLong(argument));
+    if (result == nullptr) {
+      std::cout << "Result is nullptr" << std::endl;
+      return;
+    }
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(result);
+    std::cout << "til " << argument << " has "
+              << cpp2kdb::kdb_wrapper::GetNumberOfVectorElements(result)
+              << " elements" << std::endl;
+  }
+  PrintStatistics(cache);
+}
+
+void TestExpiration(int connection) {
+  cpp2kdb::query_cache::QueryCache cache(1 << 20,
+                                         std::chrono::milliseconds(100));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCount(
+      cache.RunQuery(connection, "til 10"));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCount(
+      cache.RunQuery(connection, "til 10"));
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCount(
+      cache.RunQuery(connection, "til 10"));
+  PrintStatistics(cache);
+}
+
+void TestEviction(int connection) {
+  // Room for two vectors of 100 longs.
+  cpp2kdb::query_cache::QueryCache cache(2 * (16 + 800),
+                                         std::chrono::minutes(1));
+  const char* queries[] = {"100#1", "100#2", "100#3", "100#1"};
+  for (const char* query : queries) {
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCount(
+        cache.RunQuery(connection, query));
+  }
+  PrintStatistics(cache);
+
+  // Errors are not cached.
+  void* error = cache.RunQuery(connection, "`a+1");
+  if (error != nullptr) {
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(error);
+    std::cout << "Query `a+1 is error? "
+              << (cpp2kdb::accessors::IsError(error) ? "Yes" : "No")
+              << std::endl;
+  }
+  PrintStatistics(cache);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  int connection = cpp2kdb::kdb_wrapper::OpenConnection("127.0.0.1", 5000, "");
+  if (connection <= 0) {
+    std::cerr << "Connection error: " << connection << std::endl;
+    return 1;
+  }
+
+  TestHit(connection);
+  std::cout << "----------------------" << std::endl;
+  TestArguments(connection);
+  std::cout << "----------------------" << std::endl;
+  TestExpiration(connection);
+  std::cout << "----------------------" << std::endl;
+  TestEviction(connection);
+
+  cpp2kdb::kdb_wrapper::CloseConnection(connection);
+  return 0;
+}
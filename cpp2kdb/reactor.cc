@@ -0,0 +1,313 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/reactor.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <utility>
+
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace cpp2kdb::reactor {
+namespace {
+/// Number of events handled by one epoll_wait.
+constexpr int max_number_of_events = 64;
+}  // namespace
+
+Reactor::Reactor(std::size_t number_of_workers)
+    : number_of_workers(number_of_workers == 0 ? 1 : number_of_workers),
+      epoll_fd(-1),
+      wake_fd(-1),
+      is_started(false),
+      is_stopping(false) {
+  // do nothing here
+}
+
+Reactor::~Reactor() { this->Stop(); }
+
+bool Reactor::Start() {
+  if (this->is_started) {
+    return false;
+  }
+  this->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  this->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (this->epoll_fd < 0 || this->wake_fd < 0) {
+    this->CloseFileDescriptors();
+    return false;
+  }
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = this->wake_fd;
+  if (epoll_ctl(this->epoll_fd, EPOLL_CTL_ADD, this->wake_fd, &event) != 0) {
+    this->CloseFileDescriptors();
+    return false;
+  }
+
+  // Replies are deserialized on the event loop thread.
+  kdb_wrapper::SetSymbolInterningMutex(1);
+  this->is_started = true;
+  this->event_loop_thread = std::thread(&Reactor::RunEventLoop, this);
+  for (std::size_t i = 0; i < this->number_of_workers; i++) {
+    this->worker_threads.emplace_back(&Reactor::RunWorker, this);
+  }
+  return true;
+}
+
+void Reactor::Stop() {
+  if (this->event_loop_thread.joinable()) {
+    std::uint64_t value = 1;
+    if (write(this->wake_fd, &value, sizeof(value)) == sizeof(value)) {
+      this->event_loop_thread.join();
+    } else {
+      // Cannot happen with a valid eventfd, but don't block forever.
+      this->event_loop_thread.detach();
+    }
+  }
+
+  // Nothing reads the replies any more.
+  std::unordered_map<int, std::shared_ptr<ConnectionState>> removed;
+  {
+    std::lock_guard<std::mutex> connections_lock(this->connections_mutex);
+    removed.swap(this->connections);
+  }
+  for (auto& connection : removed) {
+    this->FailConnection(connection.second);
+  }
+
+  {
+    std::lock_guard<std::mutex> completions_lock(this->completions_mutex);
+    this->is_stopping = true;
+  }
+  this->completions_condition.notify_all();
+  for (std::thread& worker_thread : this->worker_threads) {
+    worker_thread.join();
+  }
+  this->worker_threads.clear();
+
+  this->CloseFileDescriptors();
+  // Ready to be started again.
+  {
+    std::lock_guard<std::mutex> completions_lock(this->completions_mutex);
+    this->is_stopping = false;
+  }
+  this->is_started = false;
+}
+
+bool Reactor::AddConnection(int connection) {
+  if (!this->is_started || connection <= 0) {
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> connections_lock(this->connections_mutex);
+    if (!this->connections
+             .emplace(connection, std::make_shared<ConnectionState>())
+             .second) {
+      return false;
+    }
+  }
+  // Level triggered, so a connection with more replies is reported again.
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = connection;
+  if (epoll_ctl(this->epoll_fd, EPOLL_CTL_ADD, connection, &event) != 0) {
+    std::lock_guard<std::mutex> connections_lock(this->connections_mutex);
+    this->connections.erase(connection);
+    return false;
+  }
+  return true;
+}
+
+bool Reactor::RemoveConnection(int connection) {
+  std::shared_ptr<ConnectionState> state;
+  {
+    std::lock_guard<std::mutex> connections_lock(this->connections_mutex);
+    auto iterator = this->connections.find(connection);
+    if (iterator == this->connections.end()) {
+      return false;
+    }
+    state = std::move(iterator->second);
+    this->connections.erase(iterator);
+  }
+  epoll_ctl(this->epoll_fd, EPOLL_CTL_DEL, connection, nullptr);
+  this->FailConnection(state);
+  return true;
+}
+
+bool Reactor::Submit(int connection, const char* query,
+                     async_query::QueryCallback callback) {
+  std::shared_ptr<ConnectionState> state = this->FindConnection(connection);
+  if (state == nullptr) {
+    return false;
+  }
+  std::int64_t request_id;
+  {
+    std::lock_guard<std::mutex> pending_lock(state->pending_mutex);
+    if (state->is_broken) {
+      return false;
+    }
+    // Register before sending, the reply may arrive before send returns.
+    request_id = state->next_request_id++;
+    state->pending_queries.emplace(request_id, std::move(callback));
+  }
+
+  bool is_sent;
+  {
+    std::lock_guard<std::mutex> send_lock(state->send_mutex);
+    is_sent = async_query::SendQueryWithReply(connection, request_id, query);
+  }
+  if (!is_sent) {
+    std::lock_guard<std::mutex> pending_lock(state->pending_mutex);
+    // The connection may have already been failed, and then the callback is
+    // already queued.
+    return state->pending_queries.erase(request_id) == 0;
+  }
+  return true;
+}
+
+std::future<void*> Reactor::Submit(int connection, const char* query) {
+  // std::function requires copyable callable, so share the promise.
+  auto promise = std::make_shared<std::promise<void*>>();
+  std::future<void*> future = promise->get_future();
+  bool is_sent =
+      this->Submit(connection, query,
+                   [promise](void* result) { promise->set_value(result); });
+  if (!is_sent) {
+    promise->set_value(nullptr);
+  }
+  return future;
+}
+
+std::size_t Reactor::GetNumberOfPendingQueries() {
+  std::vector<std::shared_ptr<ConnectionState>> states;
+  {
+    std::lock_guard<std::mutex> connections_lock(this->connections_mutex);
+    for (auto& connection : this->connections) {
+      states.push_back(connection.second);
+    }
+  }
+  std::size_t number_of_pending = 0;
+  for (auto& state : states) {
+    std::lock_guard<std::mutex> pending_lock(state->pending_mutex);
+    number_of_pending += state->pending_queries.size();
+  }
+  return number_of_pending;
+}
+
+std::shared_ptr<Reactor::ConnectionState> Reactor::FindConnection(
+    int connection) {
+  std::lock_guard<std::mutex> connections_lock(this->connections_mutex);
+  auto iterator = this->connections.find(connection);
+  if (iterator == this->connections.end()) {
+    return nullptr;
+  }
+  return iterator->second;
+}
+
+void Reactor::RunEventLoop() {
+  epoll_event events[max_number_of_events];
+  while (true) {
+    int number_of_events =
+        epoll_wait(this->epoll_fd, events, max_number_of_events, -1);
+    if (number_of_events < 0) {
+      // Interrupted by a signal.
+      continue;
+    }
+    for (int i = 0; i < number_of_events; i++) {
+      if (events[i].data.fd == this->wake_fd) {
+        return;
+      }
+      this->ReadReply(events[i].data.fd);
+    }
+  }
+}
+
+void Reactor::RunWorker() {
+  while (true) {
+    std::pair<async_query::QueryCallback, void*> completion;
+    {
+      std::unique_lock<std::mutex> completions_lock(this->completions_mutex);
+      this->completions_condition.wait(completions_lock, [this]() {
+        return this->is_stopping || !this->completions.empty();
+      });
+      // Finish the queued callbacks before stopping.
+      if (this->completions.empty()) {
+        return;
+      }
+      completion = std::move(this->completions.front());
+      this->completions.pop_front();
+    }
+    completion.first(completion.second);
+  }
+}
+
+void Reactor::ReadReply(int connection) {
+  std::shared_ptr<ConnectionState> state = this->FindConnection(connection);
+  if (state == nullptr) {
+    // Removed while the event is being handled.
+    return;
+  }
+  // The whole message is read, blocking if only a part of it has arrived.
+  void* message = kdb_wrapper::ReadMessageFromConnection(connection);
+  if (message == nullptr) {
+    // Connection is lost.
+    this->RemoveConnection(connection);
+    return;
+  }
+  std::int64_t request_id;
+  void* result;
+  if (!async_query::UnpackReply(message, &request_id, &result)) {
+    // Not sent for us, ignore it.
+    return;
+  }
+
+  async_query::QueryCallback callback;
+  {
+    std::lock_guard<std::mutex> pending_lock(state->pending_mutex);
+    auto iterator = state->pending_queries.find(request_id);
+    if (iterator != state->pending_queries.end()) {
+      callback = std::move(iterator->second);
+      state->pending_queries.erase(iterator);
+    }
+  }
+  if (callback) {
+    this->Post(std::move(callback), result);
+  } else {
+    kdb_wrapper::DecreaseReferenceCount(result);
+  }
+}
+
+void Reactor::FailConnection(const std::shared_ptr<ConnectionState>& state) {
+  std::unordered_map<std::int64_t, async_query::QueryCallback> failed_queries;
+  {
+    std::lock_guard<std::mutex> pending_lock(state->pending_mutex);
+    state->is_broken = true;
+    failed_queries.swap(state->pending_queries);
+  }
+  for (auto& failed_query : failed_queries) {
+    this->Post(std::move(failed_query.second), nullptr);
+  }
+}
+
+void Reactor::CloseFileDescriptors() {
+  if (this->epoll_fd >= 0) {
+    close(this->epoll_fd);
+    this->epoll_fd = -1;
+  }
+  if (this->wake_fd >= 0) {
+    close(this->wake_fd);
+    this->wake_fd = -1;
+  }
+}
+
+void Reactor::Post(async_query::QueryCallback callback, void* result) {
+  {
+    std::lock_guard<std::mutex> completions_lock(this->completions_mutex);
+    this->completions.emplace_back(std::move(callback), result);
+  }
+  this->completions_condition.notify_one();
+}
+}  // namespace cpp2kdb::reactor
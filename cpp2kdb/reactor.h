@@ -0,0 +1,153 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_REACTOR_H__
+#define CPP2KDB_REACTOR_H__
+/// \file cpp2kdb/reactor.h
+/// Event loop serving many connections with a few threads.
+///
+/// The handle returned by kdb_wrapper::OpenConnection is the file descriptor
+/// of the socket, so it is registered with epoll. One thread waits for the
+/// connections to become readable and reads the replies, and a pool of worker
+/// threads calls the callbacks. Queries are sent with
+/// async_query::SendQueryWithReply, so each connection can have any number of
+/// queries in flight. Linux only.
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "cpp2kdb/async_query.h"
+
+/// Serving many connections opened by kdb_wrapper::OpenConnection.
+namespace cpp2kdb::reactor {
+/// Event loop serving many connections.
+///
+/// Callbacks follow the rules of async_query::QueryCallback, but are called on
+/// the worker threads, so callbacks of different queries can run at the same
+/// time. Symbol interning is protected by mutex
+/// (kdb_wrapper::SetSymbolInterningMutex) when the reactor is started.
+///
+/// The connections are not owned, and must be left alone by other code while
+/// they are added to the reactor.
+class Reactor {
+ public:
+  /// Create with the number of worker threads calling the callbacks.
+  explicit Reactor(std::size_t number_of_workers);
+  /// Default constructor is deleted.
+  Reactor() = delete;
+  /// Copy constructor is deleted.
+  Reactor(const Reactor&) = delete;
+  /// assignment operator is deleted.
+  Reactor& operator=(const Reactor&) = delete;
+
+  /// Destructor, calling Stop.
+  ~Reactor();
+
+  /// Start the event loop and the workers.
+  /// \returns false if it is already started, or epoll cannot be created.
+  bool Start();
+
+  /// Stop the event loop and the workers.
+  ///
+  /// Queries still pending are completed with nullptr, and their replies are
+  /// left unread on the connections, which should be closed. Callbacks already
+  /// queued are called before the workers stop. The connections are removed,
+  /// and Reactor can be started again.
+  void Stop();
+
+  /// Add a connection.
+  /// \returns false if it is already added, or cannot be added to epoll.
+  bool AddConnection(
+      /// Handle
+      int connection);
+
+  /// Remove a connection, completing its pending queries with nullptr.
+  /// \returns false if it is not added.
+  bool RemoveConnection(
+      /// Handle
+      int connection);
+
+  /// Submit a query on a connection, and call callback with its result.
+  /// \returns false if the connection is not added or lost, or the query
+  /// cannot be sent, and callback is not called.
+  bool Submit(
+      /// Handle
+      int connection,
+      /// Query
+      const char* query,
+      /// Called on a worker thread with the result.
+      async_query::QueryCallback callback);
+
+  /// Submit a query on a connection, and get its result through a future.
+  ///
+  /// If the query cannot be submitted, the future is ready with nullptr.
+  std::future<void*> Submit(
+      /// Handle
+      int connection,
+      /// Query
+      const char* query);
+
+  /// Get the number of queries submitted but without reply yet, on all the
+  /// connections.
+  std::size_t GetNumberOfPendingQueries();
+
+ private:
+  /// Queries in flight on one connection.
+  struct ConnectionState {
+    /// Protects writing to the connection.
+    std::mutex send_mutex;
+    /// Protects pending_queries, next_request_id and is_broken.
+    std::mutex pending_mutex;
+    std::unordered_map<std::int64_t, async_query::QueryCallback>
+        pending_queries;
+    std::int64_t next_request_id = 0;
+    /// Set when the connection is lost or removed.
+    bool is_broken = false;
+  };
+
+  /// Find the state of a connection. nullptr if not added.
+  std::shared_ptr<ConnectionState> FindConnection(int connection);
+  /// Loop of the event loop thread.
+  void RunEventLoop();
+  /// Loop of the worker threads.
+  void RunWorker();
+  /// Read one reply from a readable connection.
+  void ReadReply(int connection);
+  /// Mark the connection broken, and complete its pending queries with
+  /// nullptr.
+  void FailConnection(const std::shared_ptr<ConnectionState>& state);
+  /// Close epoll_fd and wake_fd if they are open.
+  void CloseFileDescriptors();
+  /// Queue a callback to be called on a worker thread.
+  void Post(async_query::QueryCallback callback, void* result);
+
+  std::size_t number_of_workers;
+  int epoll_fd;
+  /// eventfd waking up the event loop to stop.
+  int wake_fd;
+  bool is_started;
+  std::thread event_loop_thread;
+  std::vector<std::thread> worker_threads;
+
+  /// Protects connections.
+  std::mutex connections_mutex;
+  std::unordered_map<int, std::shared_ptr<ConnectionState>> connections;
+
+  /// Protects completions and is_stopping.
+  std::mutex completions_mutex;
+  std::condition_variable completions_condition;
+  std::deque<std::pair<async_query::QueryCallback, void*>> completions;
+  bool is_stopping;
+};
+}  // namespace cpp2kdb::reactor
+#endif  // CPP2KDB_REACTOR_H__
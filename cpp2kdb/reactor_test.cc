@@ -0,0 +1,125 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/reactor.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace {
+constexpr int number_of_connections = 16;
+constexpr int number_of_queries_per_connection = 1000;
+
+void TestManyQueries(cpp2kdb::reactor::Reactor* reactor,
+                     const std::vector<int>& connections) {
+  std::atomic<int> number_of_correct{0};
+  std::mutex done_mutex;
+  std::condition_variable done_condition;
+  int number_of_done = 0;
+  int number_of_submitted = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  // Submit everything first, so all the queries are in flight together.
+  for (int i = 0; i < number_of_queries_per_connection; i++) {
+    for (int connection : connections) {
+      std::string query = std::to_string(i) + " * 2";
+      bool is_submitted = reactor->Submit(
+          connection, query.c_str(),
+          [i, &number_of_correct, &done_mutex, &done_condition,
+           &number_of_done](void* result) {
+            if (result != nullptr) {
+              cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(result);
+              if (cpp2kdb::accessors::GetValue<std::int64_t>(result) == i * 2) {
+                number_of_correct++;
+              }
+            }
+            std::lock_guard<std::mutex> done_lock(done_mutex);
+            number_of_done++;
+            done_condition.notify_one();
+          });
+      if (is_submitted) {
+        number_of_submitted++;
+      }
+    }
+  }
+  std::cout << "Pending queries after submission: "
+            << reactor->GetNumberOfPendingQueries() << std::endl;
+  {
+    std::unique_lock<std::mutex> done_lock(done_mutex);
+    done_condition.wait(done_lock, [&number_of_done, &number_of_submitted]() {
+      return number_of_done == number_of_submitted;
+    });
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  std::cout << "Correct results: " << number_of_correct << " out of "
+            << number_of_connections * number_of_queries_per_connection
+            << " in " << elapsed.count() << "ms" << std::endl;
+}
+
+void TestFuture(cpp2kdb::reactor::Reactor* reactor, int connection) {
+  void* result = reactor->Submit(connection, "1 + `a").get();
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(result);
+  std::cout << "Result of 1 + `a is error? "
+            << (cpp2kdb::accessors::IsError(result) ? "Yes" : "No")
+            << std::endl;
+}
+
+void TestRemovedConnection(cpp2kdb::reactor::Reactor* reactor,
+                           int connection) {
+  reactor->RemoveConnection(connection);
+  std::cout << "Submit on a removed connection: "
+            << (reactor->Submit(connection, "::", [](void*) {}) ? "Succeeded"
+                                                                : "Failed")
+            << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::vector<int> connections;
+  for (int i = 0; i < number_of_connections; i++) {
+    int connection =
+        cpp2kdb::kdb_wrapper::OpenConnection("127.0.0.1", 5000, "");
+    if (connection <= 0) {
+      std::cerr << "Connection error: " << connection << std::endl;
+      return 1;
+    }
+    connections.push_back(connection);
+  }
+
+  {
+    cpp2kdb::reactor::Reactor reactor(4);
+    reactor.Start();
+    for (int connection : connections) {
+      reactor.AddConnection(connection);
+    }
+    TestManyQueries(&reactor, connections);
+    std::cout << "----------------------" << std::endl;
+    TestFuture(&reactor, connections[0]);
+    std::cout << "----------------------" << std::endl;
+    TestRemovedConnection(&reactor, connections[0]);
+    reactor.Stop();
+    std::cout << "----------------------" << std::endl;
+
+    // Stop removes the connections, they are added again after restarting.
+    std::cout << "Restarted? " << (reactor.Start() ? "Yes" : "No")
+              << std::endl;
+    reactor.AddConnection(connections[0]);
+    TestFuture(&reactor, connections[0]);
+    reactor.Stop();
+  }
+
+  for (int connection : connections) {
+    cpp2kdb::kdb_wrapper::CloseConnection(connection);
+  }
+  return 0;
+}
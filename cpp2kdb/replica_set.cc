@@ -0,0 +1,198 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/replica_set.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "cpp2kdb/async_query.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace cpp2kdb::replica_set {
+const char* GetReplicaSetResultName(ReplicaSetResult result) {
+  // Cast result to an int.
+  int temp_result = static_cast<int>(result);
+  // Make sure it's valid.
+  if (temp_result >= 0 && temp_result < number_of_replica_set_result_names) {
+    return ReplicaSetResultNames[temp_result];
+  } else {
+    return "Invalid";
+  }
+}
+
+std::ostream& operator<<(std::ostream& output, ReplicaSetResult result) {
+  return output << GetReplicaSetResultName(result);
+}
+
+ReplicaSet::ReplicaSet(std::vector<int> connections,
+                       ReplicaSetOptions options)
+    : connections(std::move(connections)),
+      options(options),
+      next_request_id(0),
+      next_replica_index(0),
+      number_of_hedged_queries(0),
+      number_of_queries_won_by_hedge(0) {
+  this->is_lost.assign(this->connections.size(), false);
+  this->number_of_pending_replies.assign(this->connections.size(), 0);
+}
+
+ReplicaSetResult ReplicaSet::RunQuery(const char* query, void** result) {
+  *result = nullptr;
+  this->DrainPendingReplies();
+  std::int64_t request_id = this->next_request_id++;
+  this->next_replica_index = 0;
+  this->waiting_replicas.clear();
+  if (!this->SendToNextReplica(request_id, query)) {
+    return ReplicaSetResult::ReplicasLost;
+  }
+  std::size_t first_replica_index = this->waiting_replicas.front();
+  bool is_hedged = false;
+  auto start = std::chrono::steady_clock::now();
+  auto deadline = start + this->options.query_time_out;
+  auto hedge_time = start + this->options.hedge_delay;
+
+  std::vector<int> waiting_connections;
+  while (true) {
+    if (this->waiting_replicas.empty()) {
+      // All the replicas sent to are lost, fail over immediately.
+      if (!this->SendToNextReplica(request_id, query)) {
+        return ReplicaSetResult::ReplicasLost;
+      }
+      hedge_time = std::chrono::steady_clock::now() + this->options.hedge_delay;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      return ReplicaSetResult::TimedOut;
+    }
+    // Wake up for the next hedge, if there is a replica left to hedge to, and
+    // no later than the deadline.
+    auto wake_up_time = deadline;
+    if (this->next_replica_index < this->connections.size()) {
+      wake_up_time = std::min(hedge_time, deadline);
+    }
+    // Round up, so the wake up time is not missed by the truncation.
+    int timeout = static_cast<int>(std::max<std::int64_t>(
+        0, std::chrono::ceil<std::chrono::milliseconds>(wake_up_time - now)
+               .count()));
+    waiting_connections.clear();
+    for (std::size_t replica_index : this->waiting_replicas) {
+      waiting_connections.push_back(this->connections[replica_index]);
+    }
+    int ready_index =
+        async_query::WaitForMessage(waiting_connections.data(),
+                                    waiting_connections.size(), timeout);
+    if (ready_index == -1) {
+      if (std::chrono::steady_clock::now() < hedge_time) {
+        // Woken up for the deadline.
+        continue;
+      }
+      // Hedge delay passed without reply.
+      if (this->SendToNextReplica(request_id, query) && !is_hedged) {
+        is_hedged = true;
+        this->number_of_hedged_queries++;
+      }
+      hedge_time = std::chrono::steady_clock::now() + this->options.hedge_delay;
+      continue;
+    }
+    if (ready_index < 0) {
+      return ReplicaSetResult::ReplicasLost;
+    }
+
+    std::size_t replica_index = this->waiting_replicas[ready_index];
+    std::int64_t reply_id;
+    void* reply;
+    if (!this->ReadReply(replica_index, &reply_id, &reply)) {
+      continue;
+    }
+    if (reply_id != request_id) {
+      // Reply of an earlier query answered by another replica.
+      kdb_wrapper::DecreaseReferenceCount(reply);
+      continue;
+    }
+    if (replica_index != first_replica_index) {
+      this->number_of_queries_won_by_hedge++;
+    }
+    // Release the replies of the other replicas which have already arrived.
+    this->DrainPendingReplies();
+    *result = reply;
+    return ReplicaSetResult::Ok;
+  }
+}
+
+bool ReplicaSet::IsReplicaLost(std::size_t replica_index) const {
+  return this->is_lost[replica_index];
+}
+
+std::size_t ReplicaSet::GetNumberOfPendingReplies(
+    std::size_t replica_index) const {
+  return this->number_of_pending_replies[replica_index];
+}
+
+std::size_t ReplicaSet::GetNumberOfHedgedQueries() const {
+  return this->number_of_hedged_queries;
+}
+
+std::size_t ReplicaSet::GetNumberOfQueriesWonByHedge() const {
+  return this->number_of_queries_won_by_hedge;
+}
+
+bool ReplicaSet::SendToNextReplica(std::int64_t request_id,
+                                   const char* query) {
+  while (this->next_replica_index < this->connections.size()) {
+    std::size_t replica_index = this->next_replica_index++;
+    if (this->is_lost[replica_index]) {
+      continue;
+    }
+    if (async_query::SendQueryWithReply(this->connections[replica_index],
+                                        request_id, query)) {
+      this->number_of_pending_replies[replica_index]++;
+      this->waiting_replicas.push_back(replica_index);
+      return true;
+    }
+    this->MarkLost(replica_index);
+  }
+  return false;
+}
+
+void ReplicaSet::DrainPendingReplies() {
+  for (std::size_t i = 0; i < this->connections.size(); i++) {
+    // Closed connections are ready too, reading them marks them lost.
+    while (!this->is_lost[i] && this->number_of_pending_replies[i] > 0 &&
+           async_query::WaitForMessage(&this->connections[i], 1, 0) == 0) {
+      std::int64_t request_id;
+      void* reply;
+      if (this->ReadReply(i, &request_id, &reply)) {
+        kdb_wrapper::DecreaseReferenceCount(reply);
+      }
+    }
+  }
+}
+
+bool ReplicaSet::ReadReply(std::size_t replica_index,
+                           std::int64_t* request_id, void** result) {
+  void* message = kdb_wrapper::ReadMessageFromConnection(
+      this->connections[replica_index]);
+  if (message == nullptr) {
+    this->MarkLost(replica_index);
+    return false;
+  }
+  if (!async_query::UnpackReply(message, request_id, result)) {
+    return false;
+  }
+  this->number_of_pending_replies[replica_index]--;
+  return true;
+}
+
+void ReplicaSet::MarkLost(std::size_t replica_index) {
+  this->is_lost[replica_index] = true;
+  // Nothing is read from the replica any more.
+  this->number_of_pending_replies[replica_index] = 0;
+  this->waiting_replicas.erase(
+      std::remove(this->waiting_replicas.begin(), this->waiting_replicas.end(),
+                  replica_index),
+      this->waiting_replicas.end());
+}
+}  // namespace cpp2kdb::replica_set
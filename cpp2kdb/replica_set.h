@@ -0,0 +1,148 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_REPLICA_SET_H__
+#define CPP2KDB_REPLICA_SET_H__
+/// \file cpp2kdb/replica_set.h
+/// Hedged read queries across replicas of the same data.
+///
+/// The query is sent to the first replica. If no reply arrives within the
+/// hedge delay, the same query is sent to the next replica, and so on. The
+/// first reply is taken. The replies of the other replicas are read and
+/// released as soon as they have arrived, when the replica set is used next.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+/// Replicas on connections opened by kdb_wrapper::OpenConnection.
+namespace cpp2kdb::replica_set {
+/// Replica Set Result
+enum class ReplicaSetResult {
+  /// Ok.
+  Ok = 0,
+  /// No reply before the query time out.
+  TimedOut,
+  /// All the replicas are lost.
+  ReplicasLost
+};
+
+/// Names for the enums.
+constexpr const char* ReplicaSetResultNames[] = {"Ok", "TimedOut",
+                                                 "ReplicasLost"};
+
+/// Number of replica set result names
+constexpr const int number_of_replica_set_result_names =
+    sizeof(ReplicaSetResultNames) / sizeof(ReplicaSetResultNames[0]);
+
+/// Get the name from a result
+const char* GetReplicaSetResultName(ReplicaSetResult result);
+
+/// Overload << for result type `ReplicaSetResult`.
+std::ostream& operator<<(std::ostream& output_stream, ReplicaSetResult result);
+
+/// Options of ReplicaSet.
+struct ReplicaSetOptions {
+  /// Time to wait for a replica before sending the query to the next one.
+  std::chrono::milliseconds hedge_delay{20};
+  /// Time to wait for the first reply of a query, from when it is first sent,
+  /// including the hedges.
+  std::chrono::milliseconds query_time_out{60000};
+};
+
+/// Replicas serving the same read queries.
+///
+/// A replica whose connection is lost is skipped from then on, so its queries
+/// fail over to the next replica without waiting for the hedge delay.
+///
+/// ReplicaSet is not thread safe, and runs one query at a time. The
+/// connections are not owned, and must be left alone by other code while
+/// ReplicaSet is used, since they may still have replies of hedged queries to
+/// be read.
+class ReplicaSet {
+ public:
+  /// Create on handles returned by kdb_wrapper::OpenConnection, in the order
+  /// they are tried.
+  ReplicaSet(
+      /// Handles, the first one is the primary.
+      std::vector<int> connections,
+      /// Options.
+      ReplicaSetOptions options = ReplicaSetOptions());
+  /// Default constructor is deleted.
+  ReplicaSet() = delete;
+  /// Copy constructor is deleted.
+  ReplicaSet(const ReplicaSet&) = delete;
+  /// assignment operator is deleted.
+  ReplicaSet& operator=(const ReplicaSet&) = delete;
+
+  /// Run a read query on the replicas, hedged.
+  ///
+  /// The query may run on more than one replica, so it must not change
+  /// anything. The replies of the replicas not answering first are read and
+  /// released without blocking: those already arrived when the query returns
+  /// are released before it returns, and the later ones at the start of the
+  /// next query, or when the replica is waited on. The same goes for the
+  /// replies arriving after TimedOut.
+  /// \returns TimedOut if no reply arrives within the query time out, and
+  ///          ReplicasLost if all the replicas are lost.
+  ReplicaSetResult RunQuery(
+      /// Query
+      const char* query,
+      /// [out] Result owned by the caller when Ok, which must be released with
+      /// kdb_wrapper::DecreaseReferenceCount. It is an error object (type
+      /// -128) if the query failed on the replica answering first. nullptr
+      /// otherwise.
+      void** result);
+
+  /// Get if the connection of a replica is lost.
+  bool IsReplicaLost(std::size_t replica_index) const;
+
+  /// Get the number of replies sent by a replica and not read yet.
+  std::size_t GetNumberOfPendingReplies(std::size_t replica_index) const;
+
+  /// Get the number of queries sent to more than one replica.
+  std::size_t GetNumberOfHedgedQueries() const;
+
+  /// Get the number of queries answered first by a replica other than the
+  /// first one the query is sent to.
+  std::size_t GetNumberOfQueriesWonByHedge() const;
+
+ private:
+  /// Send the query to the next replica not lost.
+  /// \returns false if there is no replica left.
+  bool SendToNextReplica(std::int64_t request_id, const char* query);
+
+  /// Read and release the replies of older queries which have arrived,
+  /// without blocking.
+  void DrainPendingReplies();
+
+  /// Read one message from a replica, marking it lost if that fails.
+  /// \returns false if the message is not a reply.
+  bool ReadReply(std::size_t replica_index, std::int64_t* request_id,
+                 void** result);
+
+  /// Mark a replica lost.
+  void MarkLost(std::size_t replica_index);
+
+  std::vector<int> connections;
+  std::vector<bool> is_lost;
+  /// Number of queries sent to each replica whose reply is not read yet.
+  /// Replies on a connection arrive in the order the queries are sent.
+  std::vector<std::size_t> number_of_pending_replies;
+  ReplicaSetOptions options;
+  std::int64_t next_request_id;
+
+  // State of the query running.
+  /// Index of the next replica to send the query to.
+  std::size_t next_replica_index;
+  /// Replicas the query is sent to, and not lost since.
+  std::vector<std::size_t> waiting_replicas;
+
+  std::size_t number_of_hedged_queries;
+  std::size_t number_of_queries_won_by_hedge;
+};
+}  // namespace cpp2kdb::replica_set
+#endif  // CPP2KDB_REPLICA_SET_H__
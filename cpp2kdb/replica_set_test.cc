@@ -0,0 +1,112 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/replica_set.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+#include "cpp2kdb/stand_in_server.h"
+
+// The replicas are stand-in servers, no q process is needed.
+namespace {
+/// Query answered by each replica with its index.
+constexpr const char* query = "replica";
+
+/// Start a replica answering query with replica_index.
+bool StartReplica(cpp2kdb::stand_in_server::StandInServer* server,
+                  std::int64_t replica_index) {
+  if (!server->Start()) {
+    return false;
+  }
+  void* reply = cpp2kdb::kdb_wrapper::CreateLong(replica_index);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(reply);
+  return server->RegisterKObjectReply(query, reply);
+}
+
+void RunAndPrint(cpp2kdb::replica_set::ReplicaSet* replica_set) {
+  auto start = std::chrono::steady_clock::now();
+  void* result;
+  cpp2kdb::replica_set::ReplicaSetResult query_result =
+      replica_set->RunQuery(query, &result);
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  if (query_result != cpp2kdb::replica_set::ReplicaSetResult::Ok) {
+    std::cout << "Query: " << query_result << " in " << elapsed.count()
+              << "ms" << std::endl;
+    return;
+  }
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(result);
+  std::cout << "Answered by replica "
+            << cpp2kdb::accessors::GetValue<std::int64_t>(result) << " in "
+            << elapsed.count() << "ms" << std::endl;
+}
+
+void PrintPendingReplies(
+    const cpp2kdb::replica_set::ReplicaSet& replica_set) {
+  std::cout << "Replies pending: " << replica_set.GetNumberOfPendingReplies(0)
+            << " and " << replica_set.GetNumberOfPendingReplies(1)
+            << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  cpp2kdb::stand_in_server::StandInServer primary_server;
+  cpp2kdb::stand_in_server::StandInServer secondary_server;
+  if (!StartReplica(&primary_server, 0) ||
+      !StartReplica(&secondary_server, 1)) {
+    std::cerr << "Cannot start replicas" << std::endl;
+    return 1;
+  }
+  int primary = cpp2kdb::kdb_wrapper::OpenConnection(
+      "127.0.0.1", primary_server.GetPort(), "");
+  int secondary = cpp2kdb::kdb_wrapper::OpenConnection(
+      "127.0.0.1", secondary_server.GetPort(), "");
+  if (primary <= 0 || secondary <= 0) {
+    std::cerr << "Connection error: " << primary << " " << secondary
+              << std::endl;
+    return 1;
+  }
+
+  cpp2kdb::replica_set::ReplicaSetOptions options;
+  options.hedge_delay = std::chrono::milliseconds(50);
+  options.query_time_out = std::chrono::milliseconds(500);
+  cpp2kdb::replica_set::ReplicaSet replica_set({primary, secondary}, options);
+
+  // Both fast, the primary answers.
+  RunAndPrint(&replica_set);
+  std::cout << "----------------------" << std::endl;
+
+  // Primary stalls, the hedge to the secondary answers.
+  primary_server.SetLatency(std::chrono::seconds(1));
+  RunAndPrint(&replica_set);
+  std::cout << "Hedged queries: " << replica_set.GetNumberOfHedgedQueries()
+            << ", won by hedge: " << replica_set.GetNumberOfQueriesWonByHedge()
+            << std::endl;
+  // The reply of the primary is still on its way.
+  PrintPendingReplies(replica_set);
+  std::cout << "----------------------" << std::endl;
+
+  // Both stall, the query times out.
+  secondary_server.SetLatency(std::chrono::seconds(1));
+  RunAndPrint(&replica_set);
+  PrintPendingReplies(replica_set);
+  std::cout << "----------------------" << std::endl;
+
+  // Primary is lost, fail over without waiting. The late reply of the
+  // secondary is read and released before the reply of this query.
+  primary_server.Stop();
+  secondary_server.SetLatency(std::chrono::microseconds(0));
+  RunAndPrint(&replica_set);
+  std::cout << "Primary is lost? "
+            << (replica_set.IsReplicaLost(0) ? "Yes" : "No") << std::endl;
+  PrintPendingReplies(replica_set);
+
+  cpp2kdb::kdb_wrapper::CloseConnection(primary);
+  cpp2kdb::kdb_wrapper::CloseConnection(secondary);
+  return 0;
+}
@@ -0,0 +1,435 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/stand_in_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "cpp2kdb/ipc_decoder.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace cpp2kdb::stand_in_server {
+namespace {
+/// Capability sent back in the handshake: 1 TB limit and timestamps.
+constexpr char server_capability = 3;
+
+/// Largest chunk written at once when the bandwidth is limited.
+constexpr std::size_t throttle_chunk_size = 64 * 1024;
+
+/// Message type of a response in the header.
+constexpr char response_message_type = 2;
+
+/// Message type of an asynchronous message in the header.
+constexpr char async_message_type = 0;
+
+/// Number of elements in a message sent by async_query::SendQueryWithReply,
+/// and in its reply.
+constexpr std::size_t number_of_query_with_reply_elements = 3;
+
+/// Read exactly size bytes.
+bool ReadAll(int fd, char* buffer, std::size_t size) {
+  while (size > 0) {
+    ssize_t n = recv(fd, buffer, size, 0);
+    if (n <= 0) {
+      return false;
+    }
+    buffer += n;
+    size -= n;
+  }
+  return true;
+}
+
+/// Write exactly size bytes.
+bool WriteAll(int fd, const char* buffer, std::size_t size) {
+  while (size > 0) {
+    ssize_t n = send(fd, buffer, size, MSG_NOSIGNAL);
+    if (n <= 0) {
+      return false;
+    }
+    buffer += n;
+    size -= n;
+  }
+  return true;
+}
+
+/// Read the credentials sent by the client, up to the terminating \0, and
+/// answer with the capability.
+bool Handshake(int fd) {
+  char c;
+  do {
+    if (!ReadAll(fd, &c, 1)) {
+      return false;
+    }
+  } while (c != '\0');
+  return WriteAll(fd, &server_capability, 1);
+}
+
+/// Build an IPC message holding an error object.
+std::vector<char> BuildErrorMessage(const std::string& message) {
+  std::uint32_t message_size = static_cast<std::uint32_t>(
+      ipc_decoder::message_header_size + 1 + message.size() + 1);
+  std::vector<char> buffer(message_size, '\0');
+  buffer[0] = 1;  // little endian
+  buffer[1] = response_message_type;
+  std::memcpy(buffer.data() + 4, &message_size, sizeof(message_size));
+  buffer[ipc_decoder::message_header_size] =
+      static_cast<char>(q_types::q_error_type_id);
+  std::memcpy(buffer.data() + ipc_decoder::message_header_size + 1,
+              message.data(), message.size());
+  return buffer;
+}
+
+/// Get the text of a query, which is a char vector, or a mixed list starting
+/// with a char vector when the query has arguments.
+bool GetQueryText(const char* buffer, std::size_t buffer_size,
+                  std::string* query) {
+  ipc_decoder::MessageHeader header;
+  ipc_decoder::ObjectView view;
+  if (ipc_decoder::DecodeMessage(buffer, buffer_size, &header, &view) !=
+      ipc_decoder::DecodeResult::Ok) {
+    return false;
+  }
+  if (view.q_type_id == q_types::q_mixed_type_id &&
+      view.number_of_elements > 0) {
+    // The first element follows the header of the list.
+    ipc_decoder::ObjectView first;
+    if (ipc_decoder::DecodeObject(view.data, buffer + buffer_size - view.data,
+                                  &first) != ipc_decoder::DecodeResult::Ok) {
+      return false;
+    }
+    view = first;
+  }
+  if (view.q_type_id != q_types::q_char_type_id) {
+    return false;
+  }
+  query->assign(view.data, view.number_of_elements);
+  return true;
+}
+
+/// Get the request id and the text of a query sent by
+/// async_query::SendQueryWithReply, which is (function; request id; query
+/// text).
+bool GetQueryWithReply(const char* buffer, std::size_t buffer_size,
+                       std::int64_t* request_id, std::string* query) {
+  ipc_decoder::MessageHeader header;
+  ipc_decoder::ObjectView view;
+  if (ipc_decoder::DecodeMessage(buffer, buffer_size, &header, &view) !=
+          ipc_decoder::DecodeResult::Ok ||
+      view.q_type_id != q_types::q_mixed_type_id ||
+      view.number_of_elements != number_of_query_with_reply_elements) {
+    return false;
+  }
+  ipc_decoder::ObjectView elements[number_of_query_with_reply_elements];
+  if (ipc_decoder::GetMixedVectorElements(view, elements) !=
+          ipc_decoder::DecodeResult::Ok ||
+      elements[0].q_type_id != q_types::q_char_type_id ||
+      elements[1].q_type_id != -q_types::q_long_type_id ||
+      elements[2].q_type_id != q_types::q_char_type_id) {
+    return false;
+  }
+  *request_id = ipc_decoder::GetValue<std::int64_t>(elements[1]);
+  query->assign(elements[2].data, elements[2].number_of_elements);
+  return true;
+}
+
+/// Build the message sent back with neg[.z.w] for a query sent with reply,
+/// which is (request id; 1b; result), or (request id; 0b; error message) if
+/// reply holds an error object.
+std::vector<char> BuildQueryWithReplyMessage(std::int64_t request_id,
+                                             const std::vector<char>& reply) {
+  const char* object = reply.data() + ipc_decoder::message_header_size;
+  std::size_t object_size = reply.size() - ipc_decoder::message_header_size;
+  bool is_error =
+      object_size > 0 &&
+      static_cast<signed char>(object[0]) == q_types::q_error_type_id;
+  std::string error_message;
+  if (is_error) {
+    error_message.assign(object + 1, strnlen(object + 1, object_size - 1));
+  }
+
+  // The error message is sent as a char vector: type, attribute and length.
+  std::size_t result_size =
+      is_error ? 1 + 1 + sizeof(std::int32_t) + error_message.size()
+               : object_size;
+  // Mixed list header, then a long atom and a boolean atom.
+  std::uint32_t message_size = static_cast<std::uint32_t>(
+      ipc_decoder::message_header_size + 1 + 1 + sizeof(std::int32_t) + 1 +
+      sizeof(std::int64_t) + 1 + 1 + result_size);
+  std::vector<char> buffer(message_size, '\0');
+  buffer[0] = 1;  // little endian
+  buffer[1] = async_message_type;
+  std::memcpy(buffer.data() + 4, &message_size, sizeof(message_size));
+
+  char* data = buffer.data() + ipc_decoder::message_header_size;
+  *data++ = static_cast<char>(q_types::q_mixed_type_id);
+  *data++ = 0;  // attribute
+  std::int32_t number_of_elements = number_of_query_with_reply_elements;
+  std::memcpy(data, &number_of_elements, sizeof(number_of_elements));
+  data += sizeof(number_of_elements);
+  *data++ = static_cast<char>(-q_types::q_long_type_id);
+  std::memcpy(data, &request_id, sizeof(request_id));
+  data += sizeof(request_id);
+  *data++ = static_cast<char>(-q_types::q_boolean_type_id);
+  *data++ = is_error ? 0 : 1;
+  if (is_error) {
+    *data++ = static_cast<char>(q_types::q_char_type_id);
+    *data++ = 0;  // attribute
+    std::int32_t length = static_cast<std::int32_t>(error_message.size());
+    std::memcpy(data, &length, sizeof(length));
+    data += sizeof(length);
+    std::memcpy(data, error_message.data(), error_message.size());
+  } else {
+    std::memcpy(data, object, object_size);
+  }
+  return buffer;
+}
+}  // namespace
+
+StandInServer::StandInServer(ServerOptions options)
+    : options(options),
+      listen_fd(-1),
+      port(0),
+      latency_in_microseconds(options.latency.count()) {
+  // do nothing here
+}
+
+StandInServer::~StandInServer() { this->Stop(); }
+
+bool StandInServer::Start() {
+  if (this->is_running) {
+    return true;
+  }
+  this->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (this->listen_fd < 0) {
+    return false;
+  }
+  int reuse = 1;
+  setsockopt(this->listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(static_cast<std::uint16_t>(this->options.port));
+  socklen_t address_size = sizeof(address);
+  if (bind(this->listen_fd, reinterpret_cast<sockaddr*>(&address),
+           address_size) != 0 ||
+      listen(this->listen_fd, SOMAXCONN) != 0 ||
+      getsockname(this->listen_fd, reinterpret_cast<sockaddr*>(&address),
+                  &address_size) != 0) {
+    close(this->listen_fd);
+    this->listen_fd = -1;
+    return false;
+  }
+  this->port = ntohs(address.sin_port);
+  this->is_running = true;
+  this->accept_thread = std::thread(&StandInServer::AcceptLoop, this);
+  return true;
+}
+
+void StandInServer::Stop() {
+  if (!this->is_running.exchange(false)) {
+    return;
+  }
+  // Shutting down wakes up the threads blocked in accept and recv.
+  shutdown(this->listen_fd, SHUT_RDWR);
+  this->accept_thread.join();
+  close(this->listen_fd);
+  this->listen_fd = -1;
+
+  std::vector<std::thread> threads;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (int client_fd : this->client_fds) {
+      shutdown(client_fd, SHUT_RDWR);
+    }
+    threads.swap(this->client_threads);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+int StandInServer::GetPort() const { return this->port; }
+
+void StandInServer::RegisterReply(std::string query,
+                                  std::vector<char> message) {
+  auto reply = std::make_shared<const std::vector<char>>(std::move(message));
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->replies[std::move(query)] = std::move(reply);
+}
+
+bool StandInServer::RegisterKObjectReply(std::string query, void* x) {
+  void* bytes = kdb_wrapper::Serialize(2, x);
+  if (bytes == nullptr) {
+    return false;
+  }
+  kdb_wrapper::DecreaseReferenceCountGuard guard(bytes);
+  if (accessors::IsError(bytes)) {
+    return false;
+  }
+  const char* data = accessors::GetVector<char>(bytes);
+  this->RegisterReply(
+      std::move(query),
+      std::vector<char>(
+          data, data + kdb_wrapper::GetNumberOfVectorElements(bytes)));
+  return true;
+}
+
+void StandInServer::RegisterErrorReply(std::string query,
+                                       const std::string& message) {
+  this->RegisterReply(std::move(query), BuildErrorMessage(message));
+}
+
+void StandInServer::SetLatency(std::chrono::microseconds latency) {
+  this->latency_in_microseconds.store(latency.count(),
+                                      std::memory_order_relaxed);
+}
+
+std::uint64_t StandInServer::GetNumberOfQueries() const {
+  return this->number_of_queries.load(std::memory_order_relaxed);
+}
+
+void StandInServer::AcceptLoop() {
+  while (this->is_running) {
+    int client_fd = accept4(this->listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client_fd < 0) {
+      if (!this->is_running) {
+        return;
+      }
+      continue;
+    }
+    int no_delay = 1;
+    setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &no_delay,
+               sizeof(no_delay));
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->client_fds.push_back(client_fd);
+    this->client_threads.emplace_back(&StandInServer::ServeConnection, this,
+                                      client_fd);
+  }
+}
+
+void StandInServer::ServeConnection(int client_fd) {
+  std::vector<char> buffer;
+  std::string query;
+  std::int64_t request_id;
+  if (Handshake(client_fd)) {
+    while (true) {
+      char header[ipc_decoder::message_header_size];
+      if (!ReadAll(client_fd, header, sizeof(header))) {
+        break;
+      }
+      std::uint32_t message_size;
+      std::memcpy(&message_size, header + 4, sizeof(message_size));
+      if (message_size < sizeof(header)) {
+        break;
+      }
+      buffer.resize(message_size);
+      std::memcpy(buffer.data(), header, sizeof(header));
+      if (!ReadAll(client_fd, buffer.data() + sizeof(header),
+                   message_size - sizeof(header))) {
+        break;
+      }
+      if (header[1] != 1) {
+        // Of the asynchronous messages, only queries sent with reply are
+        // answered.
+        if (header[1] != async_message_type ||
+            !GetQueryWithReply(buffer.data(), buffer.size(), &request_id,
+                               &query)) {
+          continue;
+        }
+        this->number_of_queries.fetch_add(1, std::memory_order_relaxed);
+        std::shared_ptr<const std::vector<char>> reply =
+            this->FindReply(query);
+        if (!this->SendReply(
+                client_fd,
+                BuildQueryWithReplyMessage(
+                    request_id, reply != nullptr
+                                    ? *reply
+                                    : BuildErrorMessage("unknown query")),
+                async_message_type)) {
+          break;
+        }
+        continue;
+      }
+      this->number_of_queries.fetch_add(1, std::memory_order_relaxed);
+      std::shared_ptr<const std::vector<char>> reply;
+      if (GetQueryText(buffer.data(), buffer.size(), &query)) {
+        reply = this->FindReply(query);
+      }
+      bool is_sent =
+          reply != nullptr
+              ? this->SendReply(client_fd, *reply, response_message_type)
+              : this->SendReply(client_fd, BuildErrorMessage("unknown query"),
+                                response_message_type);
+      if (!is_sent) {
+        break;
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->client_fds.erase(
+      std::find(this->client_fds.begin(), this->client_fds.end(), client_fd));
+  close(client_fd);
+}
+
+std::shared_ptr<const std::vector<char>> StandInServer::FindReply(
+    const std::string& query) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  auto found = this->replies.find(query);
+  return found == this->replies.end() ? nullptr : found->second;
+}
+
+bool StandInServer::SendReply(int client_fd, const std::vector<char>& message,
+                              char message_type) {
+  if (message.size() < ipc_decoder::message_header_size) {
+    return false;
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::chrono::microseconds latency(
+      this->latency_in_microseconds.load(std::memory_order_relaxed));
+  if (latency.count() > 0) {
+    std::this_thread::sleep_for(latency);
+    start += latency;
+  }
+
+  // The registered message is shared, so the message type is patched on a
+  // copy of the header.
+  char header[ipc_decoder::message_header_size];
+  std::memcpy(header, message.data(), sizeof(header));
+  header[1] = message_type;
+  if (!WriteAll(client_fd, header, sizeof(header))) {
+    return false;
+  }
+  const char* body = message.data() + sizeof(header);
+  std::size_t body_size = message.size() - sizeof(header);
+  if (this->options.bytes_per_second == 0) {
+    return WriteAll(client_fd, body, body_size);
+  }
+
+  std::size_t number_of_sent = sizeof(header);
+  while (body_size > 0) {
+    std::size_t chunk_size = std::min(body_size, throttle_chunk_size);
+    if (!WriteAll(client_fd, body, chunk_size)) {
+      return false;
+    }
+    body += chunk_size;
+    body_size -= chunk_size;
+    number_of_sent += chunk_size;
+    // Wait until the bytes sent so far are due.
+    std::this_thread::sleep_until(
+        start + std::chrono::microseconds(static_cast<std::int64_t>(
+                    number_of_sent * 1000000.0 /
+                    this->options.bytes_per_second)));
+  }
+  return true;
+}
+}  // namespace cpp2kdb::stand_in_server
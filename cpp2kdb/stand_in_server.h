@@ -0,0 +1,142 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_STAND_IN_SERVER_H__
+#define CPP2KDB_STAND_IN_SERVER_H__
+/// \file cpp2kdb/stand_in_server.h
+/// In-process server speaking the kdb IPC protocol with canned replies.
+///
+/// The server accepts connections from kdb_wrapper::OpenConnection on
+/// loopback, and answers each synchronous query, and each query sent by
+/// async_query::SendQueryWithReply, with the IPC message registered for the
+/// query text, so tests and benchmarks can run without a q process or a
+/// license. Latency and bandwidth can be set to reproduce a remote server.
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/// Stand-in for a q server, for tests and benchmarks.
+namespace cpp2kdb::stand_in_server {
+/// Options of StandInServer.
+struct ServerOptions {
+  /// Port to listen on. 0 picks a free port, see StandInServer::GetPort.
+  int port = 0;
+  /// Time to wait before sending each reply, see StandInServer::SetLatency.
+  std::chrono::microseconds latency{0};
+  /// Bytes per second the replies are sent at. 0 is unlimited.
+  std::size_t bytes_per_second = 0;
+};
+
+/// Server replying to registered queries with canned IPC messages.
+///
+/// Each connection is served by its own thread. Synchronous queries, which
+/// are sent by kdb_wrapper::RunQueryOnConnection, are matched by their text;
+/// for a query with arguments only the text is matched and the arguments are
+/// ignored. Queries not registered get an error reply. Asynchronous messages
+/// sent by async_query::SendQueryWithReply, which are (function; request id;
+/// query text), are answered the way the function does on a q server: the
+/// query text is matched the same way, and (request id; 1b; result), or
+/// (request id; 0b; error message) for an error reply, is sent back as an
+/// asynchronous message. Other asynchronous messages are read and dropped.
+///
+/// Compression is never used, and messages larger than 2GB are not supported.
+class StandInServer {
+ public:
+  /// Create a server. Nothing is listened on until Start is called.
+  explicit StandInServer(ServerOptions options = ServerOptions());
+  /// Copy constructor is deleted.
+  StandInServer(const StandInServer&) = delete;
+  /// assignment operator is deleted.
+  StandInServer& operator=(const StandInServer&) = delete;
+
+  /// Destructor, stopping the server.
+  ~StandInServer();
+
+  /// Listen on 127.0.0.1 and start accepting connections.
+  /// \returns false if the port cannot be listened on.
+  bool Start();
+
+  /// Close the listening socket and all the connections, and join the threads.
+  void Stop();
+
+  /// Get the port listened on, which is useful when the port in the options is
+  /// 0.
+  int GetPort() const;
+
+  /// Register the reply to a query.
+  ///
+  /// message is a whole IPC message with the header, such as the bytes of the
+  /// byte vector returned by kdb_wrapper::Serialize. The message type in the
+  /// header is set to response when it is sent. Registering the same query
+  /// again replaces the reply, and can be done while the server is running.
+  void RegisterReply(
+      /// Query text.
+      std::string query,
+      /// IPC message.
+      std::vector<char> message);
+
+  /// Register a K object as the reply to a query.
+  ///
+  /// x is serialized with kdb_wrapper::Serialize, and the reference to x is
+  /// not taken.
+  /// \returns false if x cannot be serialized.
+  bool RegisterKObjectReply(
+      /// Query text.
+      std::string query,
+      /// Reply.
+      void* x);
+
+  /// Register an error as the reply to a query, like a query signalling
+  /// 'message on the server.
+  void RegisterErrorReply(
+      /// Query text.
+      std::string query,
+      /// Error message.
+      const std::string& message);
+
+  /// Set the time to wait before sending each reply. It can be changed while
+  /// the server is running, such as to stall one of several replicas, and
+  /// applies to the replies not yet waited for.
+  void SetLatency(std::chrono::microseconds latency);
+
+  /// Get the number of queries received, synchronous or sent with reply.
+  std::uint64_t GetNumberOfQueries() const;
+
+ private:
+  /// Accept connections until stopped.
+  void AcceptLoop();
+  /// Serve one connection until it is closed.
+  void ServeConnection(int client_fd);
+  /// Find the reply of a query.
+  std::shared_ptr<const std::vector<char>> FindReply(const std::string& query);
+  /// Send a reply as message_type, following the latency and bandwidth.
+  bool SendReply(int client_fd, const std::vector<char>& message,
+                 char message_type);
+
+  ServerOptions options;
+  int listen_fd;
+  int port;
+  /// Latency, which can be changed while the server is running.
+  std::atomic<std::int64_t> latency_in_microseconds;
+  std::atomic<bool> is_running{false};
+  std::atomic<std::uint64_t> number_of_queries{0};
+  std::thread accept_thread;
+
+  /// Protects replies, client_fds and client_threads.
+  std::mutex mutex;
+  std::unordered_map<std::string, std::shared_ptr<const std::vector<char>>>
+      replies;
+  std::vector<int> client_fds;
+  std::vector<std::thread> client_threads;
+};
+}  // namespace cpp2kdb::stand_in_server
+#endif  // CPP2KDB_STAND_IN_SERVER_H__
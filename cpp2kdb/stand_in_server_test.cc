@@ -0,0 +1,200 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/stand_in_server.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/async_query.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace {
+/// Build ([] a:til n; b:n#1.5)
+void* MakeTable(std::int64_t number_of_rows) {
+  void* heading = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_symbol_type_id, 2);
+  cpp2kdb::accessors::GetVector<char*>(heading)[0] =
+      cpp2kdb::kdb_wrapper::InternSymbol("a");
+  cpp2kdb::accessors::GetVector<char*>(heading)[1] =
+      cpp2kdb::kdb_wrapper::InternSymbol("b");
+
+  void* columns =
+      cpp2kdb::kdb_wrapper::CreateVector(cpp2kdb::q_types::q_mixed_type_id, 2);
+  void** column_list = cpp2kdb::accessors::GetVector<void*>(columns);
+  column_list[0] = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_long_type_id, number_of_rows);
+  column_list[1] = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_float_type_id, number_of_rows);
+  for (std::int64_t i = 0; i < number_of_rows; i++) {
+    cpp2kdb::accessors::GetVector<std::int64_t>(column_list[0])[i] = i;
+    cpp2kdb::accessors::GetVector<double>(column_list[1])[i] = 1.5;
+  }
+  return cpp2kdb::kdb_wrapper::CreateTable(
+      cpp2kdb::kdb_wrapper::CreateDict(heading, columns));
+}
+
+/// Build `a`b`c
+void* MakeSymbols() {
+  void* symbols = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_symbol_type_id, 3);
+  const char* names[] = {"a", "b", "c"};
+  for (int i = 0; i < 3; i++) {
+    cpp2kdb::accessors::GetVector<char*>(symbols)[i] =
+        cpp2kdb::kdb_wrapper::InternSymbol(names[i]);
+  }
+  return symbols;
+}
+
+/// Build (1;"two")
+void* MakeMixedList() {
+  void* list =
+      cpp2kdb::kdb_wrapper::CreateVector(cpp2kdb::q_types::q_mixed_type_id, 2);
+  cpp2kdb::accessors::GetVector<void*>(list)[0] =
+      cpp2kdb::kdb_wrapper::CreateLong(1);
+  cpp2kdb::accessors::GetVector<void*>(list)[1] =
+      cpp2kdb::kdb_wrapper::CreateCharVector("two");
+  return list;
+}
+
+void Register(cpp2kdb::stand_in_server::StandInServer* server) {
+  void* table = MakeTable(1000000);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard table_guard(table);
+  server->RegisterKObjectReply("select from trade", table);
+  void* symbols = MakeSymbols();
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard symbols_guard(symbols);
+  server->RegisterKObjectReply("exec distinct sym from trade", symbols);
+  void* list = MakeMixedList();
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard list_guard(list);
+  server->RegisterKObjectReply("{x}", list);
+  server->RegisterErrorReply("1+`a", "type");
+}
+
+void TestReplies(int connection) {
+  void* table = cpp2kdb::kdb_wrapper::RunQueryOnConnection(
+      connection, "select from trade");
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard table_guard(table);
+  void* column_heading;
+  void** columns;
+  std::size_t number_of_columns, number_of_rows;
+  std::cout << "Table: "
+            << cpp2kdb::accessors::GetSimpleTable(table, &column_heading,
+                                                  &columns, &number_of_columns,
+                                                  &number_of_rows)
+            << ", " << number_of_columns << " columns and " << number_of_rows
+            << " rows" << std::endl;
+
+  void* symbols = cpp2kdb::kdb_wrapper::RunQueryOnConnection(
+      connection, "exec distinct sym from trade");
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard symbols_guard(symbols);
+  std::vector<std::string> symbol_list(
+      cpp2kdb::kdb_wrapper::GetNumberOfVectorElements(symbols));
+  cpp2kdb::accessors::RetrieveVectorData(symbols, symbol_list.data());
+  std::cout << "Symbols:";
+  for (const std::string& symbol : symbol_list) {
+    std::cout << " " << symbol;
+  }
+  std::cout << std::endl;
+
+  // Arguments are ignored when matching.
+  void* list = cpp2kdb::kdb_wrapper::RunQueryOnConnection(
+      connection, "{x}", cpp2kdb::kdb_wrapper::CreateLong(42));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard list_guard(list);
+  std::cout << "Mixed list with " << (list == nullptr ? 0 : 1) << " reply, "
+            << cpp2kdb::kdb_wrapper::GetNumberOfVectorElements(list)
+            << " elements" << std::endl;
+
+  void* error =
+      cpp2kdb::kdb_wrapper::RunQueryOnConnection(connection, "1+`a");
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard error_guard(error);
+  std::cout << "Error registered: "
+            << *static_cast<char**>(cpp2kdb::kdb_wrapper::GetValue(error))
+            << std::endl;
+
+  void* unknown = cpp2kdb::kdb_wrapper::RunQueryOnConnection(
+      connection, "not registered");
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard unknown_guard(unknown);
+  std::cout << "Query not registered is error? "
+            << (cpp2kdb::accessors::IsError(unknown) ? "Yes" : "No")
+            << std::endl;
+}
+
+void TestQueryWithReply(int connection) {
+  for (const char* query : {"exec distinct sym from trade", "1+`a"}) {
+    std::int64_t request_id = 0;
+    void* result = nullptr;
+    bool is_unpacked =
+        cpp2kdb::async_query::SendQueryWithReply(connection, 7, query) &&
+        cpp2kdb::async_query::UnpackReply(
+            cpp2kdb::kdb_wrapper::ReadMessageFromConnection(connection),
+            &request_id, &result);
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(result);
+    std::cout << query << " with reply: " << (is_unpacked ? "Yes" : "No")
+              << ", request id " << request_id << ", is error? "
+              << (cpp2kdb::accessors::IsError(result) ? "Yes" : "No")
+              << std::endl;
+  }
+}
+
+void TestLatencyAndBandwidth() {
+  cpp2kdb::stand_in_server::ServerOptions options;
+  options.latency = std::chrono::milliseconds(50);
+  options.bytes_per_second = 100 << 20;
+  cpp2kdb::stand_in_server::StandInServer server(options);
+  if (!server.Start()) {
+    std::cout << "Cannot start server" << std::endl;
+    return;
+  }
+  Register(&server);
+  int connection = cpp2kdb::kdb_wrapper::OpenConnection(
+      "127.0.0.1", server.GetPort(), "");
+
+  // The table is about 16MB, so it takes about 160ms at 100MB/s.
+  for (const char* query : {"exec distinct sym from trade",
+                            "select from trade"}) {
+    auto start = std::chrono::steady_clock::now();
+    void* result =
+        cpp2kdb::kdb_wrapper::RunQueryOnConnection(connection, query);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(result);
+    std::cout << query << " took "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)
+                     .count()
+              << "ms" << std::endl;
+  }
+  cpp2kdb::kdb_wrapper::CloseConnection(connection);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  cpp2kdb::stand_in_server::StandInServer server;
+  if (!server.Start()) {
+    std::cerr << "Cannot start server" << std::endl;
+    return 1;
+  }
+  Register(&server);
+  std::cout << "Listening on port " << server.GetPort() << std::endl;
+
+  int connection = cpp2kdb::kdb_wrapper::OpenConnection(
+      "127.0.0.1", server.GetPort(), "");
+  if (connection <= 0) {
+    std::cerr << "Connection error: " << connection << std::endl;
+    return 1;
+  }
+
+  TestReplies(connection);
+  TestQueryWithReply(connection);
+  std::cout << "Number of queries received: " << server.GetNumberOfQueries()
+            << std::endl;
+  std::cout << "----------------------" << std::endl;
+  TestLatencyAndBandwidth();
+
+  cpp2kdb::kdb_wrapper::CloseConnection(connection);
+  server.Stop();
+  return 0;
+}
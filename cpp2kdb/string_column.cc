@@ -0,0 +1,70 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/string_column.h"
+
+#include <cstring>
+
+#include "cpp2kdb/kdb_wrapper.h"
+#include "cpp2kdb/q_types.h"
+
+namespace cpp2kdb::string_column {
+namespace {
+/// Append the symbols of a symbol vector.
+void AppendSymbols(void* input_vector, StringColumn* column) {
+  char** symbols = accessors::GetVector<char*>(input_vector);
+  std::size_t number_of_elements =
+      kdb_wrapper::GetNumberOfVectorElements(input_vector);
+  for (std::size_t i = 0; i < number_of_elements; i++) {
+    column->data.insert(column->data.end(), symbols[i],
+                        symbols[i] + std::strlen(symbols[i]));
+    column->offsets.push_back(column->data.size());
+  }
+}
+
+/// Append the char vectors of a mixed list.
+accessors::DataRetrievalResult AppendCharVectors(void* input_vector,
+                                                 StringColumn* column) {
+  void** char_vectors = accessors::GetVector<void*>(input_vector);
+  std::size_t number_of_elements =
+      kdb_wrapper::GetNumberOfVectorElements(input_vector);
+  for (std::size_t i = 0; i < number_of_elements; i++) {
+    void* char_vector = char_vectors[i];
+    if (kdb_wrapper::GetQTypeId(char_vector) != q_types::q_char_type_id) {
+      return accessors::DataRetrievalResult::NotCharVectorInMixedVector;
+    }
+    const char* chars = accessors::GetVector<char>(char_vector);
+    column->data.insert(
+        column->data.end(), chars,
+        chars + kdb_wrapper::GetNumberOfVectorElements(char_vector));
+    column->offsets.push_back(column->data.size());
+  }
+  return accessors::DataRetrievalResult::Ok;
+}
+}  // namespace
+
+accessors::DataRetrievalResult RetrieveStringColumn(void* input_vector,
+                                                    StringColumn* column) {
+  kdb_wrapper::CallHooksGuard hooks_guard(kdb_wrapper::CallKind::Conversion,
+                                          "RetrieveStringColumn", 0, nullptr,
+                                          input_vector);
+  accessors::DataRetrievalResult check_result =
+      accessors::CheckVectorForVectorDataRetrieval(input_vector);
+  if (check_result != accessors::DataRetrievalResult::Ok) {
+    return check_result;
+  }
+  column->clear();
+  column->offsets.reserve(
+      kdb_wrapper::GetNumberOfVectorElements(input_vector) + 1);
+  int q_type_id = kdb_wrapper::GetQTypeId(input_vector);
+  if (q_types::IsQTypeIdMixedVector(q_type_id)) {
+    return AppendCharVectors(input_vector, column);
+  } else if (q_type_id == q_types::q_symbol_type_id) {
+    AppendSymbols(input_vector, column);
+    return accessors::DataRetrievalResult::Ok;
+  } else {
+    return accessors::DataRetrievalResult::NotStringVector;
+  }
+}
+}  // namespace cpp2kdb::string_column
@@ -0,0 +1,60 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_STRING_COLUMN_H__
+#define CPP2KDB_STRING_COLUMN_H__
+/// \file cpp2kdb/string_column.h
+/// Columns of strings kept in one contiguous buffer.
+///
+/// RetrieveVectorData into std::string allocates once per row. A StringColumn
+/// instead appends all the chars to one buffer, and keeps where each string
+/// starts, as Arrow does for its large string arrays.
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+
+/// Columns of strings in one buffer.
+namespace cpp2kdb::string_column {
+/// Strings kept in one buffer.
+///
+/// String i is chars [offsets[i], offsets[i + 1]) of data, so offsets has one
+/// more element than the number of strings and starts with 0. Strings are not
+/// \0 terminated.
+struct StringColumn {
+  /// Chars of all the strings, one after another.
+  std::vector<char> data;
+  /// Start of each string in data, and the size of data at the end.
+  std::vector<std::int64_t> offsets = {0};
+
+  /// Get the number of strings.
+  std::size_t size() const { return this->offsets.size() - 1; }
+  /// Get string i, which is not checked.
+  std::string_view operator[](std::size_t i) const {
+    return std::string_view(this->data.data() + this->offsets[i],
+                            this->offsets[i + 1] - this->offsets[i]);
+  }
+  /// Remove all the strings, keeping the memory.
+  void clear() {
+    this->data.clear();
+    this->offsets.assign(1, 0);
+  }
+};
+
+/// Retrieve a symbol vector, or a mixed list of char vectors, into a
+/// StringColumn in one pass.
+///
+/// The column is cleared first, and the memory it holds is reused.
+/// \returns Same as RetrieveVectorData into std::string. The column is
+///          undefined when the result is not Ok.
+accessors::DataRetrievalResult RetrieveStringColumn(
+    /// [in] input vector.
+    void* input_vector,
+    /// [out] column.
+    StringColumn* column);
+}  // namespace cpp2kdb::string_column
+#endif  // CPP2KDB_STRING_COLUMN_H__
@@ -0,0 +1,89 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/string_column.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+#include "cpp2kdb/synthetic_data.h"
+
+// Vectors are built in process, no connection is needed.
+namespace {
+void TestCharVectors() {
+  cpp2kdb::synthetic_data::TableOptions options;
+  options.number_of_rows = 1000;
+  options.seed = 3;
+  options.with_char_vector_column = true;
+  void* trade = cpp2kdb::synthetic_data::MakeTradeTable(options);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(trade);
+  void* column_heading;
+  void** columns;
+  std::size_t number_of_columns, number_of_rows;
+  cpp2kdb::accessors::GetSimpleTable(trade, &column_heading, &columns,
+                                     &number_of_columns, &number_of_rows);
+  // cond is the last column.
+  void* cond = columns[number_of_columns - 1];
+
+  cpp2kdb::string_column::StringColumn column;
+  std::cout << "Char vectors: "
+            << cpp2kdb::string_column::RetrieveStringColumn(cond, &column)
+            << ", " << column.size() << " strings, " << column.data.size()
+            << " chars" << std::endl;
+  std::vector<std::string> strings(number_of_rows);
+  cpp2kdb::accessors::RetrieveVectorData(cond, strings.data());
+  bool is_same = true;
+  for (std::size_t i = 0; i < number_of_rows; i++) {
+    is_same = is_same && column[i] == strings[i];
+  }
+  std::cout << "Same as std::string? " << (is_same ? "Yes" : "No")
+            << std::endl;
+
+  // sym is the second column, the column is reused.
+  std::cout << "Symbols: "
+            << cpp2kdb::string_column::RetrieveStringColumn(columns[1],
+                                                            &column)
+            << ", " << column.size() << " strings, first " << column[0]
+            << std::endl;
+}
+
+void TestErrors() {
+  cpp2kdb::string_column::StringColumn column;
+  void* list = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_mixed_type_id, 2);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard list_guard(list);
+  cpp2kdb::accessors::GetVector<void*>(list)[0] =
+      cpp2kdb::kdb_wrapper::CreateCharVector("one");
+  cpp2kdb::accessors::GetVector<void*>(list)[1] =
+      cpp2kdb::kdb_wrapper::CreateLong(2);
+  std::cout << "Mixed list with a long: "
+            << cpp2kdb::string_column::RetrieveStringColumn(list, &column)
+            << std::endl;
+
+  void* longs = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_long_type_id, 2);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard longs_guard(longs);
+  std::cout << "Long vector: "
+            << cpp2kdb::string_column::RetrieveStringColumn(longs, &column)
+            << std::endl;
+
+  void* empty = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_mixed_type_id, 0);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard empty_guard(empty);
+  std::cout << "Empty list: "
+            << cpp2kdb::string_column::RetrieveStringColumn(empty, &column)
+            << ", " << column.size() << " strings" << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  TestCharVectors();
+  std::cout << "----------------------" << std::endl;
+  TestErrors();
+  return 0;
+}
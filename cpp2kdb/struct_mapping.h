@@ -0,0 +1,314 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_STRUCT_MAPPING_H__
+#define CPP2KDB_STRUCT_MAPPING_H__
+/// \file cpp2kdb/struct_mapping.h
+/// Decoding of simple tables into C++ structs, mapped at compile time.
+///
+/// The fields of a struct are mapped to the columns of a table with MakeField.
+/// StructDecoder looks up and checks the columns once per table, then fills
+/// a std::vector of the struct, or a std::vector per field, one column at a
+/// time. The type of each field is known at compile time, so the loops over
+/// the rows have no switch on the q type id.
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+#include "cpp2kdb/q_types.h"
+#include "cpp2kdb/table.h"
+
+/// Mapping of structs to tables.
+namespace cpp2kdb::struct_mapping {
+/// Q type id of the fields mapped to any column q_types::IsSameType accepts.
+constexpr const int any_q_type_id = -1;
+
+/// Check if T is a string field, filled from symbols or char vectors.
+template <typename T>
+constexpr bool IsStringField =
+    std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>;
+
+/// Field of a struct Row mapped to a column.
+/// \tparam NQTypeId q type id of the column, or any_q_type_id.
+template <typename Row, typename T, int NQTypeId>
+struct Field {
+  /// Struct of the field.
+  using RowType = Row;
+  /// Type of the field.
+  using ValueType = T;
+  /// Q type id of the column, or any_q_type_id.
+  constexpr static const int q_type_id = NQTypeId;
+
+  /// Column name.
+  const char* name;
+  /// Pointer to the field.
+  T Row::*member;
+};
+
+/// Map a field to a column.
+///
+/// Arithmetic fields and QGuid are mapped to the columns q_types::IsSameType
+/// accepts, such as std::int64_t to long, timestamp and timespan, unless
+/// NQTypeId is given, in which case the field must be
+/// q_types::CTypeForQTypeId<NQTypeId> and the column of that type.
+/// std::string and std::string_view fields are mapped to symbols and mixed
+/// lists of char vectors. std::string_view points into the K object, and is
+/// only valid as long as the table is, except for symbols, which are interned.
+/// \tparam NQTypeId q type id of the column, or any_q_type_id.
+template <int NQTypeId = any_q_type_id, typename Row, typename T>
+constexpr Field<Row, T, NQTypeId> MakeField(
+    /// Column name, which must outlive the field.
+    const char* name,
+    /// Pointer to the field, such as &Trade::price.
+    T Row::*member) {
+  static_assert(std::is_arithmetic_v<T> ||
+                    std::is_same_v<T, q_types::QGuid> || IsStringField<T>,
+                "Fields must be arithmetic, QGuid, std::string or "
+                "std::string_view");
+  if constexpr (NQTypeId != any_q_type_id) {
+    static_assert(
+        std::is_same_v<T, q_types::CTypeForQTypeId<NQTypeId>> ||
+            (std::is_same_v<T, std::string_view> &&
+             std::is_same_v<std::string, q_types::CTypeForQTypeId<NQTypeId>>),
+        "Field type must be the C type of the q type id");
+  }
+  return Field<Row, T, NQTypeId>{name, member};
+}
+
+namespace internal {
+/// Check if a column can be read into the field.
+template <typename FieldType>
+accessors::DataRetrievalResult CheckColumn(void* column) {
+  using T = typename FieldType::ValueType;
+  int q_type_id = kdb_wrapper::GetQTypeId(column);
+  if constexpr (FieldType::q_type_id != any_q_type_id) {
+    if (q_type_id != FieldType::q_type_id) {
+      return accessors::DataRetrievalResult::InvalidQTypeId;
+    }
+  }
+  if constexpr (IsStringField<T>) {
+    if (q_type_id != q_types::q_symbol_type_id &&
+        !q_types::IsQTypeIdMixedVector(q_type_id)) {
+      return accessors::DataRetrievalResult::NotStringVector;
+    }
+  } else {
+    if (q_types::IsQTypeIdMixedVector(q_type_id) ||
+        q_type_id == q_types::q_symbol_type_id) {
+      return accessors::DataRetrievalResult::NotNumericalVector;
+    }
+    if (!q_types::IsSameType<T>(q_type_id)) {
+      if constexpr (std::is_same_v<T, q_types::QGuid>) {
+        return accessors::DataRetrievalResult::NotGuidVector;
+      } else {
+        return accessors::DataRetrievalResult::InvalidQTypeId;
+      }
+    }
+  }
+  return accessors::DataRetrievalResult::Ok;
+}
+
+/// Read a column checked by CheckColumn, calling set(i, value) for each row.
+///
+/// Only string columns depend on the q type id, which is checked once for
+/// the column.
+/// \returns NotCharVectorInMixedVector if a mixed list has an element that is
+///          not a char vector.
+template <typename T, typename Setter>
+accessors::DataRetrievalResult ReadColumn(void* column,
+                                          std::size_t number_of_rows,
+                                          Setter set) {
+  if constexpr (IsStringField<T>) {
+    if (kdb_wrapper::GetQTypeId(column) == q_types::q_symbol_type_id) {
+      char** symbols = accessors::GetVector<char*>(column);
+      for (std::size_t i = 0; i < number_of_rows; i++) {
+        set(i, T(symbols[i]));
+      }
+    } else {
+      void** char_vectors = accessors::GetVector<void*>(column);
+      for (std::size_t i = 0; i < number_of_rows; i++) {
+        if (kdb_wrapper::GetQTypeId(char_vectors[i]) !=
+            q_types::q_char_type_id) {
+          return accessors::DataRetrievalResult::NotCharVectorInMixedVector;
+        }
+        set(i, T(accessors::GetVector<char>(char_vectors[i]),
+                 kdb_wrapper::GetNumberOfVectorElements(char_vectors[i])));
+      }
+    }
+  } else {
+    const T* data = accessors::GetVector<T>(column);
+    for (std::size_t i = 0; i < number_of_rows; i++) {
+      set(i, data[i]);
+    }
+  }
+  return accessors::DataRetrievalResult::Ok;
+}
+}  // namespace internal
+
+/// Decoder of simple tables into the struct of the fields.
+///
+/// \tparam Fields Field of the same struct, see MakeField.
+template <typename... Fields>
+class StructDecoder {
+ public:
+  static_assert(sizeof...(Fields) > 0, "StructDecoder needs a field");
+  /// Struct of the fields.
+  using Row =
+      typename std::tuple_element_t<0, std::tuple<Fields...>>::RowType;
+  static_assert((std::is_same_v<Row, typename Fields::RowType> && ...),
+                "Fields must be of the same struct");
+  /// Struct of arrays, with one std::vector per field, in the order given.
+  using Columns = std::tuple<std::vector<typename Fields::ValueType>...>;
+
+  /// Create StructDecoder.
+  constexpr explicit StructDecoder(Fields... fields) : fields(fields...) {
+    // do nothing here
+  }
+
+  /// Decode the rows of a table into rows, resized to the number of rows.
+  /// \returns ColumnNotFound if a field has no column, the result of the
+  ///          check of the first column not matching its field otherwise,
+  ///          see MakeField. rows are undefined when the result is not Ok.
+  accessors::DataRetrievalResult Decode(
+      /// [in] table.
+      const table::Table& table,
+      /// [out] rows.
+      std::vector<Row>* rows) const {
+    std::array<void*, sizeof...(Fields)> columns;
+    accessors::DataRetrievalResult result = this->FindColumns(
+        table, &columns, std::index_sequence_for<Fields...>());
+    if (result != accessors::DataRetrievalResult::Ok) {
+      return result;
+    }
+    rows->resize(table.GetNumberOfRows());
+    return this->ReadRows(columns, rows->data(), rows->size(),
+                          std::index_sequence_for<Fields...>());
+  }
+
+  /// Decode the columns of a table into one std::vector per field, resized to
+  /// the number of rows.
+  /// \returns Same as decoding into rows.
+  accessors::DataRetrievalResult Decode(
+      /// [in] table.
+      const table::Table& table,
+      /// [out] columns.
+      Columns* output) const {
+    std::array<void*, sizeof...(Fields)> columns;
+    accessors::DataRetrievalResult result = this->FindColumns(
+        table, &columns, std::index_sequence_for<Fields...>());
+    if (result != accessors::DataRetrievalResult::Ok) {
+      return result;
+    }
+    return this->ReadColumns(columns, table.GetNumberOfRows(), output,
+                             std::index_sequence_for<Fields...>());
+  }
+
+ private:
+  /// Look up and check the columns of the fields.
+  template <std::size_t... I>
+  accessors::DataRetrievalResult FindColumns(
+      const table::Table& table, std::array<void*, sizeof...(Fields)>* columns,
+      std::index_sequence<I...>) const {
+    accessors::DataRetrievalResult result = accessors::DataRetrievalResult::Ok;
+    // Stops at the first result that is not Ok.
+    static_cast<void>(
+        (((result = FindColumn(table, std::get<I>(this->fields),
+                               &(*columns)[I])) ==
+          accessors::DataRetrievalResult::Ok) &&
+         ...));
+    return result;
+  }
+
+  template <typename FieldType>
+  static accessors::DataRetrievalResult FindColumn(const table::Table& table,
+                                                   const FieldType& field,
+                                                   void** column) {
+    std::size_t index;
+    accessors::DataRetrievalResult result =
+        table.GetColumnIndex(field.name, &index);
+    if (result != accessors::DataRetrievalResult::Ok) {
+      return result;
+    }
+    *column = table.GetColumnObject(index);
+    return internal::CheckColumn<FieldType>(*column);
+  }
+
+  /// Fill the rows one field at a time.
+  template <std::size_t... I>
+  accessors::DataRetrievalResult ReadRows(
+      const std::array<void*, sizeof...(Fields)>& columns, Row* rows,
+      std::size_t number_of_rows, std::index_sequence<I...>) const {
+    accessors::DataRetrievalResult result = accessors::DataRetrievalResult::Ok;
+    // Stops at the first result that is not Ok.
+    static_cast<void>(
+        (((result = ReadRowField(std::get<I>(this->fields), columns[I], rows,
+                                 number_of_rows)) ==
+          accessors::DataRetrievalResult::Ok) &&
+         ...));
+    return result;
+  }
+
+  template <typename FieldType>
+  static accessors::DataRetrievalResult ReadRowField(
+      const FieldType& field, void* column, Row* rows,
+      std::size_t number_of_rows) {
+    using T = typename FieldType::ValueType;
+    T Row::*member = field.member;
+    return internal::ReadColumn<T>(
+        column, number_of_rows,
+        [rows, member](std::size_t i, T value) {
+          rows[i].*member = std::move(value);
+        });
+  }
+
+  /// Fill the std::vector of each field.
+  template <std::size_t... I>
+  accessors::DataRetrievalResult ReadColumns(
+      const std::array<void*, sizeof...(Fields)>& columns,
+      std::size_t number_of_rows, Columns* output,
+      std::index_sequence<I...>) const {
+    accessors::DataRetrievalResult result = accessors::DataRetrievalResult::Ok;
+    // Stops at the first result that is not Ok.
+    static_cast<void>(
+        (((result = ReadColumnField(columns[I], number_of_rows,
+                                    &std::get<I>(*output))) ==
+          accessors::DataRetrievalResult::Ok) &&
+         ...));
+    return result;
+  }
+
+  template <typename T>
+  static accessors::DataRetrievalResult ReadColumnField(
+      void* column, std::size_t number_of_rows, std::vector<T>* output) {
+    if constexpr (IsStringField<T>) {
+      output->resize(number_of_rows);
+      T* data = output->data();
+      return internal::ReadColumn<T>(
+          column, number_of_rows,
+          [data](std::size_t i, T value) { data[i] = std::move(value); });
+    } else {
+      // Same layout, which is a copy of the buffer.
+      const T* data = accessors::GetVector<T>(column);
+      output->assign(data, data + number_of_rows);
+      return accessors::DataRetrievalResult::Ok;
+    }
+  }
+
+  std::tuple<Fields...> fields;
+};
+
+/// Create a StructDecoder, deducing the fields.
+template <typename... Fields>
+constexpr StructDecoder<Fields...> MakeStructDecoder(Fields... fields) {
+  return StructDecoder<Fields...>(fields...);
+}
+}  // namespace cpp2kdb::struct_mapping
+#endif  // CPP2KDB_STRUCT_MAPPING_H__
@@ -0,0 +1,115 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/struct_mapping.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+#include "cpp2kdb/synthetic_data.h"
+#include "cpp2kdb/table.h"
+
+// Tables are built in process, no connection is needed.
+namespace {
+struct Trade {
+  std::int64_t time;
+  std::string_view sym;
+  double price;
+  std::int64_t size;
+  std::string cond;
+};
+
+constexpr auto trade_decoder = cpp2kdb::struct_mapping::MakeStructDecoder(
+    cpp2kdb::struct_mapping::MakeField<cpp2kdb::q_types::q_timestamp_type_id>(
+        "time", &Trade::time),
+    cpp2kdb::struct_mapping::MakeField("sym", &Trade::sym),
+    cpp2kdb::struct_mapping::MakeField("price", &Trade::price),
+    cpp2kdb::struct_mapping::MakeField("size", &Trade::size),
+    cpp2kdb::struct_mapping::MakeField("cond", &Trade::cond));
+
+void TestDecode() {
+  cpp2kdb::synthetic_data::TableOptions options;
+  options.number_of_rows = 1000;
+  options.seed = 11;
+  options.with_char_vector_column = true;
+  void* trade = cpp2kdb::synthetic_data::MakeTradeTable(options);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(trade);
+  cpp2kdb::table::Table table;
+  cpp2kdb::table::MakeTable(trade, &table);
+
+  std::vector<Trade> rows;
+  std::cout << "Rows: " << trade_decoder.Decode(table, &rows) << ", "
+            << rows.size() << " rows" << std::endl;
+  decltype(trade_decoder)::Columns columns;
+  std::cout << "Columns: " << trade_decoder.Decode(table, &columns) << ", "
+            << std::get<2>(columns).size() << " rows" << std::endl;
+
+  std::vector<std::int64_t> time;
+  std::vector<std::string> sym, cond;
+  std::vector<double> price;
+  table.GetColumn("time", &time);
+  table.GetColumn("sym", &sym);
+  table.GetColumn("price", &price);
+  table.GetColumn("cond", &cond);
+  bool is_same = true;
+  for (std::size_t i = 0; i < rows.size(); i++) {
+    is_same = is_same && rows[i].time == time[i] && rows[i].sym == sym[i] &&
+              rows[i].price == price[i] && rows[i].cond == cond[i] &&
+              std::get<1>(columns)[i] == sym[i] &&
+              std::get<2>(columns)[i] == price[i] &&
+              std::get<4>(columns)[i] == cond[i];
+  }
+  std::cout << "Same as GetColumn? " << (is_same ? "Yes" : "No") << std::endl;
+}
+
+struct Quote {
+  std::int64_t time;
+  std::int64_t bid;
+};
+
+void TestErrors() {
+  cpp2kdb::synthetic_data::TableOptions options;
+  options.number_of_rows = 10;
+  void* trade = cpp2kdb::synthetic_data::MakeTradeTable(options);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(trade);
+  cpp2kdb::table::Table table;
+  cpp2kdb::table::MakeTable(trade, &table);
+  std::vector<Quote> quotes;
+
+  // time is a timestamp, which is not a timespan.
+  auto timespan_decoder = cpp2kdb::struct_mapping::MakeStructDecoder(
+      cpp2kdb::struct_mapping::MakeField<cpp2kdb::q_types::q_timespan_type_id>(
+          "time", &Quote::time));
+  std::cout << "Timestamp as timespan: "
+            << timespan_decoder.Decode(table, &quotes) << std::endl;
+
+  auto price_decoder = cpp2kdb::struct_mapping::MakeStructDecoder(
+      cpp2kdb::struct_mapping::MakeField("price", &Quote::bid));
+  std::cout << "Float as long: " << price_decoder.Decode(table, &quotes)
+            << std::endl;
+
+  auto sym_decoder = cpp2kdb::struct_mapping::MakeStructDecoder(
+      cpp2kdb::struct_mapping::MakeField("sym", &Quote::bid));
+  std::cout << "Symbol as long: " << sym_decoder.Decode(table, &quotes)
+            << std::endl;
+
+  auto bid_decoder = cpp2kdb::struct_mapping::MakeStructDecoder(
+      cpp2kdb::struct_mapping::MakeField("time", &Quote::time),
+      cpp2kdb::struct_mapping::MakeField("bid", &Quote::bid));
+  std::cout << "Missing column: " << bid_decoder.Decode(table, &quotes)
+            << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  TestDecode();
+  std::cout << "----------------------" << std::endl;
+  TestErrors();
+  return 0;
+}
@@ -0,0 +1,107 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/symbol_table.h"
+
+#include "cpp2kdb/kdb_wrapper.h"
+#include "cpp2kdb/q_types.h"
+
+namespace cpp2kdb::symbol_table {
+namespace {
+/// Number of slots of an empty table.
+constexpr std::size_t initial_number_of_slots = 1024;
+
+/// Get the first slot of a symbol. Interned symbols have no alignment to rely
+/// on, so all the bits of the pointer are mixed by a Fibonacci multiply and
+/// the slot is taken from the high half.
+std::size_t GetSlot(const char* symbol, std::size_t mask) {
+  std::uint64_t hash = reinterpret_cast<std::uintptr_t>(symbol);
+  hash *= 0x9E3779B97F4A7C15ULL;
+  return (hash >> 32) & mask;
+}
+}  // namespace
+
+SymbolTable::SymbolTable()
+    : slot_symbols(initial_number_of_slots, nullptr),
+      slot_codes(initial_number_of_slots, 0) {
+  // do nothing here
+}
+
+accessors::DataRetrievalResult SymbolTable::Encode(void* input_vector,
+                                                   std::int32_t* output_codes) {
+  kdb_wrapper::CallHooksGuard hooks_guard(kdb_wrapper::CallKind::Conversion,
+                                          "SymbolTable::Encode", 0, nullptr,
+                                          input_vector);
+  accessors::DataRetrievalResult check_result =
+      accessors::CheckVectorForVectorDataRetrieval(input_vector);
+  if (check_result != accessors::DataRetrievalResult::Ok) {
+    return check_result;
+  }
+  if (kdb_wrapper::GetQTypeId(input_vector) != q_types::q_symbol_type_id) {
+    return accessors::DataRetrievalResult::NotStringVector;
+  }
+
+  const char* const* input_symbols =
+      accessors::GetVector<const char*>(input_vector);
+  std::size_t number_of_elements =
+      kdb_wrapper::GetNumberOfVectorElements(input_vector);
+  // Columns are often sorted or grouped by symbol, so check the last one
+  // before hashing.
+  const char* last_symbol = nullptr;
+  std::int32_t last_code = 0;
+  for (std::size_t i = 0; i < number_of_elements; i++) {
+    const char* symbol = input_symbols[i];
+    if (symbol != last_symbol) {
+      last_symbol = symbol;
+      last_code = this->GetCode(symbol);
+    }
+    output_codes[i] = last_code;
+  }
+  return accessors::DataRetrievalResult::Ok;
+}
+
+std::int32_t SymbolTable::GetCode(const char* symbol) {
+  std::size_t mask = this->slot_symbols.size() - 1;
+  std::size_t slot = GetSlot(symbol, mask);
+  while (this->slot_symbols[slot] != nullptr) {
+    if (this->slot_symbols[slot] == symbol) {
+      return this->slot_codes[slot];
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  std::int32_t code = static_cast<std::int32_t>(this->symbols.size());
+  this->symbols.push_back(symbol);
+  this->slot_symbols[slot] = symbol;
+  this->slot_codes[slot] = code;
+  // Keep the load below 1/2, so probes stay short.
+  if (this->symbols.size() * 2 > this->slot_symbols.size()) {
+    this->Grow();
+  }
+  return code;
+}
+
+std::string_view SymbolTable::GetSymbol(std::int32_t code) const {
+  return std::string_view(this->symbols[code]);
+}
+
+std::size_t SymbolTable::GetNumberOfSymbols() const {
+  return this->symbols.size();
+}
+
+void SymbolTable::Grow() {
+  std::size_t number_of_slots = this->slot_symbols.size() * 2;
+  std::size_t mask = number_of_slots - 1;
+  this->slot_symbols.assign(number_of_slots, nullptr);
+  this->slot_codes.assign(number_of_slots, 0);
+  for (std::size_t code = 0; code < this->symbols.size(); code++) {
+    std::size_t slot = GetSlot(this->symbols[code], mask);
+    while (this->slot_symbols[slot] != nullptr) {
+      slot = (slot + 1) & mask;
+    }
+    this->slot_symbols[slot] = this->symbols[code];
+    this->slot_codes[slot] = static_cast<std::int32_t>(code);
+  }
+}
+}  // namespace cpp2kdb::symbol_table
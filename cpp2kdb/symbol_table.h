@@ -0,0 +1,69 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_SYMBOL_TABLE_H__
+#define CPP2KDB_SYMBOL_TABLE_H__
+/// \file cpp2kdb/symbol_table.h
+/// Dictionary encoding of symbol vectors into dense integer codes.
+///
+/// kdb interns symbols, so equal symbols are the same char*. A symbol vector
+/// can then be encoded by looking up pointers, without reading or copying the
+/// strings. Codes are given in the order the symbols are first seen, and are
+/// shared by all the vectors encoded with the same table.
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+
+/// Dictionary encoding of symbols.
+namespace cpp2kdb::symbol_table {
+/// Table of the symbols seen, mapping each to a code from 0 up.
+///
+/// The table is not thread safe. Symbols must be interned, as all the symbols
+/// in K objects from kdb are, otherwise equal symbols get different codes.
+class SymbolTable {
+ public:
+  /// Create an empty table.
+  SymbolTable();
+  /// Copy constructor is deleted.
+  SymbolTable(const SymbolTable&) = delete;
+  /// assignment operator is deleted.
+  SymbolTable& operator=(const SymbolTable&) = delete;
+
+  /// Encode a symbol vector, adding the symbols not seen before.
+  /// \returns NotVector, NullInput or ValueError as RetrieveVectorData, and
+  ///          NotStringVector if the input is not a symbol vector.
+  accessors::DataRetrievalResult Encode(
+      /// [in] Symbol vector.
+      void* input_vector,
+      /// [out] Codes, which must hold one per element.
+      std::int32_t* output_codes);
+
+  /// Get the code of a symbol, adding it if it is not seen before.
+  std::int32_t GetCode(
+      /// Interned symbol, see kdb_wrapper::InternSymbol.
+      const char* symbol);
+
+  /// Get the symbol of a code, which is not checked.
+  std::string_view GetSymbol(std::int32_t code) const;
+
+  /// Get the number of symbols, which is one more than the largest code.
+  std::size_t GetNumberOfSymbols() const;
+
+ private:
+  /// Double the number of slots and put the symbols back.
+  void Grow();
+
+  /// Open addressing with linear probing, keyed by the pointer. nullptr marks
+  /// an empty slot, since symbols are never nullptr.
+  std::vector<const char*> slot_symbols;
+  std::vector<std::int32_t> slot_codes;
+  /// Symbols by code.
+  std::vector<const char*> symbols;
+};
+}  // namespace cpp2kdb::symbol_table
+#endif  // CPP2KDB_SYMBOL_TABLE_H__
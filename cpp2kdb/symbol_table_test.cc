@@ -0,0 +1,111 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/symbol_table.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+#include "cpp2kdb/synthetic_data.h"
+
+// Vectors are built in process, no connection is needed.
+namespace {
+void TestStringView() {
+  void* symbols = cpp2kdb::synthetic_data::MakeRandomVector(
+      cpp2kdb::q_types::q_symbol_type_id, 1000, 1);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard symbols_guard(symbols);
+  std::vector<std::string> strings(1000);
+  std::vector<std::string_view> views(1000);
+  cpp2kdb::accessors::RetrieveVectorData(symbols, strings.data());
+  std::cout << "Symbols as std::string_view: "
+            << cpp2kdb::accessors::RetrieveVectorData(symbols, views.data())
+            << std::endl;
+  bool is_same = true;
+  for (std::size_t i = 0; i < strings.size(); i++) {
+    is_same = is_same && strings[i] == views[i];
+  }
+  std::cout << "Same as std::string? " << (is_same ? "Yes" : "No")
+            << std::endl;
+
+  void* list = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_mixed_type_id, 2);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard list_guard(list);
+  cpp2kdb::accessors::GetVector<void*>(list)[0] =
+      cpp2kdb::kdb_wrapper::CreateCharVector("hello");
+  cpp2kdb::accessors::GetVector<void*>(list)[1] =
+      cpp2kdb::kdb_wrapper::CreateCharVector("world");
+  std::string_view words[2];
+  std::cout << "Char vectors as std::string_view: "
+            << cpp2kdb::accessors::RetrieveVectorData(list, words) << ", "
+            << words[0] << " " << words[1] << std::endl;
+}
+
+void TestEncode() {
+  cpp2kdb::symbol_table::SymbolTable table;
+  void* first = cpp2kdb::synthetic_data::MakeRandomVector(
+      cpp2kdb::q_types::q_symbol_type_id, 1000, 1);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard first_guard(first);
+  void* second = cpp2kdb::synthetic_data::MakeRandomVector(
+      cpp2kdb::q_types::q_symbol_type_id, 1000, 2);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard second_guard(second);
+
+  std::vector<std::int32_t> first_codes(1000), second_codes(1000);
+  std::cout << "Encode: " << table.Encode(first, first_codes.data()) << ", "
+            << table.Encode(second, second_codes.data()) << ", "
+            << table.GetNumberOfSymbols() << " symbols" << std::endl;
+
+  std::vector<std::string> strings(1000);
+  cpp2kdb::accessors::RetrieveVectorData(second, strings.data());
+  bool is_same = true;
+  for (std::size_t i = 0; i < strings.size(); i++) {
+    is_same = is_same && table.GetSymbol(second_codes[i]) == strings[i];
+  }
+  std::cout << "Codes decode to the symbols? " << (is_same ? "Yes" : "No")
+            << std::endl;
+
+  void* longs = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_long_type_id, 10);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard longs_guard(longs);
+  std::cout << "Encode long vector: "
+            << table.Encode(longs, first_codes.data()) << std::endl;
+}
+
+void TestManySymbols() {
+  // More symbols than the initial slots, so the table grows.
+  std::int64_t number_of_symbols = 5000;
+  void* symbols = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_symbol_type_id, number_of_symbols * 2);
+  char** data = cpp2kdb::accessors::GetVector<char*>(symbols);
+  for (std::int64_t i = 0; i < number_of_symbols * 2; i++) {
+    std::string name = "s" + std::to_string(i % number_of_symbols);
+    data[i] = cpp2kdb::kdb_wrapper::InternSymbol(name.c_str());
+  }
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(symbols);
+  cpp2kdb::symbol_table::SymbolTable table;
+  std::vector<std::int32_t> codes(number_of_symbols * 2);
+  table.Encode(symbols, codes.data());
+  bool is_repeated = true;
+  for (std::int64_t i = 0; i < number_of_symbols; i++) {
+    is_repeated = is_repeated && codes[i] == i &&
+                  codes[i + number_of_symbols] == codes[i];
+  }
+  std::cout << table.GetNumberOfSymbols()
+            << " symbols, codes repeat? " << (is_repeated ? "Yes" : "No")
+            << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  TestStringView();
+  std::cout << "----------------------" << std::endl;
+  TestEncode();
+  std::cout << "----------------------" << std::endl;
+  TestManySymbols();
+  return 0;
+}
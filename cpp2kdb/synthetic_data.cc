@@ -0,0 +1,366 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/synthetic_data.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace cpp2kdb::synthetic_data {
+namespace {
+/// Nanoseconds in a day.
+constexpr std::int64_t nanoseconds_per_day = 86400000000000LL;
+
+/// 09:30, when the timestamps start.
+constexpr std::int64_t market_open = 34200000000000LL;
+
+/// 16:00, when the timestamps end.
+constexpr std::int64_t market_close = 57600000000000LL;
+
+/// Number of symbols MakeRandomVector picks from.
+constexpr std::size_t number_of_random_vector_symbols = 100;
+
+/// splitmix64, which is fast and good enough for test data.
+class Random {
+ public:
+  explicit Random(std::uint64_t seed) : state(seed) {}
+
+  std::uint64_t Next() {
+    std::uint64_t z = (this->state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  /// Uniform in [0, n).
+  std::uint64_t NextBelow(std::uint64_t n) { return this->Next() % n; }
+
+  /// Uniform in [0, 1).
+  double NextDouble() { return (this->Next() >> 11) * 0x1.0p-53; }
+
+ private:
+  std::uint64_t state;
+};
+
+/// Intern number_of_symbols symbols, AAA, AAB, ...
+std::vector<char*> MakeSymbols(std::size_t number_of_symbols) {
+  std::vector<char*> symbols(number_of_symbols);
+  for (std::size_t i = 0; i < number_of_symbols; i++) {
+    std::string name;
+    std::size_t index = i;
+    do {
+      name.insert(name.begin(), static_cast<char>('A' + index % 26));
+      index /= 26;
+    } while (index > 0 || name.size() < 3);
+    symbols[i] = kdb_wrapper::InternSymbol(name.c_str());
+  }
+  return symbols;
+}
+
+/// Create a vector of T with n elements, each set by generate(i).
+template <typename T, typename Generate>
+void* MakeVector(int q_type_id, std::int64_t n, Generate generate) {
+  void* vector = kdb_wrapper::CreateVector(q_type_id, n);
+  T* data = accessors::GetVector<T>(vector);
+  for (std::int64_t i = 0; i < n; i++) {
+    data[i] = generate(i);
+  }
+  return vector;
+}
+
+/// Create a mixed list of n char vectors of 1 to 4 upper case letters.
+void* MakeCharVectorList(std::int64_t n, Random* random) {
+  void* list = kdb_wrapper::CreateVector(q_types::q_mixed_type_id, n);
+  void** data = accessors::GetVector<void*>(list);
+  char text[5];
+  for (std::int64_t i = 0; i < n; i++) {
+    std::uint64_t bits = random->Next();
+    std::size_t length = 1 + bits % 4;
+    for (std::size_t j = 0; j < length; j++) {
+      bits >>= 5;
+      text[j] = static_cast<char>('A' + bits % 26);
+    }
+    text[length] = '\0';
+    data[i] = kdb_wrapper::CreateCharVector(text);
+  }
+  return list;
+}
+
+/// Create the symbol vector of the column names.
+void* MakeColumnHeading(const std::vector<const char*>& names) {
+  void* heading =
+      kdb_wrapper::CreateVector(q_types::q_symbol_type_id, names.size());
+  for (std::size_t i = 0; i < names.size(); i++) {
+    accessors::GetVector<char*>(heading)[i] =
+        kdb_wrapper::InternSymbol(names[i]);
+  }
+  return heading;
+}
+
+/// Create a table from the column names and columns.
+void* MakeTable(const std::vector<const char*>& names,
+                const std::vector<void*>& columns) {
+  void* values =
+      kdb_wrapper::CreateVector(q_types::q_mixed_type_id, columns.size());
+  for (std::size_t i = 0; i < columns.size(); i++) {
+    accessors::GetVector<void*>(values)[i] = columns[i];
+  }
+  return kdb_wrapper::CreateTable(
+      kdb_wrapper::CreateDict(MakeColumnHeading(names), values));
+}
+
+/// Create the increasing timestamps between the open and the close.
+void* MakeTimestamps(const TableOptions& options, Random* random) {
+  std::int64_t start =
+      static_cast<std::int64_t>(options.date) * nanoseconds_per_day +
+      market_open;
+  // Twice the average gap, so the gaps average out to the whole session.
+  std::uint64_t max_gap =
+      2 * (market_close - market_open) / (options.number_of_rows + 1) + 1;
+  std::int64_t time = start;
+  return MakeVector<std::int64_t>(
+      q_types::q_timestamp_type_id, options.number_of_rows,
+      [&](std::int64_t) { return time += random->NextBelow(max_gap); });
+}
+
+/// Get the number of symbols of the trade and quote tables, which is at least
+/// 1, since the symbol of each row is picked from them.
+std::size_t GetNumberOfSymbols(const TableOptions& options) {
+  return std::max<std::size_t>(1, options.number_of_symbols);
+}
+
+/// Create the sym column, and the index of the symbol of each row.
+void* MakeSymColumn(const TableOptions& options,
+                    const std::vector<char*>& symbols,
+                    std::vector<std::uint32_t>* symbol_indices,
+                    Random* random) {
+  symbol_indices->resize(options.number_of_rows);
+  return MakeVector<char*>(
+      q_types::q_symbol_type_id, options.number_of_rows, [&](std::int64_t i) {
+        std::uint32_t index =
+            static_cast<std::uint32_t>(random->NextBelow(symbols.size()));
+        (*symbol_indices)[i] = index;
+        return symbols[index];
+      });
+}
+
+/// Price level of each symbol, between 10 and 1000.
+std::vector<double> MakeBasePrices(std::size_t number_of_symbols,
+                                   Random* random) {
+  std::vector<double> base_prices(number_of_symbols);
+  for (double& price : base_prices) {
+    price = 10 + 990 * random->NextDouble();
+  }
+  return base_prices;
+}
+
+/// Price within 0.5% of the base price, rounded to cents.
+double MakePrice(double base_price, Random* random) {
+  return static_cast<std::int64_t>(
+             base_price * (0.995 + 0.01 * random->NextDouble()) * 100) /
+         100.0;
+}
+
+void* MakeNestedListLevel(std::int64_t number_of_elements, int depth,
+                          Random* random) {
+  void* list =
+      kdb_wrapper::CreateVector(q_types::q_mixed_type_id, number_of_elements);
+  void** data = accessors::GetVector<void*>(list);
+  for (std::int64_t i = 0; i < number_of_elements; i++) {
+    if (depth > 1) {
+      data[i] = MakeNestedListLevel(number_of_elements, depth - 1, random);
+      continue;
+    }
+    std::int64_t length = 1 + random->NextBelow(16);
+    std::uint64_t seed = random->Next();
+    switch (random->NextBelow(5)) {
+      case 0:
+        data[i] = MakeRandomVector(q_types::q_long_type_id, length, seed);
+        break;
+      case 1:
+        data[i] = MakeRandomVector(q_types::q_float_type_id, length, seed);
+        break;
+      case 2:
+        data[i] = MakeRandomVector(q_types::q_char_type_id, length, seed);
+        break;
+      case 3:
+        data[i] = MakeRandomVector(q_types::q_symbol_type_id, length, seed);
+        break;
+      default:
+        data[i] = kdb_wrapper::CreateLong(seed % 1000);
+        break;
+    }
+  }
+  return list;
+}
+}  // namespace
+
+void* MakeRandomVector(int q_type_id, std::int64_t number_of_elements,
+                       std::uint64_t seed) {
+  Random random(seed);
+  auto number = [&random](std::int64_t) { return random.NextBelow(1000); };
+  switch (q_type_id) {
+    case q_types::q_boolean_type_id:
+      return MakeVector<bool>(q_type_id, number_of_elements,
+                              [&](std::int64_t) { return random.Next() & 1; });
+    case q_types::q_guid_type_id:
+      return MakeVector<q_types::QGuid>(
+          q_type_id, number_of_elements, [&](std::int64_t) {
+            q_types::QGuid guid;
+            for (int& value : guid.value) {
+              value = static_cast<int>(random.Next());
+            }
+            return guid;
+          });
+    case q_types::q_byte_type_id:
+      return MakeVector<std::int8_t>(
+          q_type_id, number_of_elements, [&](std::int64_t) {
+            return static_cast<std::int8_t>(random.Next());
+          });
+    case q_types::q_short_type_id:
+      return MakeVector<short>(  // NOLINT
+          q_type_id, number_of_elements, number);
+    case q_types::q_int_type_id:
+    case q_types::q_month_type_id:
+    case q_types::q_date_type_id:
+    case q_types::q_minute_type_id:
+    case q_types::q_second_type_id:
+    case q_types::q_time_type_id:
+      return MakeVector<int>(q_type_id, number_of_elements, number);
+    case q_types::q_long_type_id:
+    case q_types::q_timestamp_type_id:
+    case q_types::q_timespan_type_id:
+      return MakeVector<std::int64_t>(q_type_id, number_of_elements, number);
+    case q_types::q_real_type_id:
+      return MakeVector<float>(
+          q_type_id, number_of_elements, [&](std::int64_t) {
+            return static_cast<float>(1000 * random.NextDouble());
+          });
+    case q_types::q_float_type_id:
+    case q_types::q_datetime_type_id:
+      return MakeVector<double>(
+          q_type_id, number_of_elements,
+          [&](std::int64_t) { return 1000 * random.NextDouble(); });
+    case q_types::q_char_type_id:
+      return MakeVector<char>(
+          q_type_id, number_of_elements, [&](std::int64_t) {
+            return static_cast<char>('a' + random.NextBelow(26));
+          });
+    case q_types::q_symbol_type_id: {
+      std::vector<char*> symbols = MakeSymbols(number_of_random_vector_symbols);
+      return MakeVector<char*>(
+          q_type_id, number_of_elements, [&](std::int64_t) {
+            return symbols[random.NextBelow(symbols.size())];
+          });
+    }
+    default:
+      return nullptr;
+  }
+}
+
+void* MakeTradeTable(const TableOptions& options) {
+  Random random(options.seed);
+  std::size_t number_of_symbols = GetNumberOfSymbols(options);
+  std::vector<char*> symbols = MakeSymbols(number_of_symbols);
+  std::vector<double> base_prices = MakeBasePrices(number_of_symbols, &random);
+  std::vector<std::uint32_t> symbol_indices;
+
+  std::vector<const char*> names = {"time", "sym", "price", "size", "ex"};
+  std::vector<void*> columns;
+  columns.push_back(MakeTimestamps(options, &random));
+  columns.push_back(MakeSymColumn(options, symbols, &symbol_indices, &random));
+  columns.push_back(MakeVector<double>(
+      q_types::q_float_type_id, options.number_of_rows, [&](std::int64_t i) {
+        return MakePrice(base_prices[symbol_indices[i]], &random);
+      }));
+  columns.push_back(MakeVector<std::int64_t>(
+      q_types::q_long_type_id, options.number_of_rows, [&](std::int64_t) {
+        return static_cast<std::int64_t>(1 + random.NextBelow(100)) * 100;
+      }));
+  columns.push_back(MakeVector<char>(
+      q_types::q_char_type_id, options.number_of_rows, [&](std::int64_t) {
+        return static_cast<char>('A' + random.NextBelow(8));
+      }));
+  if (options.with_char_vector_column) {
+    names.push_back("cond");
+    columns.push_back(MakeCharVectorList(options.number_of_rows, &random));
+  }
+  return MakeTable(names, columns);
+}
+
+void* MakeQuoteTable(const TableOptions& options) {
+  Random random(options.seed);
+  std::size_t number_of_symbols = GetNumberOfSymbols(options);
+  std::vector<char*> symbols = MakeSymbols(number_of_symbols);
+  std::vector<double> base_prices = MakeBasePrices(number_of_symbols, &random);
+  std::vector<std::uint32_t> symbol_indices;
+
+  std::vector<const char*> names = {"time", "sym",   "bid", "ask",
+                                    "bsize", "asize", "mode"};
+  std::vector<void*> columns;
+  columns.push_back(MakeTimestamps(options, &random));
+  columns.push_back(MakeSymColumn(options, symbols, &symbol_indices, &random));
+  void* bid = MakeVector<double>(
+      q_types::q_float_type_id, options.number_of_rows, [&](std::int64_t i) {
+        return MakePrice(base_prices[symbol_indices[i]], &random);
+      });
+  const double* bid_data = accessors::GetVector<double>(bid);
+  columns.push_back(bid);
+  columns.push_back(MakeVector<double>(
+      q_types::q_float_type_id, options.number_of_rows, [&](std::int64_t i) {
+        return bid_data[i] + 0.01 * (1 + random.NextBelow(5));
+      }));
+  for (int i = 0; i < 2; i++) {
+    columns.push_back(MakeVector<std::int64_t>(
+        q_types::q_long_type_id, options.number_of_rows, [&](std::int64_t) {
+          return static_cast<std::int64_t>(1 + random.NextBelow(50)) * 100;
+        }));
+  }
+  columns.push_back(MakeVector<char>(
+      q_types::q_char_type_id, options.number_of_rows, [&](std::int64_t) {
+        return static_cast<char>('A' + random.NextBelow(4));
+      }));
+  if (options.with_char_vector_column) {
+    names.push_back("cond");
+    columns.push_back(MakeCharVectorList(options.number_of_rows, &random));
+  }
+  return MakeTable(names, columns);
+}
+
+void* MakeKeyedTable(const TableOptions& options) {
+  Random random(options.seed);
+  std::vector<char*> symbols = MakeSymbols(options.number_of_symbols);
+  std::int64_t number_of_rows =
+      static_cast<std::int64_t>(options.number_of_symbols);
+
+  void* key = MakeTable(
+      {"sym"}, {MakeVector<char*>(q_types::q_symbol_type_id, number_of_rows,
+                                  [&](std::int64_t i) { return symbols[i]; })});
+  void* value = MakeTable(
+      {"price", "size", "name"},
+      {MakeVector<double>(q_types::q_float_type_id, number_of_rows,
+                          [&](std::int64_t) {
+                            return MakePrice(
+                                10 + 990 * random.NextDouble(), &random);
+                          }),
+       MakeVector<std::int64_t>(q_types::q_long_type_id, number_of_rows,
+                                [&](std::int64_t) {
+                                  return static_cast<std::int64_t>(
+                                      random.NextBelow(1000000));
+                                }),
+       MakeCharVectorList(number_of_rows, &random)});
+  return kdb_wrapper::CreateDict(key, value);
+}
+
+void* MakeNestedList(std::int64_t number_of_elements, int depth,
+                     std::uint64_t seed) {
+  Random random(seed);
+  return MakeNestedListLevel(number_of_elements, depth < 1 ? 1 : depth,
+                             &random);
+}
+}  // namespace cpp2kdb::synthetic_data
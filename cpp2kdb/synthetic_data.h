@@ -0,0 +1,82 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_SYNTHETIC_DATA_H__
+#define CPP2KDB_SYNTHETIC_DATA_H__
+/// \file cpp2kdb/synthetic_data.h
+/// Build large deterministic K objects for tests and benchmarks.
+///
+/// The objects are allocated by kdb_wrapper::CreateVector and friends and
+/// filled in place, so no server is needed. The data only depends on the seed
+/// and the sizes asked for, so the same call always builds the same object.
+
+#include <cstddef>
+#include <cstdint>
+
+/// Synthetic K objects built without a server.
+namespace cpp2kdb::synthetic_data {
+/// Options of the tables built.
+struct TableOptions {
+  /// Number of rows.
+  std::int64_t number_of_rows = 0;
+  /// Seed of the random numbers.
+  std::uint64_t seed = 0;
+  /// Number of distinct symbols in the sym column. The trade and quote tables
+  /// take 0 as 1, and the keyed table has one row per symbol.
+  std::size_t number_of_symbols = 100;
+  /// Date of the timestamps, in days since 2000.01.01.
+  int date = 7674;
+  /// Add a column of char vectors, which is a mixed list and takes one K
+  /// object per row, so it is much slower to build than the other columns.
+  bool with_char_vector_column = false;
+};
+
+/// Build a vector of random values for a simple q type id, such as
+/// q_types::q_float_type_id or q_types::q_timestamp_type_id.
+///
+/// Numbers are uniform between 0 and 1000, booleans are uniform, chars are
+/// lower case letters, and symbols are picked from 100 symbols.
+/// \returns nullptr for mixed lists and types that are not simple vectors.
+void* MakeRandomVector(
+    /// Q type id of the vector.
+    int q_type_id,
+    /// Number of elements.
+    std::int64_t number_of_elements,
+    /// Seed of the random numbers.
+    std::uint64_t seed);
+
+/// Build a trade table.
+///
+/// Columns: time (timestamp, increasing from 09:30 on the date), sym
+/// (symbol), price (float), size (long), ex (char), and cond (char vectors of
+/// 1 to 4 chars) if asked for.
+void* MakeTradeTable(const TableOptions& options);
+
+/// Build a quote table.
+///
+/// Columns: time (timestamp, increasing from 09:30 on the date), sym
+/// (symbol), bid and ask (float, ask above bid), bsize and asize (long), mode
+/// (char), and cond (char vectors of 1 to 4 chars) if asked for.
+void* MakeQuoteTable(const TableOptions& options);
+
+/// Build a table keyed by sym, with one row per symbol.
+///
+/// Key columns: sym (symbol). Value columns: price (float), size (long) and
+/// name (char vectors). options.number_of_rows is not used.
+void* MakeKeyedTable(const TableOptions& options);
+
+/// Build a mixed list nested depth levels deep.
+///
+/// Each element at the last level is a long vector, a float vector, a char
+/// vector, a symbol vector or a long atom, picked at random. Elements at the
+/// other levels are mixed lists of number_of_elements elements.
+void* MakeNestedList(
+    /// Number of elements in every list.
+    std::int64_t number_of_elements,
+    /// Number of levels of mixed lists, at least 1.
+    int depth,
+    /// Seed of the random numbers.
+    std::uint64_t seed);
+}  // namespace cpp2kdb::synthetic_data
+#endif  // CPP2KDB_SYNTHETIC_DATA_H__
@@ -0,0 +1,150 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/synthetic_data.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+// No connection is needed.
+namespace {
+void PrintTable(const char* name, void* table) {
+  void* column_heading;
+  void** columns;
+  std::size_t number_of_columns, number_of_rows;
+  std::cout << name << ": "
+            << cpp2kdb::accessors::GetSimpleTable(table, &column_heading,
+                                                  &columns, &number_of_columns,
+                                                  &number_of_rows)
+            << ", " << number_of_rows << " rows, columns";
+  std::vector<std::string> names(number_of_columns);
+  cpp2kdb::accessors::RetrieveVectorData(column_heading, names.data());
+  for (std::size_t i = 0; i < number_of_columns; i++) {
+    std::cout << " " << names[i] << ":"
+              << cpp2kdb::kdb_wrapper::GetQTypeId(columns[i]);
+  }
+  std::cout << std::endl;
+}
+
+void TestTables() {
+  cpp2kdb::synthetic_data::TableOptions options;
+  options.number_of_rows = 1000;
+  options.seed = 42;
+  options.with_char_vector_column = true;
+
+  void* trade = cpp2kdb::synthetic_data::MakeTradeTable(options);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard trade_guard(trade);
+  PrintTable("Trade", trade);
+
+  void* quote = cpp2kdb::synthetic_data::MakeQuoteTable(options);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard quote_guard(quote);
+  PrintTable("Quote", quote);
+
+  void* keyed = cpp2kdb::synthetic_data::MakeKeyedTable(options);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard keyed_guard(keyed);
+  void** key_value = cpp2kdb::accessors::GetVector<void*>(keyed);
+  std::cout << "Keyed table type is " << cpp2kdb::kdb_wrapper::GetQTypeId(keyed)
+            << std::endl;
+  PrintTable("Key", key_value[0]);
+  PrintTable("Value", key_value[1]);
+}
+
+void TestNoSymbol() {
+  cpp2kdb::synthetic_data::TableOptions options;
+  options.number_of_rows = 10;
+  options.number_of_symbols = 0;
+
+  // One symbol is used instead.
+  void* trade = cpp2kdb::synthetic_data::MakeTradeTable(options);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard trade_guard(trade);
+  PrintTable("Trade with 0 symbols", trade);
+  void* quote = cpp2kdb::synthetic_data::MakeQuoteTable(options);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard quote_guard(quote);
+  PrintTable("Quote with 0 symbols", quote);
+}
+
+void TestDeterministic() {
+  cpp2kdb::synthetic_data::TableOptions options;
+  options.number_of_rows = 10000;
+  options.seed = 7;
+  void* first = cpp2kdb::synthetic_data::MakeTradeTable(options);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard first_guard(first);
+  void* second = cpp2kdb::synthetic_data::MakeTradeTable(options);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard second_guard(second);
+
+  void *first_heading, *second_heading;
+  void **first_columns, **second_columns;
+  std::size_t nc, nr;
+  cpp2kdb::accessors::GetSimpleTable(first, &first_heading, &first_columns,
+                                     &nc, &nr);
+  cpp2kdb::accessors::GetSimpleTable(second, &second_heading, &second_columns,
+                                     &nc, &nr);
+  std::vector<double> first_price(nr), second_price(nr);
+  std::vector<std::int64_t> time(nr);
+  cpp2kdb::accessors::RetrieveVectorData(first_columns[2], first_price.data());
+  cpp2kdb::accessors::RetrieveVectorData(second_columns[2],
+                                         second_price.data());
+  cpp2kdb::accessors::RetrieveVectorData(first_columns[0], time.data());
+  bool is_sorted = true;
+  for (std::size_t i = 1; i < nr; i++) {
+    is_sorted = is_sorted && time[i - 1] <= time[i];
+  }
+  std::cout << "Same seed gives the same prices? "
+            << (first_price == second_price ? "Yes" : "No") << std::endl;
+  std::cout << "Time is sorted? " << (is_sorted ? "Yes" : "No") << std::endl;
+}
+
+void TestRandomVectorAndNestedList() {
+  for (int q_type_id = 1; q_type_id <= 19; q_type_id++) {
+    void* vector =
+        cpp2kdb::synthetic_data::MakeRandomVector(q_type_id, 100, q_type_id);
+    if (vector == nullptr) {
+      std::cout << "No random vector of type " << q_type_id << std::endl;
+      continue;
+    }
+    cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(vector);
+    if (cpp2kdb::kdb_wrapper::GetQTypeId(vector) != q_type_id) {
+      std::cout << "Wrong type for " << q_type_id << std::endl;
+    }
+  }
+
+  void* list = cpp2kdb::synthetic_data::MakeNestedList(10, 3, 1);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(list);
+  std::cout << "Nested list of 10 x 10 x 10 elements is about "
+            << cpp2kdb::accessors::EstimateObjectSize(list) << " bytes"
+            << std::endl;
+}
+
+void TestSpeed() {
+  cpp2kdb::synthetic_data::TableOptions options;
+  options.number_of_rows = 10000000;
+  auto start = std::chrono::steady_clock::now();
+  void* trade = cpp2kdb::synthetic_data::MakeTradeTable(options);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCount(trade);
+  std::cout << "10M row trade table built in "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)
+                   .count()
+            << "ms" << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  TestTables();
+  std::cout << "----------------------" << std::endl;
+  TestNoSymbol();
+  std::cout << "----------------------" << std::endl;
+  TestDeterministic();
+  std::cout << "----------------------" << std::endl;
+  TestRandomVectorAndNestedList();
+  std::cout << "----------------------" << std::endl;
+  TestSpeed();
+  return 0;
+}
@@ -0,0 +1,101 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/table.h"
+
+#include <utility>
+
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace cpp2kdb::table {
+Table::Table()
+    : columns(nullptr),
+      number_of_columns(0),
+      number_of_rows(0),
+      column_names(nullptr) {
+  // do nothing here
+}
+
+Table::Table(Table&& other) noexcept
+    : object(std::move(other.object)),
+      columns(std::exchange(other.columns, nullptr)),
+      number_of_columns(std::exchange(other.number_of_columns, 0)),
+      number_of_rows(std::exchange(other.number_of_rows, 0)),
+      column_names(std::exchange(other.column_names, nullptr)),
+      column_indices(std::move(other.column_indices)) {
+  other.column_indices.clear();
+}
+
+Table& Table::operator=(Table&& other) noexcept {
+  if (this != &other) {
+    this->object = std::move(other.object);
+    this->columns = std::exchange(other.columns, nullptr);
+    this->number_of_columns = std::exchange(other.number_of_columns, 0);
+    this->number_of_rows = std::exchange(other.number_of_rows, 0);
+    this->column_names = std::exchange(other.column_names, nullptr);
+    this->column_indices = std::move(other.column_indices);
+    other.column_indices.clear();
+  }
+  return *this;
+}
+
+std::size_t Table::GetNumberOfColumns() const {
+  return this->number_of_columns;
+}
+
+std::size_t Table::GetNumberOfRows() const { return this->number_of_rows; }
+
+std::string_view Table::GetColumnName(std::size_t i) const {
+  return this->column_names[i];
+}
+
+void* Table::GetColumnObject(std::size_t i) const { return this->columns[i]; }
+
+void* Table::GetObject() const { return this->object.Get(); }
+
+accessors::DataRetrievalResult Table::GetColumnIndex(
+    std::string_view name, std::size_t* index) const {
+  auto it = this->column_indices.find(name);
+  if (it == this->column_indices.end()) {
+    return accessors::DataRetrievalResult::ColumnNotFound;
+  }
+  *index = it->second;
+  return accessors::DataRetrievalResult::Ok;
+}
+
+accessors::DataRetrievalResult MakeTable(void* simple_table, Table* table) {
+  // GetSimpleTable doesn't check its input.
+  if (simple_table == nullptr) {
+    return accessors::DataRetrievalResult::NullInput;
+  }
+  if (accessors::IsError(simple_table)) {
+    return accessors::DataRetrievalResult::ValueError;
+  }
+  if (!accessors::IsTable(simple_table)) {
+    return accessors::DataRetrievalResult::NotSimpleTable;
+  }
+  void* column_heading;
+  void** columns = nullptr;
+  std::size_t number_of_columns, number_of_rows = 0;
+  accessors::DataRetrievalResult result =
+      accessors::GetSimpleTable(simple_table, &column_heading, &columns,
+                                &number_of_columns, &number_of_rows);
+  if (result != accessors::DataRetrievalResult::Ok) {
+    return result;
+  }
+
+  table->object = k_object::KObject::Share(simple_table);
+  table->columns = columns;
+  table->number_of_columns = number_of_columns;
+  table->number_of_rows = number_of_rows;
+  table->column_names = accessors::GetVector<char*>(column_heading);
+  table->column_indices.clear();
+  table->column_indices.reserve(number_of_columns);
+  for (std::size_t i = 0; i < number_of_columns; i++) {
+    // Names are unique in q, emplace keeps the first one anyway.
+    table->column_indices.emplace(table->column_names[i], i);
+  }
+  return accessors::DataRetrievalResult::Ok;
+}
+}  // namespace cpp2kdb::table
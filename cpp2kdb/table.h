@@ -0,0 +1,156 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_TABLE_H__
+#define CPP2KDB_TABLE_H__
+/// \file cpp2kdb/table.h
+/// Simple tables with columns looked up by name.
+///
+/// GetSimpleTable returns the column heading and the columns, and leaves
+/// callers to scan the heading for the column they want. Table does it once,
+/// into a hash map from name to index, and checks the type of the column
+/// against the type asked for when it is looked up.
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/k_object.h"
+#include "cpp2kdb/vector_view.h"
+
+/// Simple tables.
+namespace cpp2kdb::table {
+/// Simple table holding a reference to the K object.
+///
+/// Table can be moved but not copied, like k_object::KObject.
+class Table {
+ public:
+  /// Create an empty table, with no column.
+  Table();
+  /// Copy constructor is deleted.
+  Table(const Table&) = delete;
+  /// assignment operator is deleted.
+  Table& operator=(const Table&) = delete;
+  /// Move constructor, leaving other empty.
+  Table(Table&& other) noexcept;
+  /// Move assignment, leaving other empty.
+  Table& operator=(Table&& other) noexcept;
+
+  /// Get the number of columns.
+  std::size_t GetNumberOfColumns() const;
+  /// Get the number of rows.
+  std::size_t GetNumberOfRows() const;
+  /// Get the name of column i, which is not checked.
+  std::string_view GetColumnName(std::size_t i) const;
+  /// Get the K vector of column i, which is not checked. The reference stays
+  /// with the table.
+  void* GetColumnObject(std::size_t i) const;
+  /// Get the K object of the table, nullptr for an empty table. The reference
+  /// stays with the table.
+  void* GetObject() const;
+
+  /// Find the index of a column, so the lookup can be done once in hot loops.
+  /// \returns ColumnNotFound if there is no column of that name.
+  accessors::DataRetrievalResult GetColumnIndex(
+      /// Column name.
+      std::string_view name,
+      /// [out] Index of the column.
+      std::size_t* index) const;
+
+  /// Create a view over column i, see vector_view::MakeKVectorView.
+  template <typename T>
+  accessors::DataRetrievalResult GetColumn(
+      /// Index of the column, which is not checked.
+      std::size_t i,
+      /// [out] view.
+      vector_view::KVectorView<T>* view) const {
+    return vector_view::MakeKVectorView(this->columns[i], view);
+  }
+  /// Create a view over a column, see vector_view::MakeKVectorView.
+  /// \returns ColumnNotFound if there is no column of that name.
+  template <typename T>
+  accessors::DataRetrievalResult GetColumn(
+      /// Column name.
+      std::string_view name,
+      /// [out] view.
+      vector_view::KVectorView<T>* view) const {
+    std::size_t i;
+    accessors::DataRetrievalResult result = this->GetColumnIndex(name, &i);
+    if (result != accessors::DataRetrievalResult::Ok) {
+      return result;
+    }
+    return this->GetColumn(i, view);
+  }
+
+  /// Copy column i into output, resized to the number of rows, see
+  /// accessors::RetrieveVectorData. std::vector<bool> has no data() to
+  /// retrieve into, so booleans are copied through a buffer.
+  template <typename T>
+  accessors::DataRetrievalResult GetColumn(
+      /// Index of the column, which is not checked.
+      std::size_t i,
+      /// [out] output.
+      std::vector<T>* output) const {
+    if constexpr (std::is_same_v<T, bool>) {
+      std::unique_ptr<bool[]> buffer(new bool[this->number_of_rows]);
+      accessors::DataRetrievalResult result =
+          accessors::RetrieveVectorData(this->columns[i], buffer.get());
+      if (result == accessors::DataRetrievalResult::Ok) {
+        output->assign(buffer.get(), buffer.get() + this->number_of_rows);
+      }
+      return result;
+    } else {
+      output->resize(this->number_of_rows);
+      return accessors::RetrieveVectorData(this->columns[i], output->data());
+    }
+  }
+  /// Copy a column into output, resized to the number of rows, see
+  /// accessors::RetrieveVectorData.
+  /// \returns ColumnNotFound if there is no column of that name.
+  template <typename T>
+  accessors::DataRetrievalResult GetColumn(
+      /// Column name.
+      std::string_view name,
+      /// [out] output.
+      std::vector<T>* output) const {
+    std::size_t i;
+    accessors::DataRetrievalResult result = this->GetColumnIndex(name, &i);
+    if (result != accessors::DataRetrievalResult::Ok) {
+      return result;
+    }
+    return this->GetColumn(i, output);
+  }
+
+ private:
+  friend accessors::DataRetrievalResult MakeTable(void* simple_table,
+                                                  Table* table);
+
+  k_object::KObject object;
+  void** columns;
+  std::size_t number_of_columns;
+  std::size_t number_of_rows;
+  /// Column names, which are interned symbols and never freed.
+  char** column_names;
+  /// Index of each column name.
+  std::unordered_map<std::string_view, std::size_t> column_indices;
+};
+
+/// Create a Table from a simple table.
+///
+/// The table takes a new reference to the K object, so the caller keeps its
+/// own. The column names are hashed once here.
+/// \returns NullInput, ValueError, NotSimpleTable if the input is not a table
+///          (keyed tables included). The table is left unchanged when the
+///          result is not Ok.
+accessors::DataRetrievalResult MakeTable(
+    /// [in] Input simple table.
+    void* simple_table,
+    /// [out] table.
+    Table* table);
+}  // namespace cpp2kdb::table
+#endif  // CPP2KDB_TABLE_H__
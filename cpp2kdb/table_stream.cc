@@ -0,0 +1,176 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/table_stream.h"
+
+#include <cstdint>
+#include <utility>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/async_query.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace cpp2kdb::table_stream {
+namespace {
+/// Get the message of an error object.
+std::string GetErrorMessageOfError(void* error) {
+  return *static_cast<char**>(kdb_wrapper::GetValue(error));
+}
+}  // namespace
+
+const char* GetStreamResultName(StreamResult result) {
+  // Cast result to an int.
+  int temp_result = static_cast<int>(result);
+  // Make sure it's valid.
+  if (temp_result >= 0 && temp_result < number_of_stream_result_names) {
+    return StreamResultNames[temp_result];
+  } else {
+    return "Invalid";
+  }
+}
+
+std::ostream& operator<<(std::ostream& output, StreamResult result) {
+  return output << GetStreamResultName(result);
+}
+
+TableStream::TableStream(int connection, std::string table,
+                         std::size_t page_size)
+    : connection(connection),
+      table(std::move(table)),
+      page_size(page_size),
+      number_of_rows(0),
+      number_of_pages(0),
+      next_page_index(0),
+      is_opened(false),
+      is_page_in_flight(false),
+      current_page(nullptr) {
+  // do nothing here
+}
+
+TableStream::~TableStream() { this->Close(); }
+
+StreamResult TableStream::Open() {
+  this->Close();
+  this->is_opened = false;
+  if (this->page_size == 0) {
+    this->error_message = "page size is 0";
+    return StreamResult::QueryFailed;
+  }
+
+  std::string query = "count select from " + this->table;
+  void* result =
+      kdb_wrapper::RunQueryOnConnection(this->connection, query.c_str());
+  if (result == nullptr) {
+    return StreamResult::ConnectionLost;
+  }
+  kdb_wrapper::DecreaseReferenceCountGuard guard(result);
+  if (accessors::IsError(result)) {
+    this->error_message = GetErrorMessageOfError(result);
+    return StreamResult::QueryFailed;
+  }
+  if (kdb_wrapper::GetQTypeId(result) != -q_types::q_long_type_id) {
+    return StreamResult::NotTable;
+  }
+
+  this->number_of_rows = accessors::GetValue<std::int64_t>(result);
+  this->number_of_pages =
+      (this->number_of_rows + this->page_size - 1) / this->page_size;
+  this->next_page_index = 0;
+  this->is_opened = true;
+  return StreamResult::Ok;
+}
+
+std::size_t TableStream::GetNumberOfRows() const {
+  return this->number_of_rows;
+}
+
+StreamResult TableStream::Next(TablePage* page) {
+  if (!this->is_opened) {
+    return StreamResult::NotOpened;
+  }
+  // Release the current page before reading the next one, so at most one page
+  // is held.
+  if (this->current_page != nullptr) {
+    kdb_wrapper::DecreaseReferenceCount(this->current_page);
+    this->current_page = nullptr;
+  }
+  if (this->next_page_index >= this->number_of_pages) {
+    return StreamResult::EndOfTable;
+  }
+  // Only the first page is not prefetched.
+  if (!this->is_page_in_flight) {
+    if (!this->SendPageQuery(this->next_page_index)) {
+      this->is_opened = false;
+      return StreamResult::ConnectionLost;
+    }
+  }
+
+  void* message = kdb_wrapper::ReadMessageFromConnection(this->connection);
+  this->is_page_in_flight = false;
+  std::int64_t request_id;
+  void* result;
+  if (!async_query::UnpackReply(message, &request_id, &result)) {
+    this->is_opened = false;
+    return StreamResult::ConnectionLost;
+  }
+  kdb_wrapper::DecreaseReferenceCountGuard guard(result);
+  if (request_id != static_cast<std::int64_t>(this->next_page_index)) {
+    this->is_opened = false;
+    return StreamResult::ConnectionLost;
+  }
+
+  // Prefetch the next page while the caller consumes this one.
+  std::size_t page_index = this->next_page_index++;
+  if (this->next_page_index < this->number_of_pages) {
+    if (!this->SendPageQuery(this->next_page_index)) {
+      this->is_opened = false;
+      return StreamResult::ConnectionLost;
+    }
+  }
+
+  if (accessors::IsError(result)) {
+    this->error_message = GetErrorMessageOfError(result);
+    return StreamResult::QueryFailed;
+  }
+  if (accessors::GetSimpleTable(result, &page->column_heading, &page->columns,
+                                &page->number_of_columns,
+                                &page->number_of_rows) !=
+      accessors::DataRetrievalResult::Ok) {
+    return StreamResult::NotTable;
+  }
+  page->first_row = page_index * this->page_size;
+  page->table = this->current_page =
+      kdb_wrapper::IncreaseReferenceCount(result);
+  return StreamResult::Ok;
+}
+
+const std::string& TableStream::GetErrorMessage() const {
+  return this->error_message;
+}
+
+bool TableStream::SendPageQuery(std::size_t page_index) {
+  std::string query = "0!select[" +
+                      std::to_string(page_index * this->page_size) + " " +
+                      std::to_string(this->page_size) + "] from " +
+                      this->table;
+  this->is_page_in_flight = async_query::SendQueryWithReply(
+      this->connection, page_index, query.c_str());
+  return this->is_page_in_flight;
+}
+
+void TableStream::Close() {
+  if (this->current_page != nullptr) {
+    kdb_wrapper::DecreaseReferenceCount(this->current_page);
+    this->current_page = nullptr;
+  }
+  if (this->is_page_in_flight) {
+    // Drain the reply, so it is not read by the next user of the connection.
+    void* message = kdb_wrapper::ReadMessageFromConnection(this->connection);
+    if (message != nullptr) {
+      kdb_wrapper::DecreaseReferenceCount(message);
+    }
+    this->is_page_in_flight = false;
+  }
+}
+}  // namespace cpp2kdb::table_stream
@@ -0,0 +1,140 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_TABLE_STREAM_H__
+#define CPP2KDB_TABLE_STREAM_H__
+/// \file cpp2kdb/table_stream.h
+/// Read a large table page by page.
+///
+/// Instead of getting the whole table with one query, the table is read with
+/// one select[start number_of_rows] query per page. The query of the next page
+/// is sent before the current page is handed out, so the server is working on
+/// it while the caller consumes the current page. Only the current page is
+/// kept in memory.
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+/// Streaming tables on connections opened by kdb_wrapper::OpenConnection.
+namespace cpp2kdb::table_stream {
+/// Stream Result
+enum class StreamResult {
+  /// Ok.
+  Ok = 0,
+  /// All the rows are read.
+  EndOfTable,
+  /// Connection is lost.
+  ConnectionLost,
+  /// Query failed on the server. The error message is available from
+  /// TableStream::GetErrorMessage.
+  QueryFailed,
+  /// Result is not a table.
+  NotTable,
+  /// TableStream is not opened.
+  NotOpened
+};
+
+/// Names for the enums.
+constexpr const char* StreamResultNames[] = {
+    "Ok",          "EndOfTable", "ConnectionLost",
+    "QueryFailed", "NotTable",   "NotOpened"};
+
+/// Number of stream result names
+constexpr const int number_of_stream_result_names =
+    sizeof(StreamResultNames) / sizeof(StreamResultNames[0]);
+
+/// Get the name from a result
+const char* GetStreamResultName(StreamResult result);
+
+/// Overload << for result type `StreamResult`.
+std::ostream& operator<<(std::ostream& output_stream, StreamResult result);
+
+/// One page of the table.
+///
+/// The page is owned by TableStream, and is released when the next page is
+/// read or the stream is destructed. Call kdb_wrapper::IncreaseReferenceCount
+/// on table to keep it longer.
+struct TablePage {
+  /// The page, a simple table.
+  void* table = nullptr;
+  /// Column heading, a symbol vector.
+  void* column_heading = nullptr;
+  /// Columns, each one can be retrieved with accessors::RetrieveVectorData.
+  void** columns = nullptr;
+  /// Number of columns.
+  std::size_t number_of_columns = 0;
+  /// Number of rows in the page.
+  std::size_t number_of_rows = 0;
+  /// Index of the first row of the page in the whole table.
+  std::size_t first_row = 0;
+};
+
+/// Read a table page by page.
+///
+/// The table is evaluated again by the server for every page, so it should be
+/// a table name, optionally followed by a where clause, such as
+/// "trade where date=2021.01.04". Keyed tables are unkeyed. For an expensive
+/// query, assign the result to a variable on the server first.
+///
+/// The connection is not owned, and must not have any other reply pending
+/// while TableStream is used.
+class TableStream {
+ public:
+  /// Create on a handle returned by kdb_wrapper::OpenConnection.
+  TableStream(
+      /// Handle
+      int connection,
+      /// Table name, optionally followed by a where clause.
+      std::string table,
+      /// Number of rows in each page.
+      std::size_t page_size);
+  /// Default constructor is deleted.
+  TableStream() = delete;
+  /// Copy constructor is deleted.
+  TableStream(const TableStream&) = delete;
+  /// assignment operator is deleted.
+  TableStream& operator=(const TableStream&) = delete;
+
+  /// Destructor, releasing the current page and reading the reply of the page
+  /// in flight, so the connection can be used again.
+  ~TableStream();
+
+  /// Count the rows of the table, and get ready to read the first page.
+  StreamResult Open();
+
+  /// Get the number of rows of the table, counted by Open.
+  std::size_t GetNumberOfRows() const;
+
+  /// Read the next page, releasing the current one.
+  ///
+  /// \returns EndOfTable after the last page.
+  StreamResult Next(
+      /// [out] The page.
+      TablePage* page);
+
+  /// Get the error message of the last query failed.
+  const std::string& GetErrorMessage() const;
+
+ private:
+  /// Send the query of the page.
+  bool SendPageQuery(std::size_t page_index);
+  /// Release the current page and read the reply of the page in flight.
+  void Close();
+
+  int connection;
+  std::string table;
+  std::size_t page_size;
+  std::size_t number_of_rows;
+  std::size_t number_of_pages;
+  /// Index of the page returned by the next call to Next.
+  std::size_t next_page_index;
+  bool is_opened;
+  /// If the query of next_page_index is sent but not read.
+  bool is_page_in_flight;
+  void* current_page;
+  std::string error_message;
+};
+}  // namespace cpp2kdb::table_stream
+#endif  // CPP2KDB_TABLE_STREAM_H__
@@ -0,0 +1,106 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/table_stream.h"
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace {
+void TestStream(int connection) {
+  cpp2kdb::table_stream::TableStream stream(connection, "stream_test", 300000);
+  std::cout << "Open: " << stream.Open() << ", number of rows is "
+            << stream.GetNumberOfRows() << std::endl;
+
+  // Retrieve the pages into the column of the whole table.
+  std::vector<std::int64_t> a_column(stream.GetNumberOfRows());
+  std::size_t number_of_pages = 0;
+  cpp2kdb::table_stream::TablePage page;
+  cpp2kdb::table_stream::StreamResult result;
+  while ((result = stream.Next(&page)) ==
+         cpp2kdb::table_stream::StreamResult::Ok) {
+    number_of_pages++;
+    cpp2kdb::accessors::RetrieveVectorData(page.columns[0],
+                                           a_column.data() + page.first_row);
+  }
+  std::cout << "Stopped with " << result << " after " << number_of_pages
+            << " pages" << std::endl;
+
+  bool is_correct = true;
+  for (std::size_t i = 0; i < a_column.size(); i++) {
+    is_correct = is_correct && a_column[i] == static_cast<std::int64_t>(i);
+  }
+  std::cout << "Column a is til 1000000? " << (is_correct ? "Yes" : "No")
+            << std::endl;
+}
+
+void TestWhereClause(int connection) {
+  cpp2kdb::table_stream::TableStream stream(
+      connection, "stream_test where 0 = a mod 3", 100000);
+  std::cout << "Open: " << stream.Open() << ", number of rows is "
+            << stream.GetNumberOfRows() << std::endl;
+  cpp2kdb::table_stream::TablePage page;
+  std::size_t number_of_rows = 0;
+  while (stream.Next(&page) == cpp2kdb::table_stream::StreamResult::Ok) {
+    number_of_rows += page.number_of_rows;
+  }
+  std::cout << "Rows streamed: " << number_of_rows << std::endl;
+}
+
+void TestStopEarly(int connection) {
+  {
+    cpp2kdb::table_stream::TableStream stream(connection, "stream_test", 1000);
+    stream.Open();
+    cpp2kdb::table_stream::TablePage page;
+    stream.Next(&page);
+    // The prefetched page is drained when stream is destructed.
+  }
+  void* result =
+      cpp2kdb::kdb_wrapper::RunQueryOnConnection(connection, "4 * 5 + 6");
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(result);
+  std::cout << "Connection usable after stopping early? "
+            << (cpp2kdb::accessors::GetValue<std::int64_t>(result) == 26
+                    ? "Yes"
+                    : "No")
+            << std::endl;
+}
+
+void TestError(int connection) {
+  cpp2kdb::table_stream::TableStream stream(connection, "no_such_table", 10);
+  std::cout << "Open a table not existing: " << stream.Open() << ", "
+            << stream.GetErrorMessage() << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  // Open connection
+  int connection = cpp2kdb::kdb_wrapper::OpenConnection("127.0.0.1", 5000, "");
+
+  if (connection <= 0) {
+    std::cerr << "Connection error: " << connection << std::endl;
+    return 1;
+  }
+
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard create_guard(
+      cpp2kdb::kdb_wrapper::RunQueryOnConnection(
+          connection, "stream_test:([] a:til 1000000; b:1000000?1.)"));
+
+  TestStream(connection);
+  std::cout << "----------------------" << std::endl;
+  TestWhereClause(connection);
+  std::cout << "----------------------" << std::endl;
+  TestStopEarly(connection);
+  std::cout << "----------------------" << std::endl;
+  TestError(connection);
+
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard delete_guard(
+      cpp2kdb::kdb_wrapper::RunQueryOnConnection(connection,
+                                                 "delete stream_test from `."));
+  cpp2kdb::kdb_wrapper::CloseConnection(connection);
+  return 0;
+}
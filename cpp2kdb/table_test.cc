@@ -0,0 +1,123 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/table.h"
+
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+#include "cpp2kdb/synthetic_data.h"
+#include "cpp2kdb/vector_view.h"
+
+// Tables are built in process, no connection is needed.
+namespace {
+void TestColumns() {
+  cpp2kdb::synthetic_data::TableOptions options;
+  options.number_of_rows = 1000;
+  options.seed = 7;
+  void* trade = cpp2kdb::synthetic_data::MakeTradeTable(options);
+  cpp2kdb::table::Table table;
+  std::cout << "Make table: " << cpp2kdb::table::MakeTable(trade, &table)
+            << ", " << table.GetNumberOfColumns() << " columns, "
+            << table.GetNumberOfRows() << " rows" << std::endl;
+  // The table keeps its own reference.
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCount(trade);
+
+  std::size_t index;
+  std::cout << "Index of price: " << table.GetColumnIndex("price", &index)
+            << ", " << index << ", named " << table.GetColumnName(index)
+            << std::endl;
+
+  cpp2kdb::vector_view::KVectorView<double> price;
+  std::vector<double> price_copy;
+  std::cout << "price as view: " << table.GetColumn("price", &price)
+            << ", as copy: " << table.GetColumn("price", &price_copy)
+            << std::endl;
+  std::cout << "Same sum? "
+            << (std::accumulate(price.begin(), price.end(), 0.0) ==
+                        std::accumulate(price_copy.begin(), price_copy.end(),
+                                        0.0)
+                    ? "Yes"
+                    : "No")
+            << std::endl;
+
+  std::vector<std::string> sym;
+  std::cout << "sym as std::string: " << table.GetColumn("sym", &sym) << ", "
+            << sym.size() << " rows" << std::endl;
+
+  cpp2kdb::table::Table moved = std::move(table);
+  cpp2kdb::vector_view::KVectorView<std::int64_t> size;
+  std::cout << "size after move: " << moved.GetColumn("size", &size) << ", "
+            << size.size() << " rows, left " << table.GetNumberOfColumns()
+            << " columns" << std::endl;
+}
+
+void TestBooleanColumn() {
+  void* flags = cpp2kdb::synthetic_data::MakeRandomVector(
+      cpp2kdb::q_types::q_boolean_type_id, 100, 3);
+  void* heading = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_symbol_type_id, 1);
+  cpp2kdb::accessors::GetVector<char*>(heading)[0] =
+      cpp2kdb::kdb_wrapper::InternSymbol("flag");
+  void* values = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_mixed_type_id, 1);
+  cpp2kdb::accessors::GetVector<void*>(values)[0] = flags;
+  void* flag_table = cpp2kdb::kdb_wrapper::CreateTable(
+      cpp2kdb::kdb_wrapper::CreateDict(heading, values));
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(flag_table);
+  cpp2kdb::table::Table table;
+  cpp2kdb::table::MakeTable(flag_table, &table);
+
+  std::vector<bool> flag;
+  std::cout << "flag as bool: " << table.GetColumn("flag", &flag) << ", "
+            << flag.size() << " rows" << std::endl;
+  const bool* data = cpp2kdb::accessors::GetVector<bool>(flags);
+  bool is_same = flag.size() == 100;
+  for (std::size_t i = 0; is_same && i < flag.size(); i++) {
+    is_same = flag[i] == data[i];
+  }
+  std::cout << "Same as the vector? " << (is_same ? "Yes" : "No") << std::endl;
+}
+
+void TestErrors() {
+  cpp2kdb::synthetic_data::TableOptions options;
+  options.number_of_rows = 10;
+  void* trade = cpp2kdb::synthetic_data::MakeTradeTable(options);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard trade_guard(trade);
+  cpp2kdb::table::Table table;
+  cpp2kdb::table::MakeTable(trade, &table);
+
+  cpp2kdb::vector_view::KVectorView<std::int64_t> price;
+  std::vector<double> missing;
+  std::vector<double> sym;
+  std::cout << "price as long: " << table.GetColumn("price", &price)
+            << std::endl;
+  std::cout << "Missing column: " << table.GetColumn("bid", &missing)
+            << std::endl;
+  std::cout << "sym as double: " << table.GetColumn("sym", &sym) << std::endl;
+
+  void* keyed = cpp2kdb::synthetic_data::MakeKeyedTable(options);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard keyed_guard(keyed);
+  std::cout << "Keyed table: " << cpp2kdb::table::MakeTable(keyed, &table)
+            << ", still " << table.GetNumberOfColumns() << " columns"
+            << std::endl;
+  std::cout << "nullptr: " << cpp2kdb::table::MakeTable(nullptr, &table)
+            << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  TestColumns();
+  std::cout << "----------------------" << std::endl;
+  TestBooleanColumn();
+  std::cout << "----------------------" << std::endl;
+  TestErrors();
+  return 0;
+}
@@ -0,0 +1,242 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/tickerplant_subscriber.h"
+
+#include <utility>
+
+namespace cpp2kdb::tickerplant_subscriber {
+namespace {
+/// Number of elements in an upd message.
+constexpr long long number_of_upd_elements = 3;  // NOLINT
+
+/// Get the interned symbol of a symbol atom.
+char* GetSymbol(void* symbol_atom) {
+  return *static_cast<char**>(kdb_wrapper::GetValue(symbol_atom));
+}
+
+std::int64_t GetNanosecondsSinceEpoch(
+    std::chrono::steady_clock::time_point time) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             time.time_since_epoch())
+      .count();
+}
+}  // namespace
+
+const char* GetSubscriptionResultName(SubscriptionResult result) {
+  // Cast result to an int.
+  int temp_result = static_cast<int>(result);
+  // Make sure it's valid.
+  if (temp_result >= 0 && temp_result < number_of_subscription_result_names) {
+    return SubscriptionResultNames[temp_result];
+  } else {
+    return "Invalid";
+  }
+}
+
+std::ostream& operator<<(std::ostream& output, SubscriptionResult result) {
+  return output << GetSubscriptionResultName(result);
+}
+
+std::uint64_t GetLatencyPercentile(const SubscriberStatistics& statistics,
+                                   double fraction) {
+  std::uint64_t total = 0;
+  for (std::uint64_t count : statistics.decode_latency_histogram) {
+    total += count;
+  }
+  std::uint64_t cumulative = 0;
+  for (int i = 0; i < number_of_latency_buckets; i++) {
+    cumulative += statistics.decode_latency_histogram[i];
+    if (cumulative > 0 && cumulative >= fraction * total) {
+      return std::uint64_t{1} << (i + 1);
+    }
+  }
+  return 0;
+}
+
+Subscriber::Subscriber(int connection)
+    : connection(connection),
+      upd_symbol(kdb_wrapper::InternSymbol("upd")),
+      is_stopping(false),
+      number_of_messages(0),
+      number_of_updates(0),
+      first_message_time(0) {
+  for (auto& count : this->decode_latency_histogram) {
+    count.store(0, std::memory_order_relaxed);
+  }
+}
+
+void Subscriber::SetCallback(const char* table, UpdateCallback callback) {
+  // Symbols in messages are interned when deserialized, so the same name gives
+  // the same pointer.
+  char* table_symbol = kdb_wrapper::InternSymbol(table);
+  for (TableCallback& table_callback : this->table_callbacks) {
+    if (table_callback.table == table_symbol) {
+      table_callback.callback = std::move(callback);
+      return;
+    }
+  }
+  this->table_callbacks.push_back(
+      TableCallback{table_symbol, std::move(callback)});
+}
+
+SubscriptionResult Subscriber::Subscribe(
+    const std::string& table, const std::vector<std::string>& symbols) {
+  std::string query = ".u.sub[`" + table + ";";
+  if (symbols.empty()) {
+    query += "`";
+  } else {
+    // Join with the empty list, so a single symbol is still a list.
+    query += "(),";
+    for (const std::string& symbol : symbols) {
+      query += "`" + symbol;
+    }
+  }
+  query += "]";
+
+  void* result =
+      kdb_wrapper::RunQueryOnConnection(this->connection, query.c_str());
+  if (result == nullptr) {
+    return SubscriptionResult::ConnectionLost;
+  }
+  kdb_wrapper::DecreaseReferenceCountGuard guard(result);
+  if (accessors::IsError(result)) {
+    return SubscriptionResult::SubscriptionFailed;
+  }
+  return SubscriptionResult::Ok;
+}
+
+SubscriptionResult Subscriber::ProcessMessage() {
+  void* message = kdb_wrapper::ReadMessageFromConnection(this->connection);
+  if (message == nullptr) {
+    return SubscriptionResult::ConnectionLost;
+  }
+  auto read_time = std::chrono::steady_clock::now();
+  std::int64_t no_time = 0;
+  this->first_message_time.compare_exchange_strong(
+      no_time, GetNanosecondsSinceEpoch(read_time), std::memory_order_relaxed);
+  // Only this thread writes, so no need for an atomic increment.
+  this->number_of_messages.store(
+      this->number_of_messages.load(std::memory_order_relaxed) + 1,
+      std::memory_order_relaxed);
+
+  kdb_wrapper::DecreaseReferenceCountGuard guard(message);
+  return this->DispatchMessage(message, read_time);
+}
+
+SubscriptionResult Subscriber::Run() {
+  while (!this->is_stopping.load(std::memory_order_relaxed)) {
+    SubscriptionResult result = this->ProcessMessage();
+    if (result == SubscriptionResult::ConnectionLost) {
+      return result;
+    }
+  }
+  return SubscriptionResult::Stopped;
+}
+
+void Subscriber::Stop() {
+  this->is_stopping.store(true, std::memory_order_relaxed);
+}
+
+SubscriberStatistics Subscriber::GetStatistics() const {
+  SubscriberStatistics statistics;
+  statistics.number_of_messages =
+      this->number_of_messages.load(std::memory_order_relaxed);
+  statistics.number_of_updates =
+      this->number_of_updates.load(std::memory_order_relaxed);
+  for (int i = 0; i < number_of_latency_buckets; i++) {
+    statistics.decode_latency_histogram[i] =
+        this->decode_latency_histogram[i].load(std::memory_order_relaxed);
+  }
+  std::int64_t first_time =
+      this->first_message_time.load(std::memory_order_relaxed);
+  if (first_time != 0) {
+    statistics.elapsed_seconds =
+        (GetNanosecondsSinceEpoch(std::chrono::steady_clock::now()) -
+         first_time) /
+        1e9;
+  }
+  if (statistics.elapsed_seconds > 0) {
+    statistics.messages_per_second =
+        statistics.number_of_messages / statistics.elapsed_seconds;
+  }
+  return statistics;
+}
+
+const UpdateCallback* Subscriber::FindCallback(const char* table) const {
+  // Only a few tables, linear search is faster than hashing.
+  for (const TableCallback& table_callback : this->table_callbacks) {
+    if (table_callback.table == table) {
+      return &table_callback.callback;
+    }
+  }
+  return nullptr;
+}
+
+SubscriptionResult Subscriber::DispatchMessage(
+    void* message, std::chrono::steady_clock::time_point read_time) {
+  // Make sure this is (`upd; `table; data)
+  if (!accessors::IsMixedVector(message) ||
+      kdb_wrapper::GetNumberOfVectorElements(message) !=
+          number_of_upd_elements) {
+    return SubscriptionResult::Ignored;
+  }
+  void** elements = accessors::GetVector<void*>(message);
+  if (kdb_wrapper::GetQTypeId(elements[0]) != -q_types::q_symbol_type_id ||
+      GetSymbol(elements[0]) != this->upd_symbol ||
+      kdb_wrapper::GetQTypeId(elements[1]) != -q_types::q_symbol_type_id) {
+    return SubscriptionResult::Ignored;
+  }
+  TableUpdate update;
+  update.table = GetSymbol(elements[1]);
+  const UpdateCallback* callback = this->FindCallback(update.table);
+  if (callback == nullptr) {
+    return SubscriptionResult::Ignored;
+  }
+
+  update.data = elements[2];
+  if (accessors::IsTable(update.data)) {
+    accessors::GetSimpleTable(update.data, &update.column_heading,
+                              &update.columns, &update.number_of_columns,
+                              &update.number_of_rows);
+  } else if (accessors::IsMixedVector(update.data)) {
+    // List of columns, all of the same length.
+    update.columns = accessors::GetVector<void*>(update.data);
+    update.number_of_columns =
+        kdb_wrapper::GetNumberOfVectorElements(update.data);
+    if (update.number_of_columns > 0) {
+      // A single row is published as a list of atoms.
+      int q_type_id = kdb_wrapper::GetQTypeId(update.columns[0]);
+      update.number_of_rows =
+          q_types::IsQTypeIdAtomic(q_type_id)
+              ? 1
+              : kdb_wrapper::GetNumberOfVectorElements(update.columns[0]);
+    }
+  } else {
+    return SubscriptionResult::Ignored;
+  }
+
+  this->RecordLatency(std::chrono::steady_clock::now() - read_time);
+  this->number_of_updates.store(
+      this->number_of_updates.load(std::memory_order_relaxed) + 1,
+      std::memory_order_relaxed);
+  (*callback)(update);
+  return SubscriptionResult::Ok;
+}
+
+void Subscriber::RecordLatency(std::chrono::nanoseconds latency) {
+  std::uint64_t nanoseconds = latency.count() > 0 ? latency.count() : 0;
+  int bucket = 0;
+  while (nanoseconds >>= 1) {
+    bucket++;
+  }
+  if (bucket >= number_of_latency_buckets) {
+    bucket = number_of_latency_buckets - 1;
+  }
+  this->decode_latency_histogram[bucket].store(
+      this->decode_latency_histogram[bucket].load(std::memory_order_relaxed) +
+          1,
+      std::memory_order_relaxed);
+}
+}  // namespace cpp2kdb::tickerplant_subscriber
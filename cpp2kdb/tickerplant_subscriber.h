@@ -0,0 +1,202 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_TICKERPLANT_SUBSCRIBER_H__
+#define CPP2KDB_TICKERPLANT_SUBSCRIBER_H__
+/// \file cpp2kdb/tickerplant_subscriber.h
+/// Subscribe to a tickerplant, and dispatch the upd messages to callbacks.
+///
+/// The tickerplant publishes (`upd;`table;data) messages, where data is a
+/// table, or a list of columns. Each message is decoded into a TableUpdate,
+/// which is a set of views into the message, and passed to the callback
+/// registered for the table. Nothing is allocated on the heap by the
+/// subscriber for each message.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+/// Tickerplant subscription on connections opened by
+/// kdb_wrapper::OpenConnection.
+namespace cpp2kdb::tickerplant_subscriber {
+/// Subscription Result
+enum class SubscriptionResult {
+  /// Ok.
+  Ok = 0,
+  /// Message is not an upd message, or no callback is set for the table.
+  Ignored,
+  /// Connection is lost.
+  ConnectionLost,
+  /// Subscription is rejected by the tickerplant.
+  SubscriptionFailed,
+  /// Stop is called.
+  Stopped
+};
+
+/// Names for the enums.
+constexpr const char* SubscriptionResultNames[] = {
+    "Ok", "Ignored", "ConnectionLost", "SubscriptionFailed", "Stopped"};
+
+/// Number of subscription result names
+constexpr const int number_of_subscription_result_names =
+    sizeof(SubscriptionResultNames) / sizeof(SubscriptionResultNames[0]);
+
+/// Get the name from a result
+const char* GetSubscriptionResultName(SubscriptionResult result);
+
+/// Overload << for result type `SubscriptionResult`.
+std::ostream& operator<<(std::ostream& output_stream,
+                         SubscriptionResult result);
+
+/// Rows published for a table by one upd message.
+///
+/// All the pointers point into the message, which is released after the
+/// callback returns. Call kdb_wrapper::IncreaseReferenceCount on data to keep
+/// it longer.
+struct TableUpdate {
+  /// Name of the table, an interned symbol.
+  const char* table = nullptr;
+  /// Data, a table or a mixed list of columns.
+  void* data = nullptr;
+  /// Column heading, a symbol vector. nullptr if data is a list of columns.
+  void* column_heading = nullptr;
+  /// Columns. When a single row is published as a list of atoms, each column
+  /// is an atom instead of a vector.
+  void** columns = nullptr;
+  /// Number of columns.
+  std::size_t number_of_columns = 0;
+  /// Number of rows.
+  std::size_t number_of_rows = 0;
+
+  /// Get the q type id of a column.
+  int GetColumnQTypeId(std::size_t column_index) const {
+    return kdb_wrapper::GetQTypeId(this->columns[column_index]);
+  }
+
+  /// Get the elements of a column as T*, like accessors::GetVector. There is
+  /// no check of the type, check GetColumnQTypeId first.
+  template <typename T>
+  const T* GetColumn(std::size_t column_index) const {
+    return accessors::GetVector<T>(this->columns[column_index]);
+  }
+};
+
+/// Function called with each update of a table.
+using UpdateCallback = std::function<void(const TableUpdate& update)>;
+
+/// Number of buckets in the latency histogram.
+constexpr int number_of_latency_buckets = 40;
+
+/// Statistics of a subscriber.
+struct SubscriberStatistics {
+  /// Number of messages read.
+  std::uint64_t number_of_messages = 0;
+  /// Number of updates passed to callbacks.
+  std::uint64_t number_of_updates = 0;
+  /// Seconds since the first message is read.
+  double elapsed_seconds = 0;
+  /// Messages read per second.
+  double messages_per_second = 0;
+  /// Histogram of the time from reading a message to calling the callback.
+  /// Bucket i counts the latencies in [2^i, 2^(i+1)) nanoseconds, and bucket 0
+  /// also counts 0.
+  std::array<std::uint64_t, number_of_latency_buckets>
+      decode_latency_histogram = {};
+};
+
+/// Get the latency under which the given fraction of the messages are
+/// decoded, as the upper bound of the bucket in nanoseconds.
+std::uint64_t GetLatencyPercentile(
+    /// [in] Statistics.
+    const SubscriberStatistics& statistics,
+    /// Fraction, between 0 and 1.
+    double fraction);
+
+/// Subscriber of a tickerplant.
+///
+/// Callbacks are set first, then Subscribe is called, and then Run or
+/// ProcessMessage is called to read the messages. All are called on the same
+/// thread, except Stop and GetStatistics.
+///
+/// The connection is not owned, and is used only by the subscriber.
+class Subscriber {
+ public:
+  /// Create on a handle returned by kdb_wrapper::OpenConnection.
+  explicit Subscriber(int connection);
+  /// Default constructor is deleted.
+  Subscriber() = delete;
+  /// Copy constructor is deleted.
+  Subscriber(const Subscriber&) = delete;
+  /// assignment operator is deleted.
+  Subscriber& operator=(const Subscriber&) = delete;
+
+  /// Set the callback for updates of a table, replacing the one set before.
+  void SetCallback(
+      /// Table name.
+      const char* table,
+      /// Called with each update of the table.
+      UpdateCallback callback);
+
+  /// Subscribe by calling .u.sub on the tickerplant.
+  SubscriptionResult Subscribe(
+      /// Table name, "" for all the tables.
+      const std::string& table,
+      /// Symbols, empty for all the symbols.
+      const std::vector<std::string>& symbols);
+
+  /// Block for the next message, and call the callback if it's an update.
+  SubscriptionResult ProcessMessage();
+
+  /// Process messages until the connection is lost or Stop is called.
+  ///
+  /// Stop only takes effect after the next message is read.
+  SubscriptionResult Run();
+
+  /// Ask Run to return, can be called from any thread.
+  void Stop();
+
+  /// Get the statistics, can be called from any thread.
+  SubscriberStatistics GetStatistics() const;
+
+ private:
+  /// Callback of a table, found by comparing the interned symbols.
+  struct TableCallback {
+    char* table;
+    UpdateCallback callback;
+  };
+
+  /// Find the callback of the table. nullptr if not found.
+  const UpdateCallback* FindCallback(const char* table) const;
+
+  /// Decode the message and call the callback.
+  SubscriptionResult DispatchMessage(
+      void* message, std::chrono::steady_clock::time_point read_time);
+
+  /// Record the latency in the histogram.
+  void RecordLatency(std::chrono::nanoseconds latency);
+
+  int connection;
+  /// Interned `upd.
+  char* upd_symbol;
+  std::vector<TableCallback> table_callbacks;
+  std::atomic<bool> is_stopping;
+
+  // Written only by the thread reading messages.
+  std::atomic<std::uint64_t> number_of_messages;
+  std::atomic<std::uint64_t> number_of_updates;
+  std::atomic<std::int64_t> first_message_time;
+  std::array<std::atomic<std::uint64_t>, number_of_latency_buckets>
+      decode_latency_histogram;
+};
+}  // namespace cpp2kdb::tickerplant_subscriber
+#endif  // CPP2KDB_TICKERPLANT_SUBSCRIBER_H__
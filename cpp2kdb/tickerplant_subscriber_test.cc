@@ -0,0 +1,115 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/tickerplant_subscriber.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace {
+/// Definitions on the server standing in for a tickerplant: .u.sub checks the
+/// symbols are ` or a symbol list as .u.sub of u.q expects, remembers them and
+/// the handle of the subscriber, and publish sends n updates of trade to it,
+/// then a single row of trade as a list of atoms, and an update of quote.
+constexpr const char* tickerplant_definitions =
+    "trade:([] sym:`symbol$(); price:`float$(); size:`long$());"
+    ".u.sub:{[t;s] if[not (s~`) or 11h=type s; 'type]; .test.symbols:s; "
+    ".test.subscriber:.z.w; (t; trade)};"
+    ".test.publish:{[n] {neg[.test.subscriber] (`upd; `trade; "
+    "([] sym:`a`b; price:x+1 2f; size:100 200))} each til n; "
+    "neg[.test.subscriber] (`upd; `trade; (`a; 1f; 300));"
+    "neg[.test.subscriber] (`upd; `quote; ([] sym:enlist `a))}";
+
+constexpr int number_of_updates = 10000;
+}  // namespace
+
+int main(int argc, char** argv) {
+  // One connection for the subscriber, another one to trigger the publishing.
+  int connection = cpp2kdb::kdb_wrapper::OpenConnection("127.0.0.1", 5000, "");
+  int publisher = cpp2kdb::kdb_wrapper::OpenConnection("127.0.0.1", 5000, "");
+  if (connection <= 0 || publisher <= 0) {
+    std::cerr << "Connection error: " << connection << " " << publisher
+              << std::endl;
+    return 1;
+  }
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard definitions_guard(
+      cpp2kdb::kdb_wrapper::RunQueryOnConnection(publisher,
+                                                 tickerplant_definitions));
+
+  cpp2kdb::tickerplant_subscriber::Subscriber subscriber(connection);
+  double total_price = 0;
+  std::int64_t total_size = 0;
+  std::size_t last_number_of_rows = 0;
+  subscriber.SetCallback(
+      "trade",
+      [&total_price, &total_size, &last_number_of_rows](
+          const cpp2kdb::tickerplant_subscriber::TableUpdate& update) {
+        last_number_of_rows = update.number_of_rows;
+        if (update.GetColumnQTypeId(1) < 0) {
+          // A single row, as a list of atoms.
+          total_price +=
+              cpp2kdb::accessors::GetValue<double>(update.columns[1]);
+          total_size +=
+              cpp2kdb::accessors::GetValue<std::int64_t>(update.columns[2]);
+          return;
+        }
+        const double* price = update.GetColumn<double>(1);
+        const std::int64_t* size = update.GetColumn<std::int64_t>(2);
+        for (std::size_t i = 0; i < update.number_of_rows; i++) {
+          total_price += price[i];
+          total_size += size[i];
+        }
+      });
+  std::cout << "Subscribe with one symbol: "
+            << subscriber.Subscribe("trade", {"a"}) << std::endl;
+  std::cout << "Subscribe with all symbols: "
+            << subscriber.Subscribe("trade", {}) << std::endl;
+  std::cout << "Subscribe with two symbols: "
+            << subscriber.Subscribe("trade", {"a", "b"}) << std::endl;
+  void* symbols =
+      cpp2kdb::kdb_wrapper::RunQueryOnConnection(publisher, ".test.symbols");
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard symbols_guard(symbols);
+  std::cout << "Symbols subscribed: "
+            << cpp2kdb::kdb_wrapper::GetNumberOfVectorElements(symbols)
+            << ", type " << cpp2kdb::kdb_wrapper::GetQTypeId(symbols)
+            << std::endl;
+
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard publish_guard(
+      cpp2kdb::kdb_wrapper::RunQueryOnConnection(
+          publisher,
+          (".test.publish " + std::to_string(number_of_updates)).c_str()));
+  for (int i = 0; i < number_of_updates; i++) {
+    subscriber.ProcessMessage();
+  }
+  std::cout << "Update of a single row: " << subscriber.ProcessMessage()
+            << ", " << last_number_of_rows << " row" << std::endl;
+  // No callback for quote.
+  std::cout << "Update of quote: " << subscriber.ProcessMessage() << std::endl;
+
+  std::cout << "Total size: " << total_size << ", expected "
+            << 300 * number_of_updates + 300 << std::endl;
+  std::cout << "Total price: " << total_price << std::endl;
+
+  cpp2kdb::tickerplant_subscriber::SubscriberStatistics statistics =
+      subscriber.GetStatistics();
+  std::cout << "Messages: " << statistics.number_of_messages
+            << ", updates: " << statistics.number_of_updates
+            << ", messages per second: " << statistics.messages_per_second
+            << std::endl;
+  std::cout << "Decode latency p50: "
+            << cpp2kdb::tickerplant_subscriber::GetLatencyPercentile(statistics,
+                                                                     0.5)
+            << "ns, p99: "
+            << cpp2kdb::tickerplant_subscriber::GetLatencyPercentile(statistics,
+                                                                     0.99)
+            << "ns" << std::endl;
+
+  cpp2kdb::kdb_wrapper::CloseConnection(publisher);
+  cpp2kdb::kdb_wrapper::CloseConnection(connection);
+  return 0;
+}
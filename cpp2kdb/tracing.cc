@@ -0,0 +1,174 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/tracing.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cpp2kdb::tracing {
+namespace {
+/// Interceptors added at some point, with the call hooks calling them.
+///
+/// hooks is the first member, so the CallHooks passed back in CallInfo is cast
+/// to the InterceptorSet holding it.
+struct InterceptorSet {
+  kdb_wrapper::CallHooks hooks;
+  std::vector<Interceptor*> interceptors;
+};
+static_assert(std::is_standard_layout_v<InterceptorSet>,
+              "InterceptorSet must be standard layout");
+
+/// Guards interceptor_sets.
+std::mutex interceptor_sets_mutex;
+
+/// Every set ever installed, since calls started with an old set may still
+/// run. The last one is the current set.
+std::vector<std::unique_ptr<InterceptorSet>> interceptor_sets;
+
+/// Whether an interceptor is running on this thread.
+thread_local bool is_intercepting = false;
+
+/// Marks hook_data of a call not intercepted.
+constexpr long long not_intercepted = -1;  // NOLINT
+
+/// Nanoseconds of the steady clock.
+long long GetNanoseconds() {  // NOLINT
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/// Build the event of a call.
+CallEvent MakeCallEvent(const kdb_wrapper::CallInfo& info,
+                        std::chrono::nanoseconds duration) {
+  return CallEvent{info.kind,
+                   info.function,
+                   info.connection,
+                   info.query,
+                   duration,
+                   info.object,
+                   info.object == nullptr
+                       ? 0
+                       : kdb_wrapper::GetQTypeId(info.object)};
+}
+
+void BeforeCall(kdb_wrapper::CallInfo* info) {
+  if (is_intercepting) {
+    info->hook_data = not_intercepted;
+    return;
+  }
+  const InterceptorSet* set =
+      reinterpret_cast<const InterceptorSet*>(info->hooks);
+  is_intercepting = true;
+  CallEvent event = MakeCallEvent(*info, std::chrono::nanoseconds(0));
+  for (Interceptor* interceptor : set->interceptors) {
+    interceptor->OnBefore(event);
+  }
+  is_intercepting = false;
+  // Start the clock after the interceptors, so they are not timed.
+  info->hook_data = GetNanoseconds();
+}
+
+void AfterCall(kdb_wrapper::CallInfo* info) {
+  if (info->hook_data == not_intercepted) {
+    return;
+  }
+  std::chrono::nanoseconds duration(GetNanoseconds() - info->hook_data);
+  const InterceptorSet* set =
+      reinterpret_cast<const InterceptorSet*>(info->hooks);
+  is_intercepting = true;
+  CallEvent event = MakeCallEvent(*info, duration);
+  for (auto it = set->interceptors.rbegin(); it != set->interceptors.rend();
+       ++it) {
+    (*it)->OnAfter(event);
+  }
+  is_intercepting = false;
+}
+
+/// Install a set with the interceptors, or remove the hooks if there are
+/// none. interceptor_sets_mutex must be held.
+void InstallInterceptors(std::vector<Interceptor*> interceptors) {
+  auto set = std::make_unique<InterceptorSet>();
+  set->hooks = kdb_wrapper::CallHooks{BeforeCall, AfterCall};
+  set->interceptors = std::move(interceptors);
+  kdb_wrapper::SetCallHooks(set->interceptors.empty() ? nullptr : &set->hooks);
+  interceptor_sets.push_back(std::move(set));
+}
+
+/// Get the interceptors currently installed. interceptor_sets_mutex must be
+/// held.
+std::vector<Interceptor*> GetInterceptors() {
+  if (interceptor_sets.empty()) {
+    return {};
+  }
+  return interceptor_sets.back()->interceptors;
+}
+}  // namespace
+
+const char* GetCallKindName(kdb_wrapper::CallKind kind) {
+  int index = static_cast<int>(kind);
+  if (index < 0 || index >= number_of_call_kind_names) {
+    return "Invalid";
+  }
+  return CallKindNames[index];
+}
+
+void Interceptor::OnBefore(const CallEvent&) {
+  // do nothing here
+}
+
+void Interceptor::OnAfter(const CallEvent&) {
+  // do nothing here
+}
+
+void AddInterceptor(Interceptor* interceptor) {
+  std::lock_guard<std::mutex> lock(interceptor_sets_mutex);
+  std::vector<Interceptor*> interceptors = GetInterceptors();
+  if (std::find(interceptors.begin(), interceptors.end(), interceptor) !=
+      interceptors.end()) {
+    return;
+  }
+  interceptors.push_back(interceptor);
+  InstallInterceptors(std::move(interceptors));
+}
+
+void RemoveInterceptor(Interceptor* interceptor) {
+  std::lock_guard<std::mutex> lock(interceptor_sets_mutex);
+  std::vector<Interceptor*> interceptors = GetInterceptors();
+  auto it = std::find(interceptors.begin(), interceptors.end(), interceptor);
+  if (it == interceptors.end()) {
+    return;
+  }
+  interceptors.erase(it);
+  InstallInterceptors(std::move(interceptors));
+}
+
+SlowCallInterceptor::SlowCallInterceptor(
+    std::chrono::nanoseconds threshold, std::string pattern,
+    std::function<void(const CallEvent& event)> callback)
+    : threshold(threshold),
+      pattern(std::move(pattern)),
+      callback(std::move(callback)) {
+  // do nothing here
+}
+
+void SlowCallInterceptor::OnAfter(const CallEvent& event) {
+  if (event.duration < this->threshold) {
+    return;
+  }
+  if (!this->pattern.empty() &&
+      (event.query == nullptr ||
+       std::string_view(event.query).find(this->pattern) ==
+           std::string_view::npos)) {
+    return;
+  }
+  this->callback(event);
+}
+}  // namespace cpp2kdb::tracing
@@ -0,0 +1,111 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_TRACING_H__
+#define CPP2KDB_TRACING_H__
+/// \file cpp2kdb/tracing.h
+/// Interceptors called before and after the calls reported by kdb_wrapper and
+/// accessors.
+///
+/// The interceptors are called from the call hooks of kdb_wrapper, which are
+/// set while at least one interceptor is added and removed after the last one
+/// is removed, so no interceptor costs one pointer load per call.
+
+#include <chrono>
+#include <functional>
+#include <string>
+
+#include "cpp2kdb/kdb_wrapper.h"
+
+/// Interceptors of the calls to kdb.
+namespace cpp2kdb::tracing {
+/// Names of kdb_wrapper::CallKind.
+constexpr const char* CallKindNames[] = {"OpenConnection", "CloseConnection",
+                                         "Query", "Conversion"};
+
+/// Number of call kind names.
+constexpr const int number_of_call_kind_names =
+    sizeof(CallKindNames) / sizeof(CallKindNames[0]);
+
+/// Get the name of a call kind.
+const char* GetCallKindName(kdb_wrapper::CallKind kind);
+
+/// A call passed to the interceptors.
+struct CallEvent {
+  /// Kind of the call.
+  kdb_wrapper::CallKind kind;
+  /// Name of the function called, such as "RunQueryOnConnection".
+  const char* function;
+  /// Handle. For OpenConnection, this is the value returned after the call.
+  /// 0 for conversions.
+  int connection;
+  /// Query for RunQueryOnConnection, host for OpenConnection, nullptr
+  /// otherwise.
+  const char* query;
+  /// Time taken by the call, 0 before the call.
+  std::chrono::nanoseconds duration;
+  /// K object returned by RunQueryOnConnection after the call, or K object
+  /// converted. nullptr otherwise, including when a query fails.
+  void* object;
+  /// Q type id of object, 0 if object is nullptr.
+  int q_type_id;
+};
+
+/// Interceptor of the calls.
+///
+/// Interceptors are called on the thread making the call, and must be thread
+/// safe if calls are made on more than one thread. Calls made by the
+/// interceptors themselves are not intercepted.
+class Interceptor {
+ public:
+  /// Virtual destructor.
+  virtual ~Interceptor() = default;
+  /// Called before the call, with duration 0. Does nothing by default.
+  virtual void OnBefore(const CallEvent& event);
+  /// Called after the call. Does nothing by default.
+  virtual void OnAfter(const CallEvent& event);
+};
+
+/// Add an interceptor, which is not owned. Adding the same interceptor twice
+/// does nothing.
+///
+/// Interceptors are called in the order they are added before the calls, and
+/// in the reverse order after. A call only goes to the interceptors added when
+/// it starts.
+void AddInterceptor(Interceptor* interceptor);
+
+/// Remove an interceptor. It can still be called by the calls started before
+/// it is removed, so it must outlive them.
+void RemoveInterceptor(Interceptor* interceptor);
+
+/// Interceptor passing the calls slower than a threshold to a callback,
+/// optionally only the ones whose query contains a pattern.
+class SlowCallInterceptor : public Interceptor {
+ public:
+  /// Create SlowCallInterceptor.
+  SlowCallInterceptor(
+      /// Calls taking at least threshold are passed to the callback.
+      std::chrono::nanoseconds threshold,
+      /// Only calls whose query contains pattern are passed to the callback.
+      /// Empty for all the calls.
+      std::string pattern,
+      /// Callback, called after the call.
+      std::function<void(const CallEvent& event)> callback);
+  /// Default constructor is deleted.
+  SlowCallInterceptor() = delete;
+  /// Copy constructor is deleted.
+  SlowCallInterceptor(const SlowCallInterceptor&) = delete;
+  /// assignment operator is deleted.
+  SlowCallInterceptor& operator=(const SlowCallInterceptor&) = delete;
+
+  /// Pass the call to the callback if it is slow and matches the pattern.
+  void OnAfter(const CallEvent& event) override;
+
+ private:
+  std::chrono::nanoseconds threshold;
+  std::string pattern;
+  std::function<void(const CallEvent& event)> callback;
+};
+}  // namespace cpp2kdb::tracing
+#endif  // CPP2KDB_TRACING_H__
@@ -0,0 +1,94 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/tracing.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+namespace {
+/// Print every call.
+class PrintingInterceptor : public cpp2kdb::tracing::Interceptor {
+ public:
+  void OnBefore(const cpp2kdb::tracing::CallEvent& event) override {
+    std::cout << "Before " << event.function << " ("
+              << cpp2kdb::tracing::GetCallKindName(event.kind) << ")"
+              << std::endl;
+  }
+  void OnAfter(const cpp2kdb::tracing::CallEvent& event) override {
+    std::cout << "After " << event.function << " on handle "
+              << event.connection << ", query "
+              << (event.query == nullptr ? "none" : event.query)
+              << ", q type id " << event.q_type_id << std::endl;
+    // Calls made here are not intercepted.
+    if (event.kind == cpp2kdb::kdb_wrapper::CallKind::Conversion) {
+      std::vector<std::int64_t> copy(
+          cpp2kdb::kdb_wrapper::GetNumberOfVectorElements(event.object));
+      cpp2kdb::accessors::RetrieveVectorData(event.object, copy.data());
+    }
+  }
+};
+
+// No connection is needed for conversions.
+void TestConversions() {
+  void* vector =
+      cpp2kdb::kdb_wrapper::CreateVector(cpp2kdb::q_types::q_long_type_id, 10);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guard(vector);
+  std::vector<std::int64_t> output(10);
+
+  PrintingInterceptor interceptor;
+  cpp2kdb::tracing::AddInterceptor(&interceptor);
+  // Added twice, called once.
+  cpp2kdb::tracing::AddInterceptor(&interceptor);
+  cpp2kdb::accessors::RetrieveVectorData(vector, output.data());
+  cpp2kdb::tracing::RemoveInterceptor(&interceptor);
+  cpp2kdb::accessors::RetrieveVectorData(vector, output.data());
+  std::cout << "Hooks removed with the last interceptor? "
+            << (cpp2kdb::kdb_wrapper::GetCallHooks() == nullptr ? "Yes"
+                                                                : "No")
+            << std::endl;
+}
+
+void TestSlowQueries() {
+  cpp2kdb::tracing::SlowCallInterceptor interceptor(
+      std::chrono::milliseconds(50), "sleep",
+      [](const cpp2kdb::tracing::CallEvent& event) {
+        std::cout << "Slow query: " << event.query << " took "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(
+                         event.duration)
+                         .count()
+                  << "ms" << std::endl;
+      });
+  PrintingInterceptor printing_interceptor;
+  cpp2kdb::tracing::AddInterceptor(&printing_interceptor);
+  cpp2kdb::tracing::AddInterceptor(&interceptor);
+
+  int connection = cpp2kdb::kdb_wrapper::OpenConnection("127.0.0.1", 5000, "");
+  if (connection <= 0) {
+    std::cerr << "Connection error: " << connection << std::endl;
+  } else {
+    for (const char* query : {"til 10", "system \"sleep 0.1\"", "1+`a"}) {
+      void* result =
+          cpp2kdb::kdb_wrapper::RunQueryOnConnection(connection, query);
+      cpp2kdb::kdb_wrapper::DecreaseReferenceCount(result);
+    }
+    cpp2kdb::kdb_wrapper::CloseConnection(connection);
+  }
+
+  cpp2kdb::tracing::RemoveInterceptor(&interceptor);
+  cpp2kdb::tracing::RemoveInterceptor(&printing_interceptor);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  TestConversions();
+  std::cout << "----------------------" << std::endl;
+  TestSlowQueries();
+  return 0;
+}
@@ -0,0 +1,162 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#ifndef CPP2KDB_VECTOR_VIEW_H__
+#define CPP2KDB_VECTOR_VIEW_H__
+/// \file cpp2kdb/vector_view.h
+/// Typed views over the data of K vectors, without copying.
+///
+/// RetrieveVectorData copies a vector into memory owned by the caller. When
+/// the C type has the same layout as the q type, the data can be read in place
+/// instead. The view holds a reference to the K object, so the data stays
+/// valid as long as the view does.
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+#include "cpp2kdb/q_types.h"
+
+/// Views over K vectors.
+namespace cpp2kdb::vector_view {
+/// Check if the data of a vector of q_type_id can be read as T in place.
+///
+/// This is q_types::IsSameType, except for std::string, since neither symbols
+/// nor char vectors are laid out as std::string. Temporal types are read as
+/// their underlying int, std::int64_t or double.
+template <typename T>
+constexpr bool IsViewableAs(
+    /// Q type id of the vector.
+    int q_type_id) {
+  return (std::is_arithmetic_v<T> || std::is_same_v<T, q_types::QGuid>) &&
+         q_type_id > 0 && q_types::IsSameType<T>(q_type_id);
+}
+
+/// Read only view over the elements of a K vector of T.
+///
+/// The view is type checked once when created by MakeKVectorView, and holds a
+/// reference to the K object, released when the view is destructed. The view
+/// can be moved but not copied, since kdb's reference counts are not atomic
+/// and an implicit copy would easily race between threads.
+template <typename T>
+class KVectorView {
+ public:
+  /// Type of the elements.
+  using value_type = T;
+  /// Iterator, which is a pointer into the K object.
+  using const_iterator = const T*;
+
+  /// Create an empty view.
+  KVectorView()
+      : object(nullptr), data_pointer(nullptr), number_of_elements(0) {
+    // do nothing here
+  }
+  /// Copy constructor is deleted.
+  KVectorView(const KVectorView&) = delete;
+  /// assignment operator is deleted.
+  KVectorView& operator=(const KVectorView&) = delete;
+  /// Move constructor, leaving other empty.
+  KVectorView(KVectorView&& other) noexcept
+      : object(std::exchange(other.object, nullptr)),
+        data_pointer(std::exchange(other.data_pointer, nullptr)),
+        number_of_elements(std::exchange(other.number_of_elements, 0)) {
+    // do nothing here
+  }
+  /// Move assignment, releasing the object viewed and leaving other empty.
+  KVectorView& operator=(KVectorView&& other) noexcept {
+    if (this != &other) {
+      this->Release();
+      this->object = std::exchange(other.object, nullptr);
+      this->data_pointer = std::exchange(other.data_pointer, nullptr);
+      this->number_of_elements = std::exchange(other.number_of_elements, 0);
+    }
+    return *this;
+  }
+  /// Destructor, releasing the reference to the object.
+  ~KVectorView() { this->Release(); }
+
+  /// Number of elements.
+  std::size_t size() const { return this->number_of_elements; }
+  /// Whether there are no elements.
+  bool empty() const { return this->number_of_elements == 0; }
+  /// Pointer to the first element.
+  const T* data() const { return this->data_pointer; }
+  /// Element i, not checked.
+  const T& operator[](std::size_t i) const { return this->data_pointer[i]; }
+  /// Iterator to the first element.
+  const_iterator begin() const { return this->data_pointer; }
+  /// Iterator past the last element.
+  const_iterator end() const {
+    return this->data_pointer + this->number_of_elements;
+  }
+  /// K object viewed, nullptr for an empty view. The reference stays with the
+  /// view.
+  void* GetObject() const { return this->object; }
+
+  /// Release the reference to the object and make the view empty.
+  void Release() {
+    if (this->object != nullptr) {
+      kdb_wrapper::DecreaseReferenceCount(this->object);
+    }
+    this->object = nullptr;
+    this->data_pointer = nullptr;
+    this->number_of_elements = 0;
+  }
+
+ private:
+  template <typename U>
+  friend accessors::DataRetrievalResult MakeKVectorView(void* input_vector,
+                                                        KVectorView<U>* view);
+
+  void* object;
+  const T* data_pointer;
+  std::size_t number_of_elements;
+};
+
+/// Create a view over a K vector.
+///
+/// The q type id of the vector is checked against T with IsViewableAs. On
+/// success, the view takes a new reference to the vector, so the caller keeps
+/// its own.
+/// \returns NotNumericalVector for mixed lists and symbol vectors,
+///          NotGuidVector if T is QGuid and the vector is not a guid vector,
+///          InvalidQTypeId if T doesn't match the q type id. The view is left
+///          unchanged when the result is not Ok.
+template <typename T>
+accessors::DataRetrievalResult MakeKVectorView(
+    /// [in] input vector.
+    void* input_vector,
+    /// [out] view.
+    KVectorView<T>* view) {
+  static_assert(std::is_arithmetic_v<T> || std::is_same_v<T, q_types::QGuid>,
+                "KVectorView only supports arithmetic types and QGuid");
+  accessors::DataRetrievalResult check_vector_result =
+      accessors::CheckVectorForVectorDataRetrieval(input_vector);
+  if (check_vector_result != accessors::DataRetrievalResult::Ok) {
+    return check_vector_result;
+  }
+  int q_type_id = kdb_wrapper::GetQTypeId(input_vector);
+  if (q_types::IsQTypeIdMixedVector(q_type_id) ||
+      q_type_id == q_types::q_symbol_type_id) {
+    return accessors::DataRetrievalResult::NotNumericalVector;
+  }
+  if (!IsViewableAs<T>(q_type_id)) {
+    if constexpr (std::is_same_v<T, q_types::QGuid>) {
+      return accessors::DataRetrievalResult::NotGuidVector;
+    } else {
+      return accessors::DataRetrievalResult::InvalidQTypeId;
+    }
+  }
+
+  view->Release();
+  view->object = kdb_wrapper::IncreaseReferenceCount(input_vector);
+  view->data_pointer = accessors::GetVector<T>(input_vector);
+  view->number_of_elements =
+      kdb_wrapper::GetNumberOfVectorElements(input_vector);
+  return accessors::DataRetrievalResult::Ok;
+}
+}  // namespace cpp2kdb::vector_view
+#endif  // CPP2KDB_VECTOR_VIEW_H__
@@ -0,0 +1,88 @@
+// Copyright (C) 2021, Chao Xu
+//
+// Part of cpp2kdb, which is released under BSD license. See LICENSE for full
+// details.
+#include "cpp2kdb/vector_view.h"
+
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "cpp2kdb/accessors.h"
+#include "cpp2kdb/kdb_wrapper.h"
+
+// Vectors are built in process, no connection is needed.
+namespace {
+void TestView() {
+  void* vector = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_long_type_id, 1000);
+  std::int64_t* data = cpp2kdb::accessors::GetVector<std::int64_t>(vector);
+  std::iota(data, data + 1000, 0);
+
+  cpp2kdb::vector_view::KVectorView<std::int64_t> view;
+  std::cout << "Long vector as int64_t: "
+            << cpp2kdb::vector_view::MakeKVectorView(vector, &view)
+            << std::endl;
+  // The view has its own reference.
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCount(vector);
+  std::cout << "Sum of " << view.size() << " elements: "
+            << std::accumulate(view.begin(), view.end(), std::int64_t{0})
+            << ", view[999] = " << view[999] << std::endl;
+  std::cout << "Data is not copied? " << (view.data() == data ? "Yes" : "No")
+            << std::endl;
+
+  cpp2kdb::vector_view::KVectorView<std::int64_t> moved = std::move(view);
+  std::cout << "After move, sizes are " << view.size() << " and "
+            << moved.size() << std::endl;
+
+  cpp2kdb::vector_view::KVectorView<double> wrong_type;
+  std::cout << "Long vector as double: "
+            << cpp2kdb::vector_view::MakeKVectorView(moved.GetObject(),
+                                                     &wrong_type)
+            << std::endl;
+}
+
+void TestTypes() {
+  void* timestamps = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_timestamp_type_id, 10);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard timestamps_guard(
+      timestamps);
+  cpp2kdb::vector_view::KVectorView<std::int64_t> timestamp_view;
+  std::cout << "Timestamp vector as int64_t: "
+            << cpp2kdb::vector_view::MakeKVectorView(timestamps,
+                                                     &timestamp_view)
+            << std::endl;
+
+  void* symbols = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_symbol_type_id, 0);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard symbols_guard(symbols);
+  cpp2kdb::vector_view::KVectorView<char> symbol_view;
+  std::cout << "Symbol vector as char: "
+            << cpp2kdb::vector_view::MakeKVectorView(symbols, &symbol_view)
+            << std::endl;
+
+  void* atom = cpp2kdb::kdb_wrapper::CreateLong(1);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard atom_guard(atom);
+  cpp2kdb::vector_view::KVectorView<std::int64_t> atom_view;
+  std::cout << "Long atom as int64_t: "
+            << cpp2kdb::vector_view::MakeKVectorView(atom, &atom_view)
+            << std::endl;
+
+  void* guids = cpp2kdb::kdb_wrapper::CreateVector(
+      cpp2kdb::q_types::q_guid_type_id, 3);
+  cpp2kdb::kdb_wrapper::DecreaseReferenceCountGuard guids_guard(guids);
+  cpp2kdb::vector_view::KVectorView<cpp2kdb::q_types::QGuid> guid_view;
+  std::cout << "Guid vector as QGuid: "
+            << cpp2kdb::vector_view::MakeKVectorView(guids, &guid_view)
+            << ", " << guid_view.size() << " elements" << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  TestView();
+  std::cout << "----------------------" << std::endl;
+  TestTypes();
+  return 0;
+}